@@ -0,0 +1,103 @@
+// bench/compression_bench.cpp
+// 响应压缩的CPU与字节数权衡：对典型JSON-RPC响应体测量各编码/级别的压缩耗时与压缩率，
+// 并给出盈亏平衡带宽——链路慢于该带宽时，压缩节省的传输时间大于其CPU开销
+#include "framework/compression.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// 构造形如successBody的响应：result为records条记录组成的数组
+static std::string makeResponse(int records) {
+    std::string body = "{\"id\":1,\"jsonrpc\":\"2.0\",\"result\":[";
+    char item[160];
+    for (int i = 0; i < records; ++i) {
+        snprintf(item, sizeof(item),
+                 "%s{\"id\":%d,\"name\":\"item-%d\",\"price\":%.2f,\"stock\":%d,\"tags\":[\"sale\",\"zone-%d\"]}",
+                 i ? "," : "", 100000 + i, i, 9.99 + i * 0.37, (i * 7919) % 1000, i % 8);
+        body += item;
+    }
+    body += "]}";
+    return body;
+}
+
+// 每次新建并释放z_stream，作为复用上下文的对照
+static bool gzipFreshContext(int level, const std::string& input, std::string& output) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    output.resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    const bool ok = deflate(&stream, Z_FINISH) == Z_STREAM_END;
+    output.resize(output.size() - stream.avail_out);
+    deflateEnd(&stream);
+    return ok;
+}
+
+struct Variant {
+    const char* label;
+    ContentCoding coding;
+    int level;
+    bool freshContext;
+};
+
+// 反复压缩直到累计耗时超过200ms，返回单次耗时（纳秒）
+static double measure(const Variant& variant, const std::string& input, std::string& output) {
+    ResponseCompressor& compressor = ResponseCompressor::forThread();
+    const StringRef ref(input);
+    long iterations = 0;
+    const auto start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration elapsed;
+    do {
+        for (int i = 0; i < 16; ++i) {
+            if (variant.freshContext) {
+                gzipFreshContext(variant.level, input, output);
+            } else {
+                compressor.compress(variant.coding, variant.level, ref, output);
+            }
+        }
+        iterations += 16;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(200));
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+int main() {
+    const Variant variants[] = {
+        {"gzip-1",            CODING_GZIP, 1, false},
+        {"gzip-6",            CODING_GZIP, 6, false},
+        {"gzip-6 (fresh ctx)", CODING_GZIP, 6, true},
+        {"gzip-9",            CODING_GZIP, 9, false},
+#ifdef RPC_HAVE_ZSTD
+        {"zstd-1",            CODING_ZSTD, 1, false},
+        {"zstd-3",            CODING_ZSTD, 3, false},
+        {"zstd-9",            CODING_ZSTD, 9, false},
+#endif
+    };
+    const int payloads[] = {8, 64, 512, 4096};
+
+    printf("%-20s %9s %9s %7s %10s %9s %12s\n",
+           "coding", "in(B)", "out(B)", "ratio", "us/resp", "MB/s", "break-even");
+    std::string output;
+    for (size_t p = 0; p < sizeof(payloads) / sizeof(payloads[0]); ++p) {
+        const std::string input = makeResponse(payloads[p]);
+        for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); ++v) {
+            const double ns = measure(variants[v], input, output);
+            const double saved = static_cast<double>(input.size()) - static_cast<double>(output.size());
+            // 节省的字节数除以压缩耗时：链路带宽低于此值时压缩划算
+            const double breakEvenMbps = saved * 8 / ns * 1000;
+            printf("%-20s %9zu %9zu %6.2fx %10.2f %9.1f %8.0f Mb/s\n",
+                   variants[v].label, input.size(), output.size(),
+                   static_cast<double>(input.size()) / output.size(), ns / 1000,
+                   input.size() / ns * 1000, breakEvenMbps);
+        }
+        printf("\n");
+    }
+    return 0;
+}
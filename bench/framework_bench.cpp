@@ -0,0 +1,213 @@
+// bench/framework_bench.cpp
+// 请求路径上各环节的微基准：每项报告单次耗时（ns/op）与堆分配次数（allocs/op），
+// 优化前后各跑一次即可看出回退。分配次数由本文件替换的全局operator new统计，
+// 计入标准库容器与nlohmann::json内部的全部分配
+#include "framework/http_parser.h"
+#include "framework/ioc_container.h"
+#include "framework/rpc_server.h"
+#include "services/math_service.h"
+#include "mem_mgmt/safe_ptr.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::atomic<uint64_t> allocations(0);
+
+// 不内联：否则GCC把内联后的free与new配对检查，误报-Wmismatched-new-delete
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    free(p);
+}
+
+namespace {
+
+// 阻止编译器把结果未被使用的计算整个删掉
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+struct Result {
+    double ns;
+    double allocs;
+};
+
+// 先预热，再反复执行直到累计耗时超过200ms
+template <typename F>
+Result measure(F body) {
+    for (int i = 0; i < 64; ++i) {
+        body();
+    }
+    long iterations = 0;
+    const uint64_t allocationsBefore = allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration elapsed;
+    do {
+        for (int i = 0; i < 64; ++i) {
+            body();
+        }
+        iterations += 64;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(200));
+    Result result;
+    result.ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    result.allocs = static_cast<double>(allocations.load(std::memory_order_relaxed) - allocationsBefore) / iterations;
+    return result;
+}
+
+void report(const char* name, const Result& result) {
+    printf("%-44s %10.1f %10.2f\n", name, result.ns, result.allocs);
+}
+
+// dispatchRequest中服务名的首字母大写规范
+std::string capitalize(std::string name) {
+    if (!name.empty()) {
+        name[0] = toupper(name[0]);
+    }
+    return name;
+}
+
+// 形如{"jsonrpc":"2.0","method":...,"params":{...},"id":1}的请求，params含fields个字段
+std::string makeEnvelope(int fields) {
+    std::string body = "{\"jsonrpc\":\"2.0\",\"method\":\"MathService.add\",\"params\":{\"a\":1,\"b\":2";
+    char field[96];
+    for (int i = 0; i < fields; ++i) {
+        snprintf(field, sizeof(field), ",\"field%d\":\"value-%d\",\"count%d\":%d", i, i * 7919, i, i * 31);
+        body += field;
+    }
+    body += "},\"id\":1}";
+    return body;
+}
+
+struct Payload {
+    int value;
+};
+
+// 多个线程同时从同一个SafePtr拷贝并销毁副本，返回每个线程单次操作的平均耗时；
+// 结束后共享指针的引用计数应回到1
+Result measureSharedCopies(SafePtr<Payload>& shared, unsigned threads, bool& countIntact) {
+    const long perThread = 200000;
+    const uint64_t allocationsBefore = allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.push_back(std::thread([&shared, perThread]() {
+            for (long i = 0; i < perThread; ++i) {
+                SafePtr<Payload> copy;
+                copy = shared;
+                keep(copy.get());
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+    const double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    countIntact = shared.use_count() == 1;
+    Result result;
+    result.ns = elapsedNs * threads / (perThread * threads);
+    result.allocs = static_cast<double>(allocations.load(std::memory_order_relaxed) - allocationsBefore) /
+        (perThread * threads);
+    return result;
+}
+
+} // namespace
+
+int main() {
+    IocContainer::getInstance().registerService<MathService>("MathService");
+
+    printf("%-44s %10s %10s\n", "benchmark", "ns/op", "allocs/op");
+
+    // ========== 请求头与路由 ==========
+    const std::string requestHead =
+        "POST /rpc/MathService/add HTTP/1.1\r\nHost: localhost:8443\r\nContent-Type: application/json\r\n"
+        "Accept-Encoding: gzip\r\nContent-Length: 70\r\n\r\n";
+    report("parseHttpRequest (5 headers)", measure([&requestHead]() {
+        HttpRequest request;
+        keep(parseHttpRequest(requestHead.data(), requestHead.size(), request));
+        keep(request);
+    }));
+    const StringRef target("/rpc/MathService/add", 20);
+    report("parseMethodPath /rpc/MathService/add", measure([&target]() {
+        StringRef service, method;
+        keep(parseMethodPath(target, service, method));
+        keep(method);
+    }));
+
+    // ========== JSON解析 ==========
+    const std::string smallEnvelope = makeEnvelope(0);
+    const std::string largeEnvelope = makeEnvelope(24);
+    char name[64];
+    snprintf(name, sizeof(name), "json::parse envelope (%zuB)", smallEnvelope.size());
+    report(name, measure([&smallEnvelope]() {
+        keep(nlohmann::json::parse(smallEnvelope));
+    }));
+    snprintf(name, sizeof(name), "json::parse envelope (%zuB)", largeEnvelope.size());
+    report(name, measure([&largeEnvelope]() {
+        keep(nlohmann::json::parse(largeEnvelope));
+    }));
+
+    // ========== 方法名解析与服务定位 ==========
+    const std::string qualified = "mathService.add";
+    report("method split + capitalize", measure([&qualified]() {
+        const size_t dotPos = qualified.find('.');
+        const std::string service = capitalize(qualified.substr(0, dotPos));
+        const std::string method = qualified.substr(dotPos + 1);
+        keep(service);
+        keep(method);
+    }));
+    report("IocContainer::getService", measure([]() {
+        auto service = IocContainer::getInstance().getService("MathService");
+        keep(service.get());
+    }));
+
+    // ========== 方法执行 ==========
+    auto service = IocContainer::getInstance().getService("MathService");
+    const nlohmann::json params = nlohmann::json::parse(smallEnvelope)["params"];
+    report("RpcService::executeMethod add", measure([&service, &params]() {
+        keep(service->executeMethod("add", params));
+    }));
+
+    // ========== 响应序列化 ==========
+    const nlohmann::json id = 1;
+    const nlohmann::json smallResult = {{"result", 3.0}};
+    report("RpcServer::successBody (scalar)", measure([&smallResult, &id]() {
+        keep(RpcServer::successBody(smallResult, id));
+    }));
+    nlohmann::json arrayResult = nlohmann::json::array();
+    for (int i = 0; i < 64; ++i) {
+        arrayResult.push_back({{"id", i}, {"name", "item-" + std::to_string(i)}, {"price", 9.99 + i}});
+    }
+    report("RpcServer::successBody (64 objects)", measure([&arrayResult, &id]() {
+        keep(RpcServer::successBody(arrayResult, id));
+    }));
+
+    // ========== SafePtr ==========
+    SafePtr<Payload> shared(new Payload());
+    report("SafePtr copy + destroy (1 thread)", measure([&shared]() {
+        SafePtr<Payload> copy;
+        copy = shared;
+        keep(copy.get());
+    }));
+    bool countIntact = true;
+    report("SafePtr copy + destroy (4 threads, shared)", measureSharedCopies(shared, 4, countIntact));
+    if (!countIntact) {
+        fprintf(stderr, "SafePtr reference count corrupted under contention: %d\n", shared.use_count());
+        return 1;
+    }
+    return 0;
+}
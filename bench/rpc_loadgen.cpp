@@ -0,0 +1,958 @@
+// bench/rpc_loadgen.cpp
+// 开环压测客户端：N条（TLS）长连接按固定速率发出JSON-RPC调用，方法按权重组合，
+// 支持HTTP/1.1与二进制帧协议；结果以JSON输出，摘要打印到stderr。
+//
+// 延迟从每个调用的计划发送时刻算起（校正协同遗漏）：服务端变慢时调用在客户端排队，
+// 排队的时间同样计入延迟，而不是像闭环压测那样随之放慢发送、把停顿从统计中抹去。
+// 另记一份从实际写出时刻算起的延迟作对照，两者相差越大说明排队越严重。
+//
+// 需要运行中的服务端，不随make bench运行，以make loadgen构建。用法:
+//   build/bench/rpc_loadgen -p 8443 -c 16 -r 20000 -d 10
+//   build/bench/rpc_loadgen --plain -p 18080 -r 5000 --batch 8
+//       --call '70,MathService.add,{"a":1,"b":2}' --call '30,MathService.subtract,{"a":3,"b":4}'
+//   build/bench/rpc_loadgen --protocol binary -p 18445 -r 50000 -t 2 --json result.json
+//   build/bench/rpc_loadgen -r 0 --depth 64      # 闭环：每条连接保持depth个未完成调用，测最大吞吐
+#include "framework/binary_connection.h"
+#include "framework/rpc_metrics.h"
+#include <event2/event.h>
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/bufferevent_ssl.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <nlohmann/json.hpp>
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// 调用组合中的一项
+struct CallSpec {
+    unsigned weight;
+    std::string method;
+    std::string params;  // JSON文本
+    std::string request; // 预先编码的完整请求：HTTP请求，或二进制帧（requestId在发送时填入）
+};
+
+struct LoadOptions {
+    std::string host = "127.0.0.1";
+    int port = 8443;
+    bool tls = true;
+    bool binary = false;
+    std::string path = "/api";
+    unsigned connections = 16;
+    unsigned threads = 1;
+    double rate = 1000;     // 所有连接合计的每秒调用数，0表示闭环
+    double duration = 10;   // 统计窗口（秒），不含预热
+    double warmup = 1;
+    unsigned depth = 32;    // 每条连接最多的未完成调用数
+    unsigned batch = 1;     // 连续的batch个调用分到同一连接，以一次写出
+    std::vector<CallSpec> calls;
+    std::string jsonPath = "-";
+};
+
+// 延迟直方图，沿用服务端指标的对数分桶（微秒，相对误差不超过12.5%）
+struct Histogram {
+    std::vector<uint64_t> buckets;
+    uint64_t count;
+    uint64_t sumUs;
+    uint64_t maxUs;
+
+    Histogram() : buckets(LatencyBuckets::kCount), count(0), sumUs(0), maxUs(0) {}
+
+    void add(uint64_t us) {
+        buckets[LatencyBuckets::index(static_cast<uint32_t>(std::min<uint64_t>(us, UINT32_MAX)))]++;
+        ++count;
+        sumUs += us;
+        maxUs = std::max(maxUs, us);
+    }
+    void merge(const Histogram& other) {
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        sumUs += other.sumUs;
+        maxUs = std::max(maxUs, other.maxUs);
+    }
+    // 第q分位所在桶的上界，不超过实测的最大值
+    uint64_t percentile(double q) const {
+        const uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count) + 0.5);
+        uint64_t seen = 0;
+        for (unsigned b = 0; b < buckets.size(); ++b) {
+            seen += buckets[b];
+            if (seen >= rank && seen > 0) {
+                return std::min(LatencyBuckets::upperBound(b), maxUs);
+            }
+        }
+        return maxUs;
+    }
+};
+
+// 单个方法的统计，只计计划发送时刻落在统计窗口内的调用
+struct CallStats {
+    Histogram corrected;   // 自计划发送时刻起
+    Histogram uncorrected; // 自实际写出时刻起，仅作对照
+    uint64_t ok = 0;
+    uint64_t rpcErrors = 0;       // 响应体为JSON-RPC错误
+    uint64_t transportErrors = 0; // HTTP状态非200或二进制帧status非0
+    uint64_t unfinished = 0;      // 结束时仍未收到响应
+
+    void merge(const CallStats& other) {
+        corrected.merge(other.corrected);
+        uncorrected.merge(other.uncorrected);
+        ok += other.ok;
+        rpcErrors += other.rpcErrors;
+        transportErrors += other.transportErrors;
+        unfinished += other.unfinished;
+    }
+};
+
+struct PendingCall {
+    uint64_t intendedNs; // 计划发送时刻
+    uint64_t sentNs;     // 实际写出时刻
+    unsigned call;       // LoadOptions::calls中的下标
+};
+
+class Worker;
+
+// HTTP响应的解析状态
+enum ReadState { READ_HEAD, READ_BODY, READ_CHUNK_SIZE, READ_CHUNK_DATA, READ_TRAILER };
+
+struct Connection {
+    Worker* worker = nullptr;
+    bufferevent* bev = nullptr;
+    SSL_SESSION* session = nullptr; // 重连时恢复TLS会话
+    bool ready = false;             // 已连接（TLS为握手完成）
+    bool closing = false;           // 服务端已声明关闭（Connection: close），不再写入
+    std::deque<PendingCall> queued;   // 已到计划时刻尚未写出，或因重连退回
+    std::deque<PendingCall> inflight; // HTTP响应按请求顺序到达
+    std::unordered_map<uint32_t, PendingCall> framed; // 二进制帧响应按requestId对应
+    uint32_t nextId = 1;
+
+    ReadState state = READ_HEAD;
+    int status = 0;
+    size_t remaining = 0;
+    bool rpcError = false;
+
+    size_t outstanding() const { return inflight.size() + framed.size(); }
+};
+
+// 一个线程的事件循环，驱动分到的连接与速率份额
+class Worker {
+public:
+    Worker(const LoadOptions& options, SSL_CTX* sslCtx, const sockaddr_storage& address, socklen_t addressLength,
+           unsigned connections, double rate);
+    ~Worker();
+
+    void run();
+
+    std::vector<CallStats> stats; // 与options.calls对应
+    uint64_t reconnects = 0;
+    double windowSec = 0;
+    std::string error;
+
+private:
+    bool connect(Connection& conn);
+    void reconnect(Connection& conn);
+    void start();
+    void tick();
+    unsigned pickCall();
+    void issue(uint64_t intendedNs);
+    void flush(Connection& conn, uint64_t now);
+    void readHttp(Connection& conn);
+    void readBinary(Connection& conn);
+    void complete(const PendingCall& pending, bool transportError, bool rpcError);
+    bool drained() const;
+
+    static void readCallback(bufferevent* bev, void* ctx);
+    static void eventCallback(bufferevent* bev, short events, void* ctx);
+    static void timerCallback(evutil_socket_t fd, short events, void* ctx);
+
+    const LoadOptions& options_;
+    SSL_CTX* sslCtx_;
+    sockaddr_storage address_;
+    socklen_t addressLength_;
+    double rate_;
+    event_base* base_;
+    event* timer_;
+    std::vector<Connection> conns_;
+    unsigned totalWeight_;
+    uint64_t random_;
+
+    unsigned connected_ = 0;
+    bool started_ = false;
+    uint64_t startNs_ = 0;   // 开始发送（预热开始）
+    uint64_t measureNs_ = 0; // 统计窗口开始
+    uint64_t endNs_ = 0;     // 停止发送
+    uint64_t issued_ = 0;
+    unsigned cursor_ = 0;    // 下一个调用分到的连接
+    unsigned inBatch_ = 0;
+};
+
+Worker::Worker(const LoadOptions& options, SSL_CTX* sslCtx, const sockaddr_storage& address,
+               socklen_t addressLength, unsigned connections, double rate)
+    : stats(options.calls.size()), options_(options), sslCtx_(sslCtx), address_(address),
+      addressLength_(addressLength), rate_(rate), conns_(connections), totalWeight_(0),
+      random_(0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(this)) {
+    // 精确定时器（Linux上为timerfd）：发送节拍不受epoll毫秒粒度的限制
+    event_config* config = event_config_new();
+    event_config_set_flag(config, EVENT_BASE_FLAG_PRECISE_TIMER);
+    base_ = event_base_new_with_config(config);
+    event_config_free(config);
+    timer_ = event_new(base_, -1, 0, Worker::timerCallback, this);
+    for (size_t i = 0; i < options_.calls.size(); ++i) {
+        totalWeight_ += options_.calls[i].weight;
+    }
+}
+
+Worker::~Worker() {
+    for (size_t i = 0; i < conns_.size(); ++i) {
+        if (conns_[i].bev) {
+            bufferevent_free(conns_[i].bev);
+        }
+        if (conns_[i].session) {
+            SSL_SESSION_free(conns_[i].session);
+        }
+    }
+    event_free(timer_);
+    event_base_free(base_);
+}
+
+void Worker::run() {
+    for (size_t i = 0; i < conns_.size(); ++i) {
+        conns_[i].worker = this;
+        if (!connect(conns_[i])) {
+            return;
+        }
+    }
+    const timeval wait = {0, 1000};
+    event_add(timer_, &wait);
+    event_base_dispatch(base_);
+
+    // 结束时仍未完成的调用：计划时刻在窗口内的计为unfinished
+    for (size_t i = 0; i < conns_.size(); ++i) {
+        Connection& conn = conns_[i];
+        std::vector<PendingCall> left(conn.queued.begin(), conn.queued.end());
+        left.insert(left.end(), conn.inflight.begin(), conn.inflight.end());
+        for (std::unordered_map<uint32_t, PendingCall>::const_iterator it = conn.framed.begin();
+             it != conn.framed.end(); ++it) {
+            left.push_back(it->second);
+        }
+        for (size_t j = 0; j < left.size(); ++j) {
+            if (left[j].intendedNs >= measureNs_ && left[j].intendedNs < endNs_) {
+                stats[left[j].call].unfinished++;
+            }
+        }
+    }
+    windowSec = started_ ? static_cast<double>(endNs_ - measureNs_) / 1e9 : 0;
+}
+
+bool Worker::connect(Connection& conn) {
+    conn.ready = false;
+    conn.closing = false;
+    conn.state = READ_HEAD;
+    const int flags = BEV_OPT_CLOSE_ON_FREE;
+    if (options_.tls) {
+        SSL* ssl = SSL_new(sslCtx_);
+        if (conn.session) {
+            SSL_set_session(ssl, conn.session);
+        }
+        conn.bev = bufferevent_openssl_socket_new(base_, -1, ssl, BUFFEREVENT_SSL_CONNECTING, flags);
+        // 服务端达到单连接请求数上限后直接关闭TCP，不视为错误
+        bufferevent_openssl_set_allow_dirty_shutdown(conn.bev, 1);
+    } else {
+        conn.bev = bufferevent_socket_new(base_, -1, flags);
+    }
+    bufferevent_setcb(conn.bev, Worker::readCallback, nullptr, Worker::eventCallback, &conn);
+    bufferevent_enable(conn.bev, EV_READ | EV_WRITE);
+    if (bufferevent_socket_connect(conn.bev, reinterpret_cast<sockaddr*>(&address_),
+                                   static_cast<int>(addressLength_)) < 0) {
+        error = "connect failed";
+        return false;
+    }
+    return true;
+}
+
+// 连接被服务端关闭：已写出未响应的调用退回队首（保留计划时刻），重新连接后按原顺序再发
+void Worker::reconnect(Connection& conn) {
+    std::vector<PendingCall> resend(conn.inflight.begin(), conn.inflight.end());
+    for (std::unordered_map<uint32_t, PendingCall>::const_iterator it = conn.framed.begin();
+         it != conn.framed.end(); ++it) {
+        resend.push_back(it->second);
+    }
+    std::sort(resend.begin(), resend.end(), [](const PendingCall& a, const PendingCall& b) {
+        return a.intendedNs < b.intendedNs;
+    });
+    conn.queued.insert(conn.queued.begin(), resend.begin(), resend.end());
+    conn.inflight.clear();
+    conn.framed.clear();
+
+    if (options_.tls) {
+        SSL_SESSION* session = SSL_get1_session(bufferevent_openssl_get_ssl(conn.bev));
+        if (session) {
+            if (conn.session) {
+                SSL_SESSION_free(conn.session);
+            }
+            conn.session = session;
+        }
+    }
+    bufferevent_free(conn.bev);
+    conn.bev = nullptr;
+    --connected_;
+    ++reconnects;
+    if (!connect(conn)) {
+        event_base_loopbreak(base_);
+    }
+}
+
+void Worker::start() {
+    started_ = true;
+    startNs_ = nowNs();
+    measureNs_ = startNs_ + static_cast<uint64_t>(options_.warmup * 1e9);
+    endNs_ = measureNs_ + static_cast<uint64_t>(options_.duration * 1e9);
+}
+
+// xorshift64，按权重选出下一个调用
+unsigned Worker::pickCall() {
+    if (options_.calls.size() == 1) {
+        return 0;
+    }
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 7;
+    random_ ^= random_ << 17;
+    unsigned point = static_cast<unsigned>(random_ % totalWeight_);
+    for (unsigned i = 0; i < options_.calls.size(); ++i) {
+        if (point < options_.calls[i].weight) {
+            return i;
+        }
+        point -= options_.calls[i].weight;
+    }
+    return 0;
+}
+
+// 连续batch个调用分到同一连接，再轮到下一条
+void Worker::issue(uint64_t intendedNs) {
+    PendingCall pending;
+    pending.intendedNs = intendedNs;
+    pending.sentNs = 0;
+    pending.call = pickCall();
+    conns_[cursor_].queued.push_back(pending);
+    if (++inBatch_ >= options_.batch) {
+        inBatch_ = 0;
+        cursor_ = (cursor_ + 1) % conns_.size();
+    }
+}
+
+void Worker::tick() {
+    if (!started_) {
+        const timeval wait = {0, 1000};
+        event_add(timer_, &wait);
+        return;
+    }
+    const uint64_t now = nowNs();
+    if (rate_ > 0 && now < endNs_) {
+        // 开环：到期的调用一律入队，不论前面的调用是否已有响应
+        const uint64_t due = static_cast<uint64_t>(static_cast<double>(now - startNs_) * rate_ / 1e9) + 1;
+        while (issued_ < due) {
+            issue(startNs_ + static_cast<uint64_t>(static_cast<double>(issued_) * 1e9 / rate_));
+            ++issued_;
+        }
+    }
+    for (size_t i = 0; i < conns_.size(); ++i) {
+        flush(conns_[i], now);
+    }
+    // 停止发送后等待已发出的调用完成，最多5秒
+    if (now >= endNs_ && (drained() || now >= endNs_ + 5000000000ull)) {
+        event_base_loopbreak(base_);
+        return;
+    }
+    // 下一次在下一个调用的计划时刻醒来，间隔不短于100微秒，更密的调用攒到一起发出；
+    // 计划时刻按速率精确计算，醒来的迟早只影响实际写出时刻
+    uint64_t delayNs = 1000000;
+    if (rate_ > 0 && now < endNs_) {
+        const uint64_t next = startNs_ + static_cast<uint64_t>(static_cast<double>(issued_) * 1e9 / rate_);
+        delayNs = std::max<uint64_t>(next > now ? next - now : 0, 100000);
+    }
+    const timeval wait = {static_cast<time_t>(delayNs / 1000000000), static_cast<suseconds_t>(delayNs % 1000000000 / 1000)};
+    event_add(timer_, &wait);
+}
+
+bool Worker::drained() const {
+    for (size_t i = 0; i < conns_.size(); ++i) {
+        if (!conns_[i].queued.empty() || conns_[i].outstanding() > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 在未完成调用数低于depth时写出排队的调用；同一轮写出的调用合并在一次写入中
+void Worker::flush(Connection& conn, uint64_t now) {
+    if (!conn.ready || conn.closing) {
+        return;
+    }
+    if (rate_ <= 0 && now < endNs_) {
+        // 闭环：保持depth个未完成调用，计划时刻即当前时刻
+        while (conn.queued.size() + conn.outstanding() < options_.depth) {
+            PendingCall pending;
+            pending.intendedNs = now;
+            pending.sentNs = 0;
+            pending.call = pickCall();
+            conn.queued.push_back(pending);
+        }
+    }
+    evbuffer* output = bufferevent_get_output(conn.bev);
+    while (!conn.queued.empty() && conn.outstanding() < options_.depth) {
+        PendingCall pending = conn.queued.front();
+        conn.queued.pop_front();
+        pending.sentNs = now;
+        const std::string& request = options_.calls[pending.call].request;
+        if (options_.binary) {
+            const uint32_t id = conn.nextId++;
+            const uint32_t networkId = htonl(id);
+            evbuffer_add(output, request.data(), 4);
+            evbuffer_add(output, &networkId, 4);
+            evbuffer_add(output, request.data() + 8, request.size() - 8);
+            conn.framed[id] = pending;
+        } else {
+            evbuffer_add(output, request.data(), request.size());
+            conn.inflight.push_back(pending);
+        }
+    }
+}
+
+void Worker::complete(const PendingCall& pending, bool transportError, bool rpcError) {
+    if (pending.intendedNs < measureNs_ || pending.intendedNs >= endNs_) {
+        return;
+    }
+    CallStats& callStats = stats[pending.call];
+    const uint64_t now = nowNs();
+    callStats.corrected.add((now - pending.intendedNs) / 1000);
+    callStats.uncorrected.add((now - pending.sentNs) / 1000);
+    if (transportError) {
+        callStats.transportErrors++;
+    } else if (rpcError) {
+        callStats.rpcErrors++;
+    } else {
+        callStats.ok++;
+    }
+}
+
+// 服务端以紧凑且键有序的JSON输出响应，JSON-RPC错误响应总以error键开头；
+// 方法结果中出现的error字段不算错误
+bool isErrorResponse(const char* body, size_t length) {
+    static const char kPrefix[] = "{\"error\":";
+    return length >= sizeof(kPrefix) - 1 && memcmp(body, kPrefix, sizeof(kPrefix) - 1) == 0;
+}
+
+// 不区分大小写地查找请求头名称，返回值的起始位置
+const char* findHeader(const char* head, size_t length, const char* name) {
+    const size_t nameLength = strlen(name);
+    const char* end = head + length;
+    for (const char* line = head; line < end;) {
+        const char* eol = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!eol) {
+            break;
+        }
+        if (static_cast<size_t>(eol - line) > nameLength && strncasecmp(line, name, nameLength) == 0 &&
+            line[nameLength] == ':') {
+            const char* value = line + nameLength + 1;
+            while (value < eol && *value == ' ') {
+                ++value;
+            }
+            return value;
+        }
+        line = eol + 1;
+    }
+    return nullptr;
+}
+
+void Worker::readHttp(Connection& conn) {
+    evbuffer* input = bufferevent_get_input(conn.bev);
+    for (;;) {
+        switch (conn.state) {
+        case READ_HEAD: {
+            const evbuffer_ptr found = evbuffer_search(input, "\r\n\r\n", 4, nullptr);
+            if (found.pos < 0) {
+                return;
+            }
+            const size_t headLength = static_cast<size_t>(found.pos) + 4;
+            const char* head = reinterpret_cast<const char*>(evbuffer_pullup(input, headLength));
+            conn.status = headLength > 12 ? atoi(head + 9) : 0;
+            const char* length = findHeader(head, headLength, "Content-Length");
+            const char* encoding = findHeader(head, headLength, "Transfer-Encoding");
+            const char* connection = findHeader(head, headLength, "Connection");
+            if (connection && strncasecmp(connection, "close", 5) == 0) {
+                conn.closing = true;
+            }
+            conn.remaining = length ? static_cast<size_t>(strtoull(length, nullptr, 10)) : 0;
+            conn.rpcError = false;
+            evbuffer_drain(input, headLength);
+            conn.state = encoding && strncasecmp(encoding, "chunked", 7) == 0 ? READ_CHUNK_SIZE : READ_BODY;
+            break;
+        }
+        case READ_BODY: {
+            if (evbuffer_get_length(input) < conn.remaining) {
+                return;
+            }
+            if (conn.remaining > 0) {
+                const char* body = reinterpret_cast<const char*>(evbuffer_pullup(input, conn.remaining));
+                conn.rpcError = isErrorResponse(body, conn.remaining);
+                evbuffer_drain(input, conn.remaining);
+            }
+            if (conn.inflight.empty()) {
+                error = "unexpected response";
+                event_base_loopbreak(base_);
+                return;
+            }
+            complete(conn.inflight.front(), conn.status != 200, conn.rpcError);
+            conn.inflight.pop_front();
+            conn.state = READ_HEAD;
+            break;
+        }
+        case READ_CHUNK_SIZE: {
+            size_t lineLength = 0;
+            char* line = evbuffer_readln(input, &lineLength, EVBUFFER_EOL_CRLF);
+            if (!line) {
+                return;
+            }
+            const size_t size = static_cast<size_t>(strtoull(line, nullptr, 16));
+            free(line);
+            if (size == 0) {
+                conn.state = READ_TRAILER;
+            } else {
+                conn.remaining = size + 2; // 数据块后的CRLF
+                conn.state = READ_CHUNK_DATA;
+            }
+            break;
+        }
+        case READ_CHUNK_DATA: {
+            const size_t skipped = std::min(evbuffer_get_length(input), conn.remaining);
+            evbuffer_drain(input, skipped);
+            conn.remaining -= skipped;
+            if (conn.remaining > 0) {
+                return;
+            }
+            conn.state = READ_CHUNK_SIZE;
+            break;
+        }
+        case READ_TRAILER: {
+            size_t lineLength = 0;
+            char* line = evbuffer_readln(input, &lineLength, EVBUFFER_EOL_CRLF);
+            if (!line) {
+                return;
+            }
+            free(line);
+            if (lineLength > 0) {
+                break; // 尾部头，忽略
+            }
+            if (conn.inflight.empty()) {
+                error = "unexpected response";
+                event_base_loopbreak(base_);
+                return;
+            }
+            complete(conn.inflight.front(), conn.status != 200, false);
+            conn.inflight.pop_front();
+            conn.state = READ_HEAD;
+            break;
+        }
+        }
+    }
+}
+
+void Worker::readBinary(Connection& conn) {
+    evbuffer* input = bufferevent_get_input(conn.bev);
+    for (;;) {
+        if (evbuffer_get_length(input) < kBinaryResponseHeaderSize) {
+            return;
+        }
+        const uint8_t* header = evbuffer_pullup(input, kBinaryResponseHeaderSize);
+        if (header[0] != kBinaryMagic || header[1] != kBinaryVersion) {
+            error = "bad response frame";
+            event_base_loopbreak(base_);
+            return;
+        }
+        uint32_t id, length;
+        memcpy(&id, header + 4, 4);
+        memcpy(&length, header + 8, 4);
+        id = ntohl(id);
+        length = ntohl(length);
+        const uint8_t status = header[3];
+        const size_t frameLength = kBinaryResponseHeaderSize + length;
+        if (evbuffer_get_length(input) < frameLength) {
+            return;
+        }
+        const char* body = reinterpret_cast<const char*>(evbuffer_pullup(input, frameLength)) +
+            kBinaryResponseHeaderSize;
+        const bool rpcError = isErrorResponse(body, length);
+        std::unordered_map<uint32_t, PendingCall>::iterator it = conn.framed.find(id);
+        if (it != conn.framed.end()) {
+            complete(it->second, status != BINARY_OK, rpcError);
+            conn.framed.erase(it);
+        }
+        evbuffer_drain(input, frameLength);
+    }
+}
+
+void Worker::readCallback(bufferevent* /*bev*/, void* ctx) {
+    Connection& conn = *static_cast<Connection*>(ctx);
+    Worker* self = conn.worker;
+    if (self->options_.binary) {
+        self->readBinary(conn);
+    } else {
+        self->readHttp(conn);
+    }
+    self->flush(conn, nowNs());
+}
+
+void Worker::eventCallback(bufferevent* bev, short events, void* ctx) {
+    Connection& conn = *static_cast<Connection*>(ctx);
+    Worker* self = conn.worker;
+    if (events & BEV_EVENT_CONNECTED) {
+        const int one = 1;
+        setsockopt(bufferevent_getfd(bev), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        conn.ready = true;
+        if (++self->connected_ == self->conns_.size() && !self->started_) {
+            self->start(); // 全部连接就绪后才开始计时
+        }
+        self->flush(conn, nowNs());
+        return;
+    }
+    if (events & (BEV_EVENT_EOF | BEV_EVENT_ERROR)) {
+        if (!conn.ready) {
+            // 连接或握手失败：服务端不可用，不再重试
+            unsigned long sslError = self->options_.tls ? bufferevent_get_openssl_error(bev) : 0;
+            self->error = sslError ? ERR_error_string(sslError, nullptr) : strerror(EVUTIL_SOCKET_ERROR());
+            event_base_loopbreak(self->base_);
+            return;
+        }
+        self->readCallback(bev, ctx); // 关闭前已到达的响应
+        self->reconnect(conn);
+    }
+}
+
+void Worker::timerCallback(evutil_socket_t /*fd*/, short /*events*/, void* ctx) {
+    static_cast<Worker*>(ctx)->tick();
+}
+
+// 预先编码调用的请求，params须为合法JSON
+bool encodeCall(const LoadOptions& options, CallSpec& spec) {
+    nlohmann::json body;
+    try {
+        body["params"] = nlohmann::json::parse(spec.params);
+    } catch (const std::exception& e) {
+        std::cerr << "无效的params (" << spec.method << "): " << e.what() << std::endl;
+        return false;
+    }
+    body["jsonrpc"] = "2.0";
+    body["id"] = 1;
+    if (options.binary) {
+        // 按methodId路由，请求体不带method
+        const std::string payload = body.dump();
+        uint8_t header[kBinaryRequestHeaderSize] = {kBinaryMagic, kBinaryVersion, 0, 0};
+        const uint32_t methodId = htonl(binaryMethodId(StringRef(spec.method)));
+        const uint32_t length = htonl(static_cast<uint32_t>(payload.size()));
+        memcpy(header + 8, &methodId, 4);
+        memcpy(header + 12, &length, 4);
+        spec.request.assign(reinterpret_cast<const char*>(header), sizeof(header));
+        spec.request += payload;
+    } else {
+        body["method"] = spec.method;
+        const std::string payload = body.dump();
+        spec.request = "POST " + options.path + " HTTP/1.1\r\nHost: " + options.host +
+            "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(payload.size()) +
+            "\r\n\r\n" + payload;
+    }
+    return true;
+}
+
+// 解析"权重,方法,params"，params中可以含有逗号
+bool parseCall(const char* text, CallSpec& spec) {
+    const char* first = strchr(text, ',');
+    const char* second = first ? strchr(first + 1, ',') : nullptr;
+    if (!second) {
+        return false;
+    }
+    spec.weight = static_cast<unsigned>(atoi(text));
+    spec.method.assign(first + 1, second);
+    spec.params = second + 1;
+    return spec.weight > 0 && spec.method.find('.') != std::string::npos;
+}
+
+nlohmann::json latencyJson(const Histogram& histogram) {
+    nlohmann::json result;
+    result["count"] = histogram.count;
+    result["mean"] = histogram.count ? static_cast<double>(histogram.sumUs) / histogram.count : 0.0;
+    result["p50"] = histogram.percentile(0.5);
+    result["p90"] = histogram.percentile(0.9);
+    result["p99"] = histogram.percentile(0.99);
+    result["p99.9"] = histogram.percentile(0.999);
+    result["p99.99"] = histogram.percentile(0.9999);
+    result["max"] = histogram.maxUs;
+    return result;
+}
+
+nlohmann::json countsJson(const CallStats& stats, double windowSec) {
+    nlohmann::json result;
+    const uint64_t completed = stats.ok + stats.rpcErrors + stats.transportErrors;
+    result["completed"] = completed;
+    result["ok"] = stats.ok;
+    result["rpc_errors"] = stats.rpcErrors;
+    result["transport_errors"] = stats.transportErrors;
+    result["unfinished"] = stats.unfinished;
+    result["throughput_rps"] = windowSec > 0 ? completed / windowSec : 0.0;
+    result["latency_us"] = latencyJson(stats.corrected);
+    result["service_time_us"] = latencyJson(stats.uncorrected);
+    return result;
+}
+
+void usage(const char* program) {
+    std::cerr << "用法: " << program << " [选项]" << std::endl;
+    std::cerr << "  -H, --host <addr>      服务端地址 (默认: 127.0.0.1)" << std::endl;
+    std::cerr << "  -p, --port <port>      服务端端口 (默认: 8443)" << std::endl;
+    std::cerr << "  --plain                不使用TLS（如--plain-port）" << std::endl;
+    std::cerr << "  --protocol <name>      http (默认) 或 binary（--binary-port的帧协议）" << std::endl;
+    std::cerr << "  --path <path>          HTTP请求目标 (默认: /api)" << std::endl;
+    std::cerr << "  -c, --connections <n>  连接数 (默认: 16)" << std::endl;
+    std::cerr << "  -t, --threads <n>      线程数，连接与速率在线程间平分 (默认: 1)" << std::endl;
+    std::cerr << "  -r, --rate <n>         每秒调用数，开环按计划时刻发送；0为闭环 (默认: 1000)" << std::endl;
+    std::cerr << "  -d, --duration <sec>   统计时长 (默认: 10)" << std::endl;
+    std::cerr << "  -w, --warmup <sec>     预热时长，不计入统计 (默认: 1)" << std::endl;
+    std::cerr << "  --depth <n>            每条连接最多的未完成调用数 (默认: 32)" << std::endl;
+    std::cerr << "  --batch <n>            连续n个调用分到同一连接并以一次写出 (默认: 1)" << std::endl;
+    std::cerr << "  --call <w,method,params>  加入调用组合，可重复 (默认: 1,MathService.add,{\"a\":1,\"b\":2})" << std::endl;
+    std::cerr << "  --json <file>          结果写入文件，-为stdout (默认: -)" << std::endl;
+}
+
+enum LoadgenOption {
+    OPT_PLAIN = 256,
+    OPT_PROTOCOL,
+    OPT_PATH,
+    OPT_DEPTH,
+    OPT_BATCH,
+    OPT_CALL,
+    OPT_JSON
+};
+
+const struct option kLongOptions[] = {
+    {"host",        required_argument, nullptr, 'H'},
+    {"port",        required_argument, nullptr, 'p'},
+    {"connections", required_argument, nullptr, 'c'},
+    {"threads",     required_argument, nullptr, 't'},
+    {"rate",        required_argument, nullptr, 'r'},
+    {"duration",    required_argument, nullptr, 'd'},
+    {"warmup",      required_argument, nullptr, 'w'},
+    {"plain",       no_argument,       nullptr, OPT_PLAIN},
+    {"protocol",    required_argument, nullptr, OPT_PROTOCOL},
+    {"path",        required_argument, nullptr, OPT_PATH},
+    {"depth",       required_argument, nullptr, OPT_DEPTH},
+    {"batch",       required_argument, nullptr, OPT_BATCH},
+    {"call",        required_argument, nullptr, OPT_CALL},
+    {"json",        required_argument, nullptr, OPT_JSON},
+    {"help",        no_argument,       nullptr, 'h'},
+    {nullptr,       0,                 nullptr, 0}
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "H:p:c:t:r:d:w:h", kLongOptions, nullptr)) != -1) {
+        switch (opt) {
+        case 'H': options.host = optarg; break;
+        case 'p': options.port = atoi(optarg); break;
+        case 'c': options.connections = static_cast<unsigned>(atoi(optarg)); break;
+        case 't': options.threads = static_cast<unsigned>(atoi(optarg)); break;
+        case 'r': options.rate = atof(optarg); break;
+        case 'd': options.duration = atof(optarg); break;
+        case 'w': options.warmup = atof(optarg); break;
+        case OPT_PLAIN: options.tls = false; break;
+        case OPT_PROTOCOL:
+            if (strcmp(optarg, "binary") == 0) {
+                options.binary = true;
+            } else if (strcmp(optarg, "http") != 0) {
+                std::cerr << "未知协议: " << optarg << std::endl;
+                return EXIT_FAILURE;
+            }
+            break;
+        case OPT_PATH: options.path = optarg; break;
+        case OPT_DEPTH: options.depth = static_cast<unsigned>(atoi(optarg)); break;
+        case OPT_BATCH: options.batch = static_cast<unsigned>(atoi(optarg)); break;
+        case OPT_CALL: {
+            CallSpec spec;
+            if (!parseCall(optarg, spec)) {
+                std::cerr << "无效的调用: " << optarg << "（格式: 权重,Service.method,params）" << std::endl;
+                return EXIT_FAILURE;
+            }
+            options.calls.push_back(spec);
+            break;
+        }
+        case OPT_JSON: options.jsonPath = optarg; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (options.port < 1 || options.port > 65535 || options.connections == 0 || options.threads == 0 ||
+        options.threads > options.connections || options.rate < 0 || options.duration <= 0 ||
+        options.depth == 0 || options.batch == 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (options.calls.empty()) {
+        CallSpec spec;
+        parseCall("1,MathService.add,{\"a\":1,\"b\":2}", spec);
+        options.calls.push_back(spec);
+    }
+    for (size_t i = 0; i < options.calls.size(); ++i) {
+        if (!encodeCall(options, options.calls[i])) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* resolved = nullptr;
+    if (getaddrinfo(options.host.c_str(), std::to_string(options.port).c_str(), &hints, &resolved) != 0) {
+        std::cerr << "无法解析地址: " << options.host << std::endl;
+        return EXIT_FAILURE;
+    }
+    sockaddr_storage address;
+    memcpy(&address, resolved->ai_addr, resolved->ai_addrlen);
+    const socklen_t addressLength = resolved->ai_addrlen;
+    freeaddrinfo(resolved);
+
+    signal(SIGPIPE, SIG_IGN);
+    SSL_CTX* sslCtx = nullptr;
+    if (options.tls) {
+        // 压测工具不校验证书，服务端通常使用自签名证书
+        sslCtx = SSL_CTX_new(TLS_client_method());
+        SSL_CTX_set_verify(sslCtx, SSL_VERIFY_NONE, nullptr);
+        SSL_CTX_set_session_cache_mode(sslCtx, SSL_SESS_CACHE_CLIENT);
+    }
+
+    // 连接与速率在线程间平分，余数分给前面的线程
+    std::vector<std::unique_ptr<Worker> > workers;
+    for (unsigned i = 0; i < options.threads; ++i) {
+        const unsigned connections = options.connections / options.threads +
+            (i < options.connections % options.threads ? 1 : 0);
+        const double rate = options.rate * connections / options.connections;
+        workers.push_back(std::unique_ptr<Worker>(
+            new Worker(options, sslCtx, address, addressLength, connections, rate)));
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        threads.push_back(std::thread(&Worker::run, workers[i].get()));
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    std::vector<CallStats> stats(options.calls.size());
+    CallStats total;
+    uint64_t reconnects = 0;
+    double throughputWindow = 0;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        if (!workers[i]->error.empty()) {
+            std::cerr << "压测失败: " << workers[i]->error << std::endl;
+            return EXIT_FAILURE;
+        }
+        for (size_t c = 0; c < stats.size(); ++c) {
+            stats[c].merge(workers[i]->stats[c]);
+            total.merge(workers[i]->stats[c]);
+        }
+        reconnects += workers[i]->reconnects;
+        throughputWindow = std::max(throughputWindow, workers[i]->windowSec);
+    }
+
+    nlohmann::json result;
+    nlohmann::json& config = result["config"];
+    config["host"] = options.host;
+    config["port"] = options.port;
+    config["tls"] = options.tls;
+    config["protocol"] = options.binary ? "binary" : "http";
+    config["connections"] = options.connections;
+    config["threads"] = options.threads;
+    config["rate"] = options.rate;
+    config["open_loop"] = options.rate > 0;
+    config["duration_s"] = options.duration;
+    config["warmup_s"] = options.warmup;
+    config["depth"] = options.depth;
+    config["batch"] = options.batch;
+    result["total"] = countsJson(total, throughputWindow);
+    result["reconnects"] = reconnects;
+    for (size_t c = 0; c < stats.size(); ++c) {
+        nlohmann::json method = countsJson(stats[c], throughputWindow);
+        method["method"] = options.calls[c].method;
+        method["weight"] = options.calls[c].weight;
+        result["methods"].push_back(method);
+    }
+    // 合计延迟的非空桶：[桶上界(微秒), 个数]，可在外部合并多次运行或重算分位数
+    nlohmann::json& buckets = result["histogram_us"];
+    buckets = nlohmann::json::array();
+    for (unsigned b = 0; b < LatencyBuckets::kCount; ++b) {
+        if (total.corrected.buckets[b] > 0) {
+            buckets.push_back({LatencyBuckets::upperBound(b), total.corrected.buckets[b]});
+        }
+    }
+
+    const std::string text = result.dump(2);
+    if (options.jsonPath == "-") {
+        std::cout << text << std::endl;
+    } else {
+        std::ofstream out(options.jsonPath);
+        out << text << std::endl;
+    }
+
+    const uint64_t completed = total.ok + total.rpcErrors + total.transportErrors;
+    fprintf(stderr, "%s %s, %u conns, %s: %llu calls in %.1fs = %.0f/s (errors rpc %llu, transport %llu, "
+            "unfinished %llu, reconnects %llu)\n",
+            options.binary ? "binary" : "http", options.tls ? "tls" : "plain", options.connections,
+            options.rate > 0 ? "open loop" : "closed loop", static_cast<unsigned long long>(completed),
+            throughputWindow, throughputWindow > 0 ? completed / throughputWindow : 0.0,
+            static_cast<unsigned long long>(total.rpcErrors), static_cast<unsigned long long>(total.transportErrors),
+            static_cast<unsigned long long>(total.unfinished), static_cast<unsigned long long>(reconnects));
+    fprintf(stderr, "latency (us, from intended send)  p50 %llu  p90 %llu  p99 %llu  p99.9 %llu  max %llu\n",
+            static_cast<unsigned long long>(total.corrected.percentile(0.5)),
+            static_cast<unsigned long long>(total.corrected.percentile(0.9)),
+            static_cast<unsigned long long>(total.corrected.percentile(0.99)),
+            static_cast<unsigned long long>(total.corrected.percentile(0.999)),
+            static_cast<unsigned long long>(total.corrected.maxUs));
+    fprintf(stderr, "service time (us, from actual send) p50 %llu  p90 %llu  p99 %llu  p99.9 %llu  max %llu\n",
+            static_cast<unsigned long long>(total.uncorrected.percentile(0.5)),
+            static_cast<unsigned long long>(total.uncorrected.percentile(0.9)),
+            static_cast<unsigned long long>(total.uncorrected.percentile(0.99)),
+            static_cast<unsigned long long>(total.uncorrected.percentile(0.999)),
+            static_cast<unsigned long long>(total.uncorrected.maxUs));
+
+    workers.clear();
+    if (sslCtx) {
+        SSL_CTX_free(sslCtx);
+    }
+    return EXIT_SUCCESS;
+}
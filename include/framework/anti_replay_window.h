@@ -0,0 +1,30 @@
+// include/framework/anti_replay_window.h
+#ifndef ANTI_REPLAY_WINDOW_H
+#define ANTI_REPLAY_WINDOW_H
+
+#include <string>
+#include <deque>
+#include <utility>
+#include <ctime>
+#include <unordered_set>
+#include <openssl/ssl.h>
+
+// TLS 1.3 0-RTT防重放窗口
+// 会话票据签发后windowSec秒内可用于一次早期数据，超出窗口或重复使用的票据
+// 只拒绝早期数据，握手本身仍按普通的1-RTT恢复完成
+class AntiReplayWindow {
+public:
+    explicit AntiReplayWindow(int windowSec) : windowSec_(windowSec) {}
+
+    // 判断能否接受此会话携带的早期数据，接受时记录票据
+    bool accept(SSL_SESSION* session);
+
+private:
+    void expire(time_t now);
+
+    int windowSec_;
+    std::unordered_set<std::string> seen_;              // 窗口内已使用的票据摘要
+    std::deque<std::pair<time_t, std::string> > order_; // 按记录时间排序，用于过期清理
+};
+
+#endif // ANTI_REPLAY_WINDOW_H
@@ -0,0 +1,37 @@
+// include/framework/audit_compressor.h
+#ifndef AUDIT_COMPRESSOR_H
+#define AUDIT_COMPRESSOR_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 把轮转出的审计日志文件（JSON日志或二进制段）压缩为gzip
+// 在独立的低优先级线程中进行，既不占用审计日志的写线程，也不与处理请求的线程争抢CPU。
+// 压缩结果先写到<path>.gz.tmp并落盘，再改名为<path>.gz、删除原文件；
+// 中途失败或进程退出时原文件保留，下次启动时由AuditLogger重新排入队列
+class AuditCompressor {
+public:
+    AuditCompressor();
+    ~AuditCompressor(); // 压完正在处理的文件后退出，队列中其余的文件留待下次启动
+
+    // 排入一个已写完的文件，首次调用时启动后台线程；只做一次加锁入队
+    void enqueue(const std::string& path);
+
+private:
+    void run();
+    static bool compress(const std::string& path);
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::string> queue_;
+    bool stopping_;
+    std::thread worker_;
+
+    AuditCompressor(const AuditCompressor&);
+    AuditCompressor& operator=(const AuditCompressor&);
+};
+
+#endif // AUDIT_COMPRESSOR_H
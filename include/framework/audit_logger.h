@@ -0,0 +1,179 @@
+// include/framework/audit_logger.h
+#ifndef AUDIT_LOGGER_H
+#define AUDIT_LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "framework/audit_compressor.h"
+#include "framework/audit_segment.h"
+#include "framework/string_ref.h"
+
+// 一条审计记录，定长以便直接写入环形缓冲；超长的字段截断
+struct AuditRecord {
+    static const size_t kClientSize = 46; // INET6_ADDRSTRLEN
+    static const size_t kMethodSize = 64;
+
+    uint64_t timestampMs;   // 墙上时间，毫秒
+    uint16_t clientPort;
+    uint8_t clientLength;
+    uint8_t methodLength;
+    uint32_t latencyUs;     // 请求开始分发到得出响应
+    char client[kClientSize];
+    char method[kMethodSize];
+    uint8_t flags;          // AUDIT_RECORD_ERROR等
+    char reserved[1];       // 补齐到128字节
+};
+
+static const uint8_t AUDIT_RECORD_ERROR = 1; // 方法执行出错，返回了错误响应
+
+// 单生产者单消费者的环形缓冲，每个写日志的线程一个
+// head_只由生产者推进，tail_只由消费者推进，双方不加锁
+class AuditRing {
+public:
+    explicit AuditRing(size_t capacity);
+
+    // 生产者：取得下一个空槽，满时返回nullptr；填好后调用publish，
+    // 缓冲恰好涨到一半时返回true，供调用方提前唤醒消费者
+    AuditRecord* reserve();
+    bool publish();
+    void countDrop() { dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    // 消费者：取出最多max条连续的记录，处理完后调用release
+    size_t peek(const AuditRecord*& records, size_t max) const;
+    void release(size_t count);
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<AuditRecord> slots_;
+    size_t mask_;
+    // 生产者与消费者各自的计数以填充隔开缓存行，避免相互失效
+    // （C++11的new不保证alignas超过16字节的对齐）
+    std::atomic<uint64_t> head_;
+    uint64_t cachedTail_;        // 生产者缓存的tail_，减少跨核读取
+    std::atomic<uint64_t> dropped_;
+    char padding_[64];
+    std::atomic<uint64_t> tail_;
+};
+
+// 按客户端地址限制每秒的审计记录数，每个写日志的线程一份，只由该线程使用，不加锁
+// 固定大小的直接映射表：地址哈希到槽，槽被其他地址占用时直接接管并重新计数，
+// 内存不随客户端数量增长，哈希冲突只会让相撞的地址限制变宽松
+class AuditClientLimiter {
+public:
+    bool allow(StringRef client, uint32_t second, unsigned limit);
+
+private:
+    struct Slot {
+        uint64_t hash;
+        uint32_t second;
+        uint32_t count;
+    };
+    static const size_t kSlots = 4096;
+    std::vector<Slot> slots_; // 首次使用时分配
+};
+
+// 每个写日志的线程的状态：记录缓冲，以及只由本线程读写的采样与限流状态
+struct AuditProducer {
+    explicit AuditProducer(size_t ringCapacity) : ring(ringCapacity), sampleCountdown(1), limited(0) {}
+
+    AuditRing ring;
+    unsigned sampleCountdown;         // 减到0时记录一次成功的调用
+    AuditClientLimiter limiter;
+    std::atomic<uint64_t> limited;    // 超出客户端速率被略去的记录数，后台线程读取
+};
+
+enum AuditFormat {
+    AUDIT_FORMAT_JSON,   // 每行一个JSON对象
+    AUDIT_FORMAT_BINARY  // 定长二进制条目写入内存映射的段文件（见audit_segment.h）
+};
+
+struct AuditOptions {
+    std::string path;                 // JSON格式为日志文件，二进制格式为段文件名前缀；为空则不记录
+    AuditFormat format = AUDIT_FORMAT_JSON;
+    size_t segmentSize = AuditSegmentWriter::kDefaultSegmentSize;
+    size_t ringCapacity = 8192;       // 每线程缓冲的记录数，128字节一条
+    unsigned flushIntervalMs = 50;
+    unsigned sampleRate = 1;          // 成功的调用每sampleRate次记录一次，出错的调用总是记录
+    unsigned maxPerClientPerSec = 0;  // 每个客户端地址每秒最多记录的条数（含出错的调用），0表示不限
+    size_t rotateBytes = 0;           // JSON日志超过此大小时轮转，0表示不按大小轮转；二进制格式写满segmentSize即换段
+    unsigned rotateIntervalSec = 0;   // 当前文件或段开始写入超过此时长时轮转，0表示不按时间轮转
+    bool compress = true;             // 轮转出的文件在后台线程压缩为gzip
+};
+
+// 异步审计日志
+// I/O线程调用log只做一次定长拷贝：记录写入本线程的环形缓冲，不格式化、不加锁、不做系统调用；
+// 后台线程每隔flushIntervalMs（或某个缓冲过半时）取出所有缓冲中的记录，
+// 格式化为每行一个JSON对象，合并成一次write追加到日志文件；二进制格式则直接编码进段文件的映射内存。
+// 缓冲满时丢弃新记录并计数，后台线程把新增的丢弃数作为一行写入日志，审计缺口可见；
+// 超出客户端速率被略去的记录同样计数写入。采样略去的调用不计数。
+// 轮转与重新打开也在后台线程的两批记录之间进行：JSON日志改名为<path>.<序号>后重新打开原路径，
+// 二进制格式换到下一个段；轮转出的文件交给AuditCompressor压缩。I/O线程始终只写缓冲
+class AuditLogger {
+public:
+    AuditLogger();
+    ~AuditLogger(); // 写完所有缓冲中的记录后退出后台线程
+
+    // 以追加方式打开（必要时创建）日志文件或第一个段文件并启动后台线程，失败时返回false
+    bool open(const AuditOptions& options);
+    bool isOpen() const { return open_; }
+
+    // 按采样率与客户端速率决定这次调用是否记录，返回true时调用方再准备记录内容并调用log。
+    // 略去的调用只付出一次线程局部访问与计数器递减（开启限流时再加一次哈希查表）
+    bool admit(StringRef client, bool error);
+    void log(StringRef client, uint16_t clientPort, StringRef method, uint32_t latencyUs, bool error);
+
+    // 因缓冲满被丢弃的记录总数
+    uint64_t dropped() const;
+
+    // 请求所有实例重新打开日志（JSON格式重新打开原路径，二进制格式换段），可在信号处理函数中调用；
+    // 后台线程在下一个刷新周期处理
+    static void requestReopen();
+
+private:
+    AuditProducer* threadProducer();
+    void run();
+    size_t drain(std::string& batch);
+    void maintain();
+    bool openJsonFile();
+    void rotateJson();
+    void reportRotate(const char* action, int err);
+    void appendCount(AuditEntryType type, const char* name, uint64_t total, uint64_t& reported,
+                     std::string& batch);
+    void writeBatch(const std::string& batch);
+    static void format(const AuditRecord& record, std::string& out);
+
+    bool open_;
+    AuditOptions options_;
+    int fd_;                        // JSON格式的日志文件
+    AuditSegmentWriter segments_;   // 二进制格式
+    uint64_t id_;                  // 区分实例，线程缓存的缓冲只对所属实例有效
+    AuditCompressor compressor_;
+    uint64_t fileBytes_;            // JSON日志文件的当前长度
+    time_t openedAt_;               // JSON日志文件的打开时间
+    time_t rotateRetryAt_;          // 轮转失败后每秒至多重试一次
+    bool rotateFailed_;
+    unsigned reopenSeen_;           // 已处理的重新打开请求数
+
+    mutable std::mutex producersMutex_; // 只在线程首次写日志登记时与后台线程竞争
+    std::vector<std::unique_ptr<AuditProducer> > producers_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    bool stopping_;
+    uint64_t reportedDrops_;
+    uint64_t reportedLimited_;
+    bool writeFailed_;
+    std::thread worker_;
+
+    AuditLogger(const AuditLogger&);
+    AuditLogger& operator=(const AuditLogger&);
+};
+
+#endif // AUDIT_LOGGER_H
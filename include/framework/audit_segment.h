@@ -0,0 +1,125 @@
+// include/framework/audit_segment.h
+#ifndef AUDIT_SEGMENT_H
+#define AUDIT_SEGMENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "framework/string_ref.h"
+
+// 二进制审计日志的段文件格式，tools/audit_decode.py按此解码
+// 小端序；段头之后是连续的条目，每个条目以类型字节开头、长度为8的倍数。
+// 每个段自带方法名表：方法在段内首次出现时先写一个方法条目，之后的调用条目只记methodId，
+// 因此单个段（包括轮转、压缩后的段）可以独立解码
+static const char kAuditSegmentMagic[8] = {'R', 'P', 'C', 'A', 'U', 'D', 'I', 'T'};
+static const uint16_t kAuditSegmentVersion = 1;
+
+struct AuditSegmentHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t reserved0;
+    uint64_t sequence;     // 段序号，文件名后缀与之相同
+    uint64_t createdMs;
+    uint64_t usedBytes;    // 已写入的字节数（含段头），之后是预分配的空间
+    uint8_t reserved[24];
+};
+
+enum AuditEntryType {
+    AUDIT_ENTRY_METHOD = 1,  // 方法名定义
+    AUDIT_ENTRY_CALL = 2,    // 一次调用
+    AUDIT_ENTRY_DROPPED = 3,      // 因缓冲满丢弃的记录数
+    AUDIT_ENTRY_RATE_LIMITED = 4  // 超出客户端速率略去的记录数
+};
+
+static const uint16_t AUDIT_CALL_ERROR = 1; // AuditCallEntry::flags：方法执行出错
+
+// 方法条目：4字节头加方法名，补齐到8字节
+struct AuditMethodEntry {
+    uint8_t type;
+    uint8_t nameLength;
+    uint16_t methodId;     // 段内从1开始编号
+};
+
+struct AuditCallEntry {
+    uint8_t type;
+    uint8_t family;        // 4或6，0表示地址未知（如Unix域套接字）
+    uint16_t port;
+    uint16_t methodId;
+    uint16_t flags;        // AUDIT_CALL_ERROR
+    uint64_t timestampMs;
+    uint32_t latencyUs;
+    uint32_t reserved1;
+    uint8_t address[16];   // IPv4占前4字节
+};
+
+// 丢弃与限流计数条目
+struct AuditCountEntry {
+    uint8_t type;
+    uint8_t reserved[7];
+    uint64_t count;
+    uint64_t timestampMs;
+};
+
+// 段文件与轮转出的JSON日志共用<basePath>.<6位序号>的命名，压缩后再加.gz后缀
+std::string auditSequencePath(const std::string& basePath, uint64_t sequence);
+// 目录中已有文件（含压缩过的）的最大序号，没有时为0
+uint64_t lastAuditSequence(const std::string& basePath);
+// 已写完但尚未压缩的文件，按序号排列
+std::vector<std::string> uncompressedAuditFiles(const std::string& basePath);
+
+// 把审计记录写入内存映射的段文件，只在审计日志的后台线程中使用
+// 段文件为<basePath>.<6位序号>，打开时以posix_fallocate预分配segmentSize字节，
+// 磁盘空间不足在创建段时即可发现，不会在写映射内存时触发SIGBUS；
+// 写满后更新段头、截去未用的部分并开始下一个段。启动时接着目录中已有的最大序号编号，不覆盖旧段
+class AuditSegmentWriter {
+public:
+    static const size_t kDefaultSegmentSize = 64 * 1024 * 1024;
+
+    AuditSegmentWriter();
+    ~AuditSegmentWriter() { close(); }
+
+    bool open(const std::string& basePath, size_t segmentSize);
+    void close();
+
+    // client为inet_ntop格式的地址，无法解析时记为未知
+    void appendCall(uint64_t timestampMs, StringRef client, uint16_t port, StringRef method,
+                    uint32_t latencyUs, bool error);
+    void appendCount(AuditEntryType type, uint64_t count, uint64_t timestampMs);
+    // 一批条目写完后更新段头的usedBytes，此前写入的条目对读取方可见
+    void commit();
+
+    // 结束当前段并开始下一个段，当前段没有条目时不动
+    void rotate();
+    bool empty() const { return !map_ || used_ == sizeof(AuditSegmentHeader); }
+    uint64_t openedMs() const { return openedMs_; } // 当前段的创建时间，墙上时间
+    // 取出自上次调用以来写完的段文件路径
+    void takeFinished(std::vector<std::string>& paths) { paths.swap(finished_); finished_.clear(); }
+
+private:
+    bool openSegment();
+    void finishSegment();
+    bool roll();
+    void report(const char* action, const std::string& path, int err);
+    bool fits(size_t bytes) const { return map_ && used_ + bytes <= segmentSize_; }
+
+    std::string basePath_;
+    std::string path_;     // 当前段
+    size_t segmentSize_;
+    uint64_t sequence_;
+    uint64_t openedMs_;
+    int fd_;
+    uint8_t* map_;
+    size_t used_;
+    bool failed_;    // 创建段失败，本批不再重试
+    bool reported_;  // 已报告过当前的故障
+    std::unordered_map<std::string, uint16_t> methods_; // 当前段的方法名表
+    std::vector<std::string> finished_;
+
+    AuditSegmentWriter(const AuditSegmentWriter&);
+    AuditSegmentWriter& operator=(const AuditSegmentWriter&);
+};
+
+#endif // AUDIT_SEGMENT_H
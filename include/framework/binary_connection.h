@@ -0,0 +1,106 @@
+// include/framework/binary_connection.h
+#ifndef BINARY_CONNECTION_H
+#define BINARY_CONNECTION_H
+
+#include <cstdint>
+#include <functional>
+#include <event2/buffer.h>
+#include "framework/http_connection.h"
+#include "framework/transport_backend.h"
+
+// 长度前缀的二进制帧协议，供内部高QPS调用方绕过HTTP分帧与请求头（TLS或Unix域套接字上）
+//
+// 请求帧头16字节，多字节字段均为网络字节序：
+//   0  u8  magic 'R'
+//   1  u8  version 1
+//   2  u8  encoding  请求体编码：0 identity，1 gzip，2 zstd
+//   3  u8  accept    可接受的响应编码位掩码：bit1 gzip，bit2 zstd（即1 << encoding）
+//   4  u32 requestId 由客户端分配，原样带回响应帧
+//   8  u32 methodId  binaryMethodId("Service.method")；0表示按请求体中的method路由
+//   12 u32 bodyLength
+// 请求体与HTTP请求体相同，为JSON-RPC请求对象；methodId非0时method可省略
+//
+// 响应帧头12字节：
+//   0  u8  magic 'R'
+//   1  u8  version 1
+//   2  u8  encoding  响应体编码
+//   3  u8  status    BinaryStatus，非0表示请求未经分发即被拒绝
+//   4  u32 requestId
+//   8  u32 bodyLength
+// 响应体为JSON-RPC响应对象，被拒绝的请求同样带有JSON-RPC错误体
+//
+// 客户端可在同一连接上连续发送多个请求而不必等待响应，响应以requestId对应请求，
+// 客户端不得假设响应按请求顺序到达。这是协议约定而非当前行为：服务端在事件循环上逐个
+// 同步分发，调用之间不并发执行，响应实际总是按请求顺序写出；约定为日后的并发分发预留
+static const uint8_t kBinaryMagic = 'R';
+static const uint8_t kBinaryVersion = 1;
+static const size_t kBinaryRequestHeaderSize = 16;
+static const size_t kBinaryResponseHeaderSize = 12;
+
+// 响应帧头中的status
+enum BinaryStatus {
+    BINARY_OK = 0,              // 已分发，调用结果（含方法内的错误）见响应体
+    BINARY_METHOD_NOT_FOUND = 1,
+    BINARY_TOO_LARGE = 2,
+    BINARY_UNSUPPORTED_ENCODING = 3,
+    BINARY_PROTOCOL_ERROR = 4   // 帧头无法识别，发送此响应后关闭连接
+};
+
+// 方法的数字标识：对"Service.method"做32位FNV-1a，客户端可自行计算而无需查表
+uint32_t binaryMethodId(StringRef qualifiedName);
+
+// 二进制帧协议的连接状态机：与HttpConnection一样不涉及I/O，从输入缓冲切分请求帧、
+// 调用RpcDispatcher并把响应帧写入输出缓冲。沿用HttpOptions中的积压上限、压缩策略、
+// 请求体上限与路由，methodId经HttpOptions::methodIds解析（请求头上限与单连接请求数上限不适用）。
+// 帧长在帧头中给出，被拒绝的请求体直接跳过，除帧头损坏外连接始终可以继续使用
+class BinaryConnection {
+public:
+    enum Phase {
+        READ_HEADER,
+        READ_BODY,
+        SKIP_BODY,  // 请求已被拒绝，丢弃其请求体
+        CLOSING     // 帧头损坏，发送错误响应后关闭
+    };
+
+    // dispatcher、state与options须比BinaryConnection存活更久
+    BinaryConnection(const RpcDispatcher& dispatcher, ConnectionState& state, const HttpOptions& options);
+
+    void process(evbuffer* input, evbuffer* output);
+
+    bool closing() const { return phase_ == CLOSING; }
+    // 没有读了一半的请求帧
+    bool idle() const { return phase_ == READ_HEADER; }
+    // 已读到的请求帧头数，帧头与请求体的期限按帧计
+    unsigned served() const { return served_; }
+    // 没有待发送的输出时，连接在等待对端的什么数据
+    TimeoutStage readStage(const evbuffer* input) const;
+
+    // 同HttpConnection::outputBlocked
+    bool outputBlocked(size_t pending) const {
+        return pending >= options_.maxPendingOutput;
+    }
+
+private:
+    bool readHeader(evbuffer* input, evbuffer* output);
+    bool skipBody(evbuffer* input);
+    void reject(evbuffer* output, BinaryStatus status, StringRef body);
+    void writeFrame(evbuffer* output, ContentCoding coding, BinaryStatus status, StringRef body);
+
+    const RpcDispatcher& dispatcher_;
+    ConnectionState& state_;
+    const HttpOptions& options_;
+    Phase phase_;
+    unsigned served_;
+
+    // 当前请求帧
+    uint32_t requestId_;
+    size_t bodyLength_;
+    StringRef target_;       // 指向methodIds持有的字符串，methodId为0时为空
+    ContentCoding encoding_;
+    ContentCoding accepted_; // 按accept位掩码选出的响应编码
+
+    BinaryConnection(const BinaryConnection&);
+    BinaryConnection& operator=(const BinaryConnection&);
+};
+
+#endif // BINARY_CONNECTION_H
@@ -0,0 +1,157 @@
+// include/framework/compression.h
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <zlib.h>
+#include "framework/string_ref.h"
+
+#ifdef RPC_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// 响应体的内容编码
+enum ContentCoding {
+    CODING_IDENTITY,
+    CODING_GZIP,
+    CODING_ZSTD     // 需以ZSTD=1构建
+};
+
+// Content-Encoding中使用的名称
+const char* contentCodingName(ContentCoding coding);
+
+// 识别请求头Content-Encoding中的编码，不支持时返回false
+bool parseContentCoding(StringRef contentEncoding, ContentCoding& coding);
+
+// 从Accept-Encoding中选出客户端接受且本进程支持的编码，q值相同时zstd优先于gzip
+ContentCoding negotiateContentCoding(StringRef acceptEncoding);
+
+// 响应压缩策略
+struct CompressionPolicy {
+    bool enabled = false;   // 总开关，关闭时忽略Accept-Encoding
+    size_t minSize = 1024;  // 小于此长度的响应体不压缩，压缩头部开销与CPU不划算
+    int gzipLevel = 6;
+    int zstdLevel = 3;
+};
+
+// 每线程一份的压缩上下文：z_stream与ZSTD_CCtx在线程内复用，压缩时不再分配上下文
+class ResponseCompressor {
+public:
+    static ResponseCompressor& forThread();
+
+    ~ResponseCompressor();
+
+    // 压缩input，结果覆盖output；失败返回false
+    bool compress(ContentCoding coding, int level, StringRef input, std::string& output);
+
+    // WebSocket permessage-deflate（RFC 7692）：原始deflate流，以同步刷新结束并去掉末尾的00 00 ff ff
+    // 不保留跨消息的上下文（no_context_takeover），windowBits为协商出的窗口大小（9~15）
+    bool deflateMessage(int level, int windowBits, StringRef input, std::string& output);
+
+private:
+    ResponseCompressor();
+
+    bool gzip(int level, StringRef input, std::string& output);
+#ifdef RPC_HAVE_ZSTD
+    bool zstd(int level, StringRef input, std::string& output);
+#endif
+
+    z_stream deflate_;
+    bool deflateReady_;
+    int deflateLevel_;
+    z_stream rawDeflate_;   // permessage-deflate使用的原始deflate流
+    int rawWindowBits_;     // 0表示尚未初始化
+    int rawLevel_;
+#ifdef RPC_HAVE_ZSTD
+    ZSTD_CCtx* zstd_;
+#endif
+
+    ResponseCompressor(const ResponseCompressor&);
+    ResponseCompressor& operator=(const ResponseCompressor&);
+};
+
+// 按策略压缩响应体，返回实际采用的编码
+// 未协商出编码、方法关闭了压缩、长度低于阈值或压缩后并未变小时返回CODING_IDENTITY，body保持不变
+ContentCoding compressResponse(const CompressionPolicy& policy, ContentCoding accepted,
+                               bool compressible, std::string& body);
+
+// 请求体解压失败：数据损坏、截断，或解压后超出长度上限
+class DecompressionError : public std::runtime_error {
+public:
+    DecompressionError(const std::string& what, bool sizeExceeded)
+        : std::runtime_error(what), sizeExceeded_(sizeExceeded) {}
+
+    bool sizeExceeded() const { return sizeExceeded_; }
+
+private:
+    bool sizeExceeded_;
+};
+
+// 解压一条permessage-deflate消息（补回末尾的00 00 ff ff），结果覆盖output
+// 解压上下文按线程复用、每条消息重置；超过maxSize或数据损坏时抛出DecompressionError
+void inflateMessage(StringRef input, size_t maxSize, std::string& output);
+
+// 流式解压请求体：每次解压一个窗口供JSON解析器逐字节读取，不生成完整的解压结果
+// 解压上下文按线程复用；解压后的累计长度超过maxSize时抛出DecompressionError，防御压缩炸弹。
+// 用法：nlohmann::json::parse(decompressor.begin(), decompressor.end())
+class RequestDecompressor {
+public:
+    class Iterator {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef char value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const char* pointer;
+        typedef char reference;
+
+        explicit Iterator(RequestDecompressor* source = nullptr) : source_(source) {}
+
+        char operator*() const { return source_->window_[source_->pos_]; }
+        Iterator& operator++() { ++source_->pos_; return *this; }
+        bool operator==(const Iterator& other) const { return atEnd() == other.atEnd(); }
+        bool operator!=(const Iterator& other) const { return atEnd() != other.atEnd(); }
+
+    private:
+        // 当前窗口读完时解压下一个窗口
+        bool atEnd() const {
+            return source_ == nullptr || (source_->pos_ == source_->len_ && !source_->fill());
+        }
+
+        RequestDecompressor* source_;
+    };
+
+    // input须在解压期间保持有效
+    RequestDecompressor(ContentCoding coding, StringRef input, size_t maxSize);
+
+    Iterator begin() { return Iterator(this); }
+    Iterator end() { return Iterator(); }
+
+    size_t decompressedSize() const { return total_; }
+
+private:
+    bool fill();
+    size_t inflateWindow();
+#ifdef RPC_HAVE_ZSTD
+    size_t zstdWindow();
+#endif
+
+    static const size_t kWindowSize = 16 * 1024;
+
+    ContentCoding coding_;
+    StringRef input_;
+    size_t consumed_;   // 已送入解压器的输入字节数
+    size_t maxSize_;
+    size_t total_;      // 已解压的累计字节数
+    bool finished_;
+    size_t pos_;
+    size_t len_;
+    char window_[kWindowSize];
+
+    RequestDecompressor(const RequestDecompressor&);
+    RequestDecompressor& operator=(const RequestDecompressor&);
+};
+
+#endif // COMPRESSION_H
@@ -0,0 +1,64 @@
+// include/framework/connection_deadline.h
+#ifndef CONNECTION_DEADLINE_H
+#define CONNECTION_DEADLINE_H
+
+#include "framework/timer_wheel.h"
+
+// 连接当前等待的事情，各自对应一个超时
+enum TimeoutStage {
+    STAGE_NONE,
+    STAGE_HANDSHAKE, // 接受连接到TLS握手完成
+    STAGE_HEADER,    // 请求的首字节到请求头收齐
+    STAGE_BODY,      // 请求头收齐到请求体收齐
+    STAGE_IDLE,      // keep-alive连接等待下一个请求，WebSocket会话等待下一条消息
+    STAGE_WRITE,     // 有响应待发送，对端持续不读取
+    STAGE_LINGER     // 已发出错误响应并关闭写方向，丢弃对端剩余的请求体
+};
+
+// 连接超时时间轮的精度：超时最多晚这么久生效
+static const unsigned kConnectionTimerTickMs = 100;
+
+// 连接各阶段的超时（秒），0表示不限
+struct ConnectionTimeouts {
+    int handshakeSec = 10;
+    int headerSec = 10;
+    int bodySec = 30;
+    int idleSec = 60;
+    int writeSec = 30;
+    int lingerSec = 5;
+
+    int forStage(TimeoutStage stage) const;
+};
+
+// 单个连接的截止时间，原生引擎与io_uring后端共用
+// 引擎在每次I/O之后按连接所处的阶段调用enter，同一时刻只计一个阶段的超时：
+//   握手、请求头与请求体的期限从进入该阶段时算起，不因陆续到达的字节而延后，
+//   逐字节慢速发送请求头的连接（slowloris）同样在headerSec后关闭；
+//   空闲以最近一次活动计；写超时衡量的是停滞，引擎在写出有进展时调用restart。
+// 到期时调用onExpired，由引擎决定关闭连接还是转入其他阶段
+class ConnectionDeadline {
+public:
+    // wheel与timeouts须比ConnectionDeadline存活更久
+    ConnectionDeadline(TimerWheel& wheel, const ConnectionTimeouts& timeouts,
+                       WheelTimer::Callback onExpired, void* arg);
+
+    // 进入stage；request为连接已开始的请求序号，同一阶段换了请求时重新计时（写阶段除外）
+    void enter(TimeoutStage stage, unsigned request = 0);
+    // 当前阶段重新计时
+    void restart();
+    void cancel();
+
+    TimeoutStage stage() const { return stage_; }
+
+private:
+    TimerWheel& wheel_;
+    const ConnectionTimeouts& timeouts_;
+    WheelTimer timer_;
+    TimeoutStage stage_;
+    unsigned request_;
+
+    ConnectionDeadline(const ConnectionDeadline&);
+    ConnectionDeadline& operator=(const ConnectionDeadline&);
+};
+
+#endif // CONNECTION_DEADLINE_H
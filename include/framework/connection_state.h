@@ -0,0 +1,48 @@
+// include/framework/connection_state.h
+#ifndef CONNECTION_STATE_H
+#define CONNECTION_STATE_H
+
+#include <string>
+#include <event2/util.h>
+#include <openssl/ssl.h>
+
+// 监听器类型
+enum ListenerKind {
+    LISTENER_TLS,   // 对外HTTPS
+    LISTENER_UNIX,  // Unix域套接字，凭SO_PEERCRED鉴权
+    LISTENER_PLAIN, // 回环地址上的明文HTTP
+    LISTENER_HTTP2, // 经ALPN协商的HTTP/2（TLS）
+    LISTENER_BINARY,        // 长度前缀的二进制帧协议（TLS）
+    LISTENER_BINARY_UNIX    // 二进制帧协议（Unix域套接字，凭SO_PEERCRED鉴权）
+};
+
+// 监听器类型的个数，用于按类型索引的配置数组
+static const int kListenerKindCount = 6;
+
+// 监听器类型的短名称：tls、unix、plain、h2、bin、bin-unix，用于命令行参数与指标标签
+const char* listenerKindName(ListenerKind kind);
+
+// 二进制帧协议的监听器不经过HTTP引擎
+inline bool isBinaryListener(ListenerKind kind) {
+    return kind == LISTENER_BINARY || kind == LISTENER_BINARY_UNIX;
+}
+
+// 连接级状态
+// 校验结果、对端身份、协议与加密套件在握手完成后即固定，
+// 由首个请求计算一次，同一连接上的后续请求直接复用
+struct ConnectionState {
+    ListenerKind kind = LISTENER_TLS;
+    const char* rejectReason = nullptr; // 非空表示连接未通过传输层校验，请求一律以此拒绝
+    bool earlyData = false;             // 握手尚未完成，请求来自0-RTT早期数据（此类状态不缓存）
+    std::string peerIdentity;           // 客户端证书主题，Unix域套接字为"uid:<n>"
+    const char* protocol = nullptr;     // TLS协议版本，明文连接为nullptr
+    const char* cipher = nullptr;       // TLS加密套件，明文连接为nullptr
+    std::string clientIP;
+    ev_uint16_t clientPort = 0;
+    unsigned long requests = 0;         // 该连接上已处理的请求数
+};
+
+// 读取TLS连接的校验结果、协议版本、加密套件与客户端证书主题
+void inspectTlsConnection(SSL* ssl, ConnectionState& state);
+
+#endif // CONNECTION_STATE_H
@@ -0,0 +1,28 @@
+// include/framework/cycle_clock.h
+#ifndef CYCLE_CLOCK_H
+#define CYCLE_CLOCK_H
+
+#include <cstdint>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// 请求各阶段计时用的低开销时钟
+// x86上读时间戳计数器（rdtsc，不进内核，十几纳秒），要求TSC恒速且各核同步（constant_tsc与nonstop_tsc，
+// 近年的x86处理器均满足）；其他架构退回CLOCK_MONOTONIC，计数即纳秒
+inline uint64_t cycleNow() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+#endif
+}
+
+// 每个计数对应的纳秒数，首次调用时对照CLOCK_MONOTONIC校准约10毫秒；
+// 启动时先调用一次，校准不落在请求路径上
+double nanosPerCycle();
+
+#endif // CYCLE_CLOCK_H
@@ -0,0 +1,96 @@
+// include/framework/http2_session.h
+#ifndef HTTP2_SESSION_H
+#define HTTP2_SESSION_H
+
+#ifdef RPC_HAVE_NGHTTP2
+
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <nghttp2/nghttp2.h>
+#include <event2/bufferevent.h>
+#include "framework/connection_deadline.h"
+#include "framework/http_connection.h"
+#include "framework/transport_backend.h"
+
+// 单个HTTP/2连接（服务端）
+// 同一连接上的多个流各自收齐请求体后立即分发，响应按流交错发送：一个流的请求体未收齐
+// 或响应未发完不会挡住其他流。分发本身在事件循环上同步进行，各流的调用并不并发执行；
+// 响应头经HPACK动态表索引，重复的头部只占一两个字节。
+// 待发送的输出达到maxPendingOutput时停止从nghttp2取帧、暂停读取，输出发出后恢复；
+// 超时挂在原生引擎的时间轮上：有流未收齐按请求体超时，有输出待发送按写超时，否则按空闲超时
+class Http2Session {
+public:
+    typedef std::function<void(Http2Session*)> CloseHandler;
+
+    // 接管bev的所有权，bev须已完成TLS握手且ALPN协商为h2；options与timers须比会话存活更久
+    Http2Session(bufferevent* bev, const ConnectionState& state, const RpcDispatcher& dispatcher,
+                 const HttpOptions& options, TimerWheel& timers, const CloseHandler& onClose);
+    ~Http2Session();
+
+    // 发送服务端SETTINGS并开始读取，失败时调用方负责释放会话
+    bool start();
+
+private:
+    // 单个请求流
+    struct Stream {
+        std::string request;
+        std::string response;
+        std::string contentLength;
+        size_t sent = 0;
+        ContentCoding accepted = CODING_IDENTITY; // 按accept-encoding协商出的响应编码
+        ContentCoding encoding = CODING_IDENTITY; // 请求体的content-encoding
+        bool unsupportedEncoding = false;
+        std::string target;                       // :path
+        size_t headerBytes = 0;                   // 按HPACK规则计算的请求头大小
+        size_t declaredLength = 0;                // content-length，未声明时为0
+        size_t bodyLimit = 0;                     // 请求头收齐后确定
+        bool rejected = false;                    // 已以404或413直接回应，后续数据直接丢弃
+        uint64_t receivedCycles = 0;              // 请求头收齐的时刻
+        bool trace = false;                       // 带有x-rpc-trace请求头
+        std::string timing;                       // server-timing响应头，须保留到响应头发出
+    };
+
+    void handleRequest(int32_t streamId, Stream* stream);
+    void rejectRequest(int32_t streamId, Stream* stream, const char* status, const std::string& body);
+    bool flush();
+    bool outputBlocked() const;
+    size_t pendingOutput() const;
+    void updateDeadline();
+    void onTimeout();
+    void close();
+
+    static void readCallback(bufferevent* bev, void* ctx);
+    static void writeCallback(bufferevent* bev, void* ctx);
+    static void eventCallback(bufferevent* bev, short events, void* ctx);
+    static void timeoutCallback(void* arg);
+
+    static int onBeginHeaders(nghttp2_session* session, const nghttp2_frame* frame, void* ctx);
+    static int onHeader(nghttp2_session* session, const nghttp2_frame* frame, const uint8_t* name,
+                        size_t namelen, const uint8_t* value, size_t valuelen, uint8_t flags, void* ctx);
+    static int onDataChunk(nghttp2_session* session, uint8_t flags, int32_t streamId,
+                           const uint8_t* data, size_t len, void* ctx);
+    static int onFrameRecv(nghttp2_session* session, const nghttp2_frame* frame, void* ctx);
+    static int onStreamClose(nghttp2_session* session, int32_t streamId, uint32_t errorCode, void* ctx);
+    static ssize_t readResponse(nghttp2_session* session, int32_t streamId, uint8_t* buf,
+                                size_t length, uint32_t* dataFlags, nghttp2_data_source* source, void* ctx);
+
+    bufferevent* bev_;
+    nghttp2_session* session_;
+    std::unordered_map<int32_t, Stream> streams_; // 进行中的流，数据提供器持有元素指针
+    ConnectionState state_;
+    RpcDispatcher dispatcher_;
+    const HttpOptions& options_;
+    ConnectionDeadline deadline_;
+    unsigned requests_;  // 已分发的请求数，请求体超时按请求计
+    size_t writeMark_;   // 上次计时写超时时的待发送字节数，到期时据此判断期间有无进展
+    bool readPaused_;    // 输出积压，暂停读取
+    CloseHandler onClose_;
+
+    Http2Session(const Http2Session&);
+    Http2Session& operator=(const Http2Session&);
+};
+
+#endif // RPC_HAVE_NGHTTP2
+
+#endif // HTTP2_SESSION_H
@@ -0,0 +1,117 @@
+// include/framework/http_connection.h
+#ifndef HTTP_CONNECTION_H
+#define HTTP_CONNECTION_H
+
+#include <memory>
+#include <string>
+#include <event2/buffer.h>
+#include "framework/compression.h"
+#include "framework/connection_deadline.h"
+#include "framework/http_parser.h"
+#include "framework/transport_backend.h"
+
+class WebSocketConnection;
+
+// WebSocket升级策略（见websocket.h）
+struct WebSocketPolicy {
+    bool enabled = false;                     // 接受Upgrade: websocket
+    bool deflate = false;                     // 接受permessage-deflate（RFC 7692）
+    size_t maxInflatedSize = 8 * 1024 * 1024; // 压缩消息解压后的长度上限
+};
+
+// 连接级HTTP策略，各引擎共用
+struct HttpOptions {
+    unsigned maxRequests = 1000;          // 单个keep-alive连接最多处理的请求数，0表示不限
+    ConnectionTimeouts timeouts;          // 握手、请求头、请求体、空闲与写出超时
+    size_t maxPendingOutput = 256 * 1024; // 响应积压超过此值时暂停处理后续流水线请求
+    bool leanIdle = false;                // 每次响应发送完毕后归还连接缓冲区
+    CompressionPolicy compression;        // 响应压缩策略
+    RequestLimits limits;                 // 本监听器的请求头与请求体上限
+    RouteResolver route;                  // 按请求路径解析路由与方法级请求体上限，为空时只用limits
+    MethodIdResolver methodIds;           // 二进制帧协议（含WebSocket二进制消息）的methodId路由
+    WebSocketPolicy webSocket;
+    bool traceHeader = false;             // 识别X-Rpc-Trace请求头，以Server-Timing返回各阶段耗时
+};
+
+// HTTP/1.1连接状态机：从输入缓冲切分请求、调用RpcDispatcher，响应按到达顺序写入输出缓冲
+// 不涉及任何I/O，原生libevent引擎与io_uring后端共用；请求头直接在读缓冲上解析，
+// 请求体以StringRef交给分发器，整个过程不为请求复制数据。
+// 流水线请求在前面的响应尚未发出时即被解析分发，响应按请求顺序排在输出缓冲中；
+// 积压超过maxPendingOutput时停止处理，由引擎在积压发出后再次调用process。
+// 流式方法的响应以分块传输编码发出，同样按积压逐段拉取，发完之前不处理后续请求
+class HttpConnection {
+public:
+    enum Phase {
+        READ_HEAD,  // 等待完整的请求头
+        READ_BODY,  // 请求头已解析，等待请求体收齐
+        SKIP_BODY,  // 已按路径直接回应，丢弃请求体而不缓冲
+        STREAMING,  // 正在分块发送流式响应
+        UPGRADED,   // 已升级为WebSocket，后续字节交给WebSocketConnection
+        CLOSING     // 不再接受请求，已写出的响应发送完毕后关闭连接
+    };
+
+    // dispatcher、state与options须比HttpConnection存活更久
+    HttpConnection(const RpcDispatcher& dispatcher, ConnectionState& state, const HttpOptions& options);
+    ~HttpConnection();
+
+    // 处理input中所有完整的请求并消费之，不完整的部分留待更多数据到达。
+    // queued为已移出output、尚未发出的字节数（TLS过滤层的底层缓冲、io_uring的待发送队列），计入积压
+    void process(evbuffer* input, evbuffer* output, size_t queued = 0);
+
+    Phase phase() const { return phase_; }
+    bool closing() const;
+    // 流式响应尚未发完，输出发出后即使没有新的输入也应再次调用process
+    bool streaming() const { return phase_ == STREAMING; }
+    // 因错误而在请求未读完时转入CLOSING，对端可能仍在发送请求体
+    bool aborted() const { return aborted_; }
+    // 已开始处理的请求数，请求头与请求体的期限按请求计
+    unsigned served() const { return served_; }
+    // 没有待发送的输出时，连接在等待对端的什么数据
+    TimeoutStage readStage(const evbuffer* input) const;
+
+    // pending为尚未发出的输出字节数（引擎须计入传输层各级缓冲），已达上限时引擎应暂停读取，
+    // 待输出发出后再调用process
+    bool outputBlocked(size_t pending) const {
+        return pending >= options_.maxPendingOutput;
+    }
+
+private:
+    bool readHead(evbuffer* input, evbuffer* output);
+    bool upgrade(const HttpRequest& request, evbuffer* input, evbuffer* output);
+    bool skipBody(evbuffer* input);
+    bool writeStream(evbuffer* output, size_t queued);
+    StringRef connectionHeader() const;
+    StringRef responseHeaders(const RpcCall& call, std::string& scratch) const;
+    void writeResponse(evbuffer* output, RpcCall& call, StringRef headers);
+    void writeError(evbuffer* output, const char* status, const std::string& body = std::string(),
+                    const char* extraHeaders = "");
+
+    const RpcDispatcher& dispatcher_;
+    ConnectionState& state_;
+    const HttpOptions& options_;
+    Phase phase_;
+    unsigned served_; // 本连接已响应的请求数
+    bool aborted_;
+
+    // 当前请求的分帧信息，等待请求体期间读缓冲可能被重新整理，不保留指向它的指针
+    size_t headLength_;
+    size_t contentLength_;
+    size_t targetOffset_; // 请求目标在请求头中的位置
+    size_t targetLength_;
+    bool keepAlive_;
+    int minorVersion_;
+    ContentCoding accepted_; // 按Accept-Encoding协商出的响应编码
+    ContentCoding encoding_; // 请求体的Content-Encoding
+    uint64_t receivedCycles_; // 请求头解析完成的时刻，请求体等待与路由计入read阶段
+    bool trace_;
+
+    std::unique_ptr<ResponseStream> stream_; // STREAMING阶段的响应体
+    std::string chunk_;
+
+    std::unique_ptr<WebSocketConnection> webSocket_; // UPGRADED阶段的会话
+
+    HttpConnection(const HttpConnection&);
+    HttpConnection& operator=(const HttpConnection&);
+};
+
+#endif // HTTP_CONNECTION_H
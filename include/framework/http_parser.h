@@ -0,0 +1,46 @@
+// include/framework/http_parser.h
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <cstddef>
+#include "framework/string_ref.h"
+
+// 单个请求最多保留的请求头个数，超出按错误请求处理
+static const size_t kMaxHttpHeaders = 32;
+
+struct HttpHeader {
+    StringRef name;
+    StringRef value;
+};
+
+// 解析后的请求头部，所有字段均指向调用方的读缓冲，解析过程不分配内存
+struct HttpRequest {
+    StringRef method;
+    StringRef target;
+    int minorVersion = 1;             // HTTP/1.x中的x
+    HttpHeader headers[kMaxHttpHeaders];
+    size_t headerCount = 0;
+
+    size_t headLength = 0;            // 请求行与请求头的总长度（含结尾空行）
+    size_t contentLength = 0;
+    bool keepAlive = true;            // HTTP/1.1默认长连接，HTTP/1.0默认短连接
+    bool upgrade = false;             // Connection头含upgrade，协议由Upgrade头给出
+
+    // 按名称查找请求头（大小写不敏感），不存在时返回nullptr
+    const StringRef* header(const char* name) const;
+};
+
+enum HttpParseResult {
+    HTTP_PARSE_OK,          // 头部完整，request已填充
+    HTTP_PARSE_INCOMPLETE,  // 尚未收到结尾空行
+    HTTP_PARSE_ERROR        // 格式错误或不支持（如分块传输编码）
+};
+
+// 从data开始解析一个HTTP/1.x请求头部，不消费请求体
+HttpParseResult parseHttpRequest(const char* data, size_t len, HttpRequest& request);
+
+// 从形如"/rpc/<Service>/<method>"的请求目标中取出服务名与方法名（忽略查询串）
+// 其他形式的路径返回false，此时方法只能从请求体中得知
+bool parseMethodPath(StringRef target, StringRef& service, StringRef& method);
+
+#endif // HTTP_PARSER_H
@@ -0,0 +1,57 @@
+// include/framework/http_response.h
+#ifndef HTTP_RESPONSE_H
+#define HTTP_RESPONSE_H
+
+#include <string>
+#include <event2/buffer.h>
+#include "framework/compression.h"
+#include "framework/string_ref.h"
+
+// 所有JSON-RPC响应共用的固定响应头，evhttp、原生引擎与HTTP/2共用
+static const char kJsonContentType[] = "application/json";
+static const char kHstsHeaderValue[] = "max-age=63072000; includeSubDomains";
+
+// 预先格式化的HTTP/1.1响应头块
+// 状态行与固定响应头在启动时拼为一块，以"Content-Length: "结尾；
+// 每个响应只补上长度与可选的Connection头，连同响应体以一次evbuffer写入完成
+class ResponseHeaderBlock {
+public:
+    // status形如"200 OK"；extraHeaders为追加在固定头之后的完整头部行（含CRLF）
+    explicit ResponseHeaderBlock(const char* status, const char* extraHeaders = "");
+
+    // connection为完整的头部行（含CRLF，可为多行，如Server-Timing与Connection），不需要时传空
+    void write(evbuffer* output, StringRef body, StringRef connection) const;
+    // 以Transfer-Encoding: chunked代替Content-Length，响应体随后以writeChunk逐段写出
+    void writeChunkedHead(evbuffer* output, StringRef connection) const;
+
+    // 成功响应（200 OK，application/json，HSTS）；响应体经压缩时附带Content-Encoding与Vary
+    static const ResponseHeaderBlock& ok(ContentCoding coding = CODING_IDENTITY);
+    // 404 Not Found，用于路径路由到不存在的方法
+    static const ResponseHeaderBlock& notFound();
+
+private:
+    std::string prefix_;
+    size_t fixedLength_; // prefix_中"Content-Length: "之前的部分
+};
+
+// 分块传输编码：写出一个数据块（空数据不写，以免被当作结束块）
+void writeChunk(evbuffer* output, StringRef data);
+// 结束块，不带尾部头
+static const StringRef kLastChunk("0\r\n\r\n", 5);
+
+// 请求体超出上限时的响应，各引擎在读取请求体之前即以此拒绝
+static const char kPayloadTooLargeStatus[] = "413 Payload Too Large";
+
+// 路径指明的方法不存在时的响应
+static const char kNotFoundStatus[] = "404 Not Found";
+static const StringRef kMethodNotFoundBody(
+    "{\"error\":{\"code\":-32601,\"message\":\"Method not found\"},\"id\":null,\"jsonrpc\":\"2.0\"}", 80);
+
+// 413响应的JSON-RPC错误体
+std::string payloadTooLargeBody(size_t contentLength, size_t limit);
+
+// 可直接传给ResponseHeaderBlock::write的Connection头
+static const StringRef kConnectionClose("Connection: close\r\n", 19);
+static const StringRef kConnectionKeepAlive("Connection: keep-alive\r\n", 24);
+
+#endif // HTTP_RESPONSE_H
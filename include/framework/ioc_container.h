@@ -4,6 +4,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <pthread.h> // 引入pthread库以支持线程安全
 #include "mem_mgmt/safe_ptr.h"
 #include "services/rpc_service.h" // 包含RpcService的头文件
@@ -75,6 +76,20 @@ public:
 #endif
     }
 
+    // 已注册的服务标识
+    std::vector<std::string> serviceIds() const {
+        std::vector<std::string> ids;
+#if CPP11_SUPPORTED
+        for (auto it = factories_.begin(); it != factories_.end(); ++it) {
+#else
+        for (SERVICE_MAP<std::string, SafePtr<ServiceFactoryBase> >::const_iterator it = factories_.begin();
+             it != factories_.end(); ++it) {
+#endif
+            ids.push_back(it->first);
+        }
+        return ids;
+    }
+
     // 单例模式线程安全：
     // C++11及以上：依赖Magic Static特性保证线程安全
     // C++98及以下：需额外添加双检锁(DCLP)实现
@@ -0,0 +1,54 @@
+// include/framework/native_binary.h
+#ifndef NATIVE_BINARY_H
+#define NATIVE_BINARY_H
+
+#include <functional>
+#include <event2/bufferevent.h>
+#include "framework/binary_connection.h"
+#include "framework/native_http.h"
+
+// 二进制帧协议监听器上的单个连接：bufferevent负责收发与TLS，BinaryConnection负责分帧与分发
+class NativeBinaryConnection {
+public:
+    typedef NativeHttpConnection::Inspector Inspector;
+    typedef std::function<void(NativeBinaryConnection*)> CloseHandler;
+
+    // 接管bev的所有权，options与timers须比连接存活更久
+    NativeBinaryConnection(bufferevent* bev, const ConnectionState& state, const HttpOptions& options,
+                           TimerWheel& timers, const Inspector& inspector, const RpcDispatcher& dispatcher,
+                           const CloseHandler& onClose);
+    ~NativeBinaryConnection();
+
+    void start();
+
+private:
+    void onRead();
+    void onWriteDrained();
+    void onTimeout();
+    void updateDeadline();
+    void close();
+
+    static void readCallback(bufferevent* bev, void* ctx);
+    static void writeCallback(bufferevent* bev, void* ctx);
+    static void eventCallback(bufferevent* bev, short events, void* ctx);
+    static void underlyingWriteCallback(bufferevent* bev, void* ctx);
+    static void timeoutCallback(void* arg);
+
+    bufferevent* bev_;
+    ConnectionState state_;
+    bool inspected_;
+    bool peerClosed_; // 对端已关闭写方向，输出发完即关闭
+    bool readPaused_; // 响应积压，暂停读取
+    size_t writeMark_; // 见NativeHttpConnection::writeMark_
+    const HttpOptions& options_;
+    ConnectionDeadline deadline_;
+    Inspector inspector_;
+    RpcDispatcher dispatcher_;
+    CloseHandler onClose_;
+    BinaryConnection frames_; // 引用state_与dispatcher_，须在其后声明
+
+    NativeBinaryConnection(const NativeBinaryConnection&);
+    NativeBinaryConnection& operator=(const NativeBinaryConnection&);
+};
+
+#endif // NATIVE_BINARY_H
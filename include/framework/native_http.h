@@ -0,0 +1,69 @@
+// include/framework/native_http.h
+#ifndef NATIVE_HTTP_H
+#define NATIVE_HTTP_H
+
+#include <functional>
+#include <event2/bufferevent.h>
+#include "framework/connection_deadline.h"
+#include "framework/http_connection.h"
+
+// 原生HTTP/1.1引擎中的单个连接：bufferevent负责收发与TLS，HttpConnection负责分帧与分发
+// 相比evhttp省去了每个请求的evhttp_request、请求头链表与URI解析等分配
+class NativeHttpConnection {
+public:
+    // 检查传输层属性（TLS握手结果、对端凭据等），返回true表示结果已确定、此后无需再查
+    typedef std::function<bool(bufferevent* bev, ConnectionState& state)> Inspector;
+    typedef std::function<void(NativeHttpConnection*)> CloseHandler;
+
+    // 接管bev的所有权，options与timers须比连接存活更久
+    NativeHttpConnection(bufferevent* bev, const ConnectionState& state, const HttpOptions& options,
+                         TimerWheel& timers, const Inspector& inspector, const RpcDispatcher& dispatcher,
+                         const CloseHandler& onClose);
+    ~NativeHttpConnection();
+
+    void start();
+
+    // 连接空闲时释放读写过程中扩充的缓冲区，evhttp模式也使用
+    static void releaseIdleBuffers(bufferevent* bev);
+
+    // 以下供原生引擎的各连接类型选择超时阶段
+    // TLS握手尚未完成，明文连接始终为false
+    static bool handshaking(bufferevent* bev);
+    // 尚未交给内核的输出字节数，含TLS过滤层底层bufferevent中的密文
+    static size_t pendingOutput(bufferevent* bev);
+
+private:
+    void onRead();
+    void onWriteDrained();
+    void onTimeout();
+    void updateDeadline();
+    void finish();
+    void close();
+
+    static void readCallback(bufferevent* bev, void* ctx);
+    static void writeCallback(bufferevent* bev, void* ctx);
+    static void eventCallback(bufferevent* bev, short events, void* ctx);
+    static void underlyingWriteCallback(bufferevent* bev, void* ctx);
+    static void lingerReadCallback(bufferevent* bev, void* ctx);
+    static void timeoutCallback(void* arg);
+
+    bufferevent* bev_;
+    ConnectionState state_;
+    bool inspected_;
+    bool peerClosed_; // 对端已关闭写方向，输出发完即关闭
+    bool readPaused_; // 响应积压，暂停读取与流水线处理
+    bool lingering_;  // 已关闭写方向，丢弃对端剩余的请求体
+    size_t lingerBytes_; // 延迟关闭期间丢弃的字节数
+    size_t writeMark_;   // 上次计时写超时时的待发送字节数，到期时据此判断期间有无进展
+    const HttpOptions& options_;
+    ConnectionDeadline deadline_;
+    Inspector inspector_;
+    RpcDispatcher dispatcher_;
+    CloseHandler onClose_;
+    HttpConnection http_; // 引用state_与dispatcher_，须在其后声明
+
+    NativeHttpConnection(const NativeHttpConnection&);
+    NativeHttpConnection& operator=(const NativeHttpConnection&);
+};
+
+#endif // NATIVE_HTTP_H
@@ -0,0 +1,122 @@
+// include/framework/rpc_metrics.h
+#ifndef RPC_METRICS_H
+#define RPC_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "framework/connection_state.h"
+#include "framework/cycle_clock.h"
+
+// 对数分桶的延迟直方图（HDR风格）：每个2的幂区间再等分为8个子桶，
+// 相对误差不超过12.5%，覆盖0到2^32-1微秒；桶下标只用一次位扫描与移位计算
+struct LatencyBuckets {
+    static const unsigned kSubBits = 3;
+    static const unsigned kCount = (32 - kSubBits + 1) << kSubBits; // 240
+
+    static unsigned index(uint32_t us) {
+        if (us < (1u << kSubBits)) {
+            return us;
+        }
+        const unsigned exponent = 31 - static_cast<unsigned>(__builtin_clz(us));
+        const unsigned sub = (us >> (exponent - kSubBits)) & ((1u << kSubBits) - 1);
+        return ((exponent - kSubBits + 1) << kSubBits) + sub;
+    }
+    // 桶内的最大值（含），即Prometheus的le
+    static uint64_t upperBound(unsigned index);
+};
+
+// JSON-RPC响应码在指标中的分类：0表示成功，其余为协议定义的错误码，不认识的归入最后一类
+static const int kMetricCodes[] = {0, -32700, -32600, -32601, -32602, -32603, -32000};
+static const unsigned kMetricCodeCount = sizeof(kMetricCodes) / sizeof(kMetricCodes[0]) + 1;
+
+// 一次调用经过的阶段，与RpcServer::dispatchRequest中的注释分段对应
+enum RequestPhase {
+    PHASE_READ,     // 传输层：请求头解析完（evhttp为回调入口）到开始分发，含请求体收齐、路由与连接校验
+    PHASE_PARSE,    // JSON解析（含流式解压）与协议版本校验
+    PHASE_PARAMS,   // 取出id与params
+    PHASE_METHOD,   // 方法名解析与规范化
+    PHASE_LOOKUP,   // 从IoC容器定位服务，早期数据检查
+    PHASE_EXECUTE,  // 方法执行（流式方法为打开结果流）
+    PHASE_RESPOND,  // 响应体序列化、审计日志与指标
+    kPhaseCount
+};
+
+// Server-Timing与指标标签中使用的阶段名
+const char* requestPhaseName(RequestPhase phase);
+
+// 一次调用中各阶段的TSC计数：每个阶段结束时mark一次，把上一个标记以来的计数记到该阶段
+// 未启用时不读时钟；提前返回的调用未经过的阶段保持为0
+struct PhaseClock {
+    explicit PhaseClock(bool enabled) : last(enabled ? cycleNow() : 0), enabled(enabled) {
+        for (int i = 0; i < kPhaseCount; ++i) {
+            cycles[i] = 0;
+        }
+    }
+    void mark(RequestPhase phase) {
+        if (enabled) {
+            const uint64_t now = cycleNow();
+            cycles[phase] += now - last;
+            last = now;
+        }
+    }
+
+    uint64_t cycles[kPhaseCount];
+    uint64_t last;
+    bool enabled;
+};
+
+// Server-Timing响应头的值：经过的各阶段与total的毫秒数，如"parse;dur=0.012, ..., total;dur=0.040"
+std::string serverTiming(const PhaseClock& phases);
+
+// 每个分发请求的线程一份的计数，只由该线程写入，读取方跨线程汇总
+// 计数器按[方法][监听器][响应码]排列，直方图按[方法][监听器]排列，阶段耗时按[方法][阶段]排列
+struct MetricsShard {
+    MetricsShard(size_t methods);
+
+    std::vector<std::atomic<uint64_t> > calls;
+    std::vector<std::atomic<uint64_t> > buckets;
+    std::vector<std::atomic<uint64_t> > sumUs;
+    std::vector<std::atomic<uint64_t> > phaseCycles;
+};
+
+// 调用计数与延迟直方图
+// record只访问本线程的分片：定位分片是一次线程局部读取，每个计数是一对relaxed的读与写，
+// 没有锁与原子的读改写指令；导出时汇总各分片，读到的是各计数在某一时刻附近的值。
+// 方法表在启动时由已注册的服务确定，此后不再变化；未注册的方法名一律记为unknown，
+// 客户端无法借任意方法名制造无限多的时间序列
+class RpcMetrics {
+public:
+    static const unsigned kUnknownMethod = 0;
+
+    RpcMetrics();
+
+    // 须在第一次record之前登记完所有方法
+    void addMethod(const std::string& service, const std::string& method);
+    unsigned methodIndex(const std::string& service, const std::string& method) const;
+
+    void record(unsigned method, ListenerKind listener, int code, uint32_t latencyUs, const PhaseClock& phases);
+
+    // 以Prometheus文本格式追加到out，只输出有过调用的时间序列
+    void render(std::string& out) const;
+
+private:
+    MetricsShard* threadShard();
+    static unsigned codeIndex(int code);
+
+    std::vector<std::string> methodNames_; // 下标即方法序号，0为unknown
+    std::unordered_map<std::string, std::unordered_map<std::string, unsigned> > methods_;
+    uint64_t id_;                          // 区分实例，线程缓存的分片只对所属实例有效
+
+    mutable std::mutex shardsMutex_;       // 只在线程首次记录登记分片时与导出竞争
+    std::vector<std::unique_ptr<MetricsShard> > shards_;
+
+    RpcMetrics(const RpcMetrics&);
+    RpcMetrics& operator=(const RpcMetrics&);
+};
+
+#endif // RPC_METRICS_H
@@ -4,33 +4,190 @@
 
 #include <string>
 #include <map>
+#include <cstdint>
 #include <vector> // 添加 vector 头文件包含
+#include <sys/types.h>
 #include <event2/http.h>
 #include <openssl/ssl.h>
 #include <nlohmann/json.hpp> // 添加 json 头文件包含
+#include <unordered_map>
+#include <unordered_set>
+#include "framework/anti_replay_window.h"
+#include "framework/audit_logger.h"
+#include "framework/compression.h"
+#include "framework/connection_state.h"
+#include "framework/http2_session.h"
+#include "framework/native_binary.h"
+#include "framework/native_http.h"
+#include "framework/rpc_metrics.h"
+#include "framework/timer_wheel.h"
+#include "framework/transport_backend.h"
+
+// 服务器可选参数
+struct ServerOptions {
+    bool earlyData = false;         // 启用TLS 1.3 0-RTT早期数据
+    uint32_t maxEarlyData = 16384;  // 单个连接接收早期数据的上限（字节）
+    int replayWindowSec = 600;      // 会话票据可用于早期数据的时间窗口（秒）
+
+    // 供同机sidecar使用的本地监听，跳过TLS开销
+    std::string unixSocketPath;     // Unix域套接字路径，为空则不启用
+    std::vector<uid_t> trustedUids; // 允许接入Unix域套接字的用户，服务进程自身的uid始终允许
+    int plainPort = 0;              // 仅绑定127.0.0.1的明文HTTP端口，0表示不启用
+
+    int http2Port = 0;              // 经ALPN协商h2的HTTP/2端口，0表示不启用（需以NGHTTP2=1构建）
+
+    // 供内部高QPS调用方使用的二进制帧协议（见binary_connection.h），仅libevent后端支持
+    int binaryPort = 0;             // TLS端口，0表示不启用
+    std::string binarySocketPath;   // Unix域套接字路径，鉴权同unixSocketPath，为空则不启用
+
+    // HTTP/1.1监听（原生引擎与io_uring后端）上的WebSocket升级，供长连接双向会话使用
+    bool webSocket = false;
+    bool webSocketDeflate = false;  // 协商permessage-deflate
+
+    std::string backend = "libevent"; // 传输后端：libevent或io_uring（需以LIBURING=1构建）
+    std::string httpEngine = "native"; // libevent后端的HTTP/1.1引擎：native，或evhttp（兼容模式）
+
+    // 空闲连接省内存模式：释放OpenSSL读写缓冲，每次响应后归还连接缓冲区
+    bool leanIdle = false;
+
+    // HTTP/1.1连接策略
+    unsigned keepAliveRequests = 1000; // 单个keep-alive连接最多处理的请求数，0表示不限
+    // 握手、请求头、请求体、keep-alive空闲与写出超时（见connection_deadline.h），
+    // 原生引擎、二进制帧协议与io_uring后端按阶段计时；evhttp兼容模式只用idleSec作为读写超时
+    ConnectionTimeouts timeouts;
+    unsigned maxConnections = 0;       // 原生引擎与HTTP/2同时保持的连接数上限，达到后暂停accept，0表示不限
+
+    // 响应压缩：按Accept-Encoding协商gzip/zstd，各传输共用
+    CompressionPolicy compression;
+    size_t maxDecompressedSize = 8 * 1024 * 1024; // 压缩请求体解压后的长度上限，防御压缩炸弹
+
+    // 按监听器类型（ListenerKind）分别配置的请求头与请求体上限，方法可经MethodOptions单独放宽或收紧
+    RequestLimits limits[kListenerKindCount];
+
+    // 审计日志：由后台线程批量写入JSON行或二进制段文件，path为空则不记录
+    AuditOptions audit;
+
+    // 仅绑定127.0.0.1的管理端口，GET /metrics以Prometheus文本格式导出调用计数与延迟直方图；
+    // 0表示不启用，此时也不统计。仅libevent后端支持
+    int adminPort = 0;
+    // 带X-Rpc-Trace请求头的HTTP请求以Server-Timing响应头返回各阶段耗时，仅用于调试
+    bool debugTrace = false;
+};
+
+class RpcServer;
+struct EvhttpStream;
+
+// 每个监听器使用独立的evhttp实例（兼容模式）或evconnlistener（原生引擎），
+// 请求统一交给RpcServer分发
+struct Listener {
+    RpcServer* server;
+    ListenerKind kind;
+    evhttp* http;             // 原生引擎下为nullptr
+    evconnlistener* native;   // evhttp模式下为nullptr
+};
 
 class RpcServer {
 public:
-    RpcServer(int port, const char* certPath, const char* keyPath);
+    RpcServer(int port, const char* certPath, const char* keyPath,
+              const ServerOptions& options = ServerOptions());
     void start();
 
+    // JSON-RPC响应体的序列化，与传输及服务器实例无关（bench/framework_bench直接测量）
+    static std::string successBody(const nlohmann::json& result, const nlohmann::json& id);
+    static std::string errorBody(int code, const std::string& message, const nlohmann::json& id);
+
 private:
     static bufferevent* bevCallback(event_base* base, void* arg);
+    static int allowEarlyDataCallback(SSL* ssl, void* arg);
     void requestHandler(evhttp_request* req, void* arg);
-    void logAudit(const std::map<std::string, std::string>& auditData); // 添加 logAudit 函数声明
 
-    // 添加 splitUri 函数声明
-    std::vector<std::string> splitUri(const std::string& uri);
+    Listener* addListener(ListenerKind kind);
+    bool bindListener(Listener* listener, const char* address, int port);
+    bool acceptSocket(Listener* listener, evutil_socket_t fd);
+    bool bindUnixSocket(Listener* listener, const std::string& path);
+    bool isTrustedPeer(evutil_socket_t fd, std::string& identity) const;
+
+    // 连接级状态
+    ConnectionState* getConnectionState(evhttp_connection* conn, const Listener* listener,
+                                        ConnectionState& scratch);
+    bool inspectConnection(evhttp_connection* conn, const Listener* listener,
+                           ConnectionState& state) const;
+    bool inspectTransport(bufferevent* bev, ConnectionState& state) const;
+    static void logConnection(const ConnectionState& state);
+    static void connectionClosedCallback(evhttp_connection* conn, void* arg);
+    static void requestCompleteCallback(evhttp_request* req, void* arg);
+
+    // 原生HTTP/1.1引擎：接受连接后交给NativeHttpConnection
+    static void nativeAcceptCallback(evconnlistener* listener, evutil_socket_t fd,
+                                     sockaddr* addr, int socklen, void* arg);
+    bufferevent* newTlsBufferevent(evutil_socket_t fd);
+    // --max-connections：原生引擎与HTTP/2的连接（含握手中的）合计达到上限时暂停所有这类监听器的accept
+    size_t connectionCount() const;
+    void setAcceptEnabled(bool enabled);
+    void onConnectionOpened();
+    void onConnectionClosed();
+    static void timerTickCallback(evutil_socket_t fd, short events, void* arg);
+
+    // 二进制帧协议：启动时为已注册的方法计算methodId
+    void buildBinaryMethodTable();
+    bool resolveMethodId(uint32_t methodId, StringRef& target) const;
+
+    void freeResources();
+
+    // 管理端口：调用量与延迟指标
+    bool bindAdmin(int port);
+    static void metricsCallback(evhttp_request* req, void* arg);
+
+    // io_uring后端自行接收TLS与明文回环连接，不经过evhttp
+    void initUringBackend(int port);
+
+    // 执行JSON-RPC调用，返回响应体
+    RpcDispatcher makeDispatcher();
+    std::string dispatchRequest(RpcCall& call, const ConnectionState& connState);
+    RequestRoute resolveRoute(StringRef target, size_t listenerLimit);
+    void sendJsonResponse(evhttp_request* req, const std::string& body,
+                          ContentCoding coding = CODING_IDENTITY);
+
+    // evhttp兼容模式下的流式响应：evhttp_send_reply_start/chunk，输出积压达到上限后等发空再继续
+    void startEvhttpStream(evhttp_request* req, const Listener* listener, std::unique_ptr<ResponseStream> body);
+    void pumpEvhttpStream(EvhttpStream* stream);
+    static void evhttpStreamDrainedCallback(evhttp_connection* conn, void* arg);
 
-    // 添加 sendSuccessResponse 函数声明
-    void sendSuccessResponse(evhttp_request* req, const nlohmann::json& result, const nlohmann::json& id);
+#ifdef RPC_HAVE_NGHTTP2
+    // HTTP/2监听：与HTTPS监听共用SSL_CTX，以ALPN区分协议
+    bool bindHttp2(int port);
+    static int alpnSelectCallback(SSL* ssl, const unsigned char** out, unsigned char* outlen,
+                                  const unsigned char* in, unsigned int inlen, void* arg);
+    static void http2AcceptCallback(evconnlistener* listener, evutil_socket_t fd,
+                                    sockaddr* addr, int socklen, void* arg);
+    static void http2HandshakeCallback(bufferevent* bev, short events, void* arg);
 
-    // 添加 sendErrorResponse 函数声明
-    void sendErrorResponse(evhttp_request* req, int code, const std::string& message, const nlohmann::json& id);
+    evconnlistener* h2Listener_ = nullptr;
+    std::unordered_set<Http2Session*> h2Sessions_;
+    size_t h2Handshakes_ = 0; // 尚未完成TLS握手的HTTP/2连接
+#endif
 
     SSL_CTX* sslCtx_;
     event_base* base_;
     evhttp* http_;
+    std::vector<Listener*> listeners_;
+    std::vector<std::string> unixSockets_; // 本实例创建的套接字文件，析构时删除
+    std::unordered_map<evhttp_connection*, ConnectionState*> connections_;
+    std::unordered_map<evhttp_connection*, EvhttpStream*> evhttpStreams_; // 进行中的流式响应
+    std::unordered_set<NativeHttpConnection*> nativeConnections_;
+    std::unordered_set<NativeBinaryConnection*> binaryConnections_;
+    std::unordered_map<uint32_t, std::string> binaryMethods_; // methodId -> /rpc/<Service>/<method>
+    HttpOptions httpOptions_[kListenerKindCount]; // 按监听器类型索引
+    std::unordered_map<std::string, size_t> methodBodyLimits_; // "Service/method" -> 上限，0表示沿用监听器
+    bool acceptPaused_ = false;
+    ServerOptions options_;
+    AntiReplayWindow replayWindow_;
+    TransportBackend* backend_ = nullptr;
+    TimerWheel timers_;            // 原生引擎各连接的超时
+    event* timerTick_ = nullptr;   // 驱动timers_的周期事件
+    AuditLogger audit_;
+    RpcMetrics metrics_;
+    evhttp* admin_ = nullptr;      // 管理端口
 };
 
 #endif // RPC_SERVER_H
\ No newline at end of file
@@ -0,0 +1,33 @@
+// include/framework/string_ref.h
+#ifndef STRING_REF_H
+#define STRING_REF_H
+
+#include <string>
+#include <cstring>
+#include <strings.h>
+
+// 指向外部缓冲的只读字符串片段，不持有内存（C++11没有std::string_view）
+// 生命周期由所指缓冲决定，缓冲被修改或释放后不可再使用
+struct StringRef {
+    const char* data;
+    size_t size;
+
+    StringRef() : data(nullptr), size(0) {}
+    StringRef(const char* d, size_t n) : data(d), size(n) {}
+    StringRef(const std::string& s) : data(s.data()), size(s.size()) {}
+
+    bool empty() const { return size == 0; }
+
+    bool equals(const char* s) const {
+        return strlen(s) == size && memcmp(data, s, size) == 0;
+    }
+
+    // HTTP头名称等大小写不敏感的比较
+    bool equalsIgnoreCase(const char* s) const {
+        return strlen(s) == size && strncasecmp(data, s, size) == 0;
+    }
+
+    std::string str() const { return std::string(data, size); }
+};
+
+#endif // STRING_REF_H
@@ -0,0 +1,75 @@
+// include/framework/timer_wheel.h
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstdint>
+
+// 定时器链表节点，时间轮的每个槽以一个节点作为环形链表的哨兵
+struct TimerLink {
+    TimerLink* prev;
+    TimerLink* next;
+};
+
+// 挂在TimerWheel上的定时器，通常内嵌在连接对象中，析构时自动从轮上摘除
+class WheelTimer : private TimerLink {
+public:
+    typedef void (*Callback)(void* arg);
+
+    WheelTimer(Callback callback, void* arg);
+    ~WheelTimer() { cancel(); }
+
+    bool pending() const { return prev != nullptr; }
+    void cancel();
+
+private:
+    friend class TimerWheel;
+    uint64_t expires_; // 到期的tick
+    Callback callback_;
+    void* arg_;
+
+    WheelTimer(const WheelTimer&);
+    WheelTimer& operator=(const WheelTimer&);
+};
+
+// 分层时间轮：4级、每级64槽，第0级一个槽对应一个tick，上一级的一个槽对应下一级转一圈。
+// 定时器按剩余时间挂到对应级别的槽中，第0级转完一圈时把上一级当前槽中的定时器重新分配下来。
+// 挂入、取消与重设均为O(1)，每个tick只处理一个槽，大量连接共用一个驱动定时事件，
+// 不必为每个连接在libevent的最小堆中维护各自的超时事件。
+// 精度为一个tick，定时器可能晚至多一个tick触发，不会提前；超出4级范围的时长按最大值计。
+// 不是线程安全的，只能在驱动它的事件循环线程中使用
+class TimerWheel {
+public:
+    explicit TimerWheel(unsigned tickMs);
+
+    // delayMs毫秒后触发；已在轮上的定时器先摘除再重新挂入
+    void schedule(WheelTimer* timer, uint64_t delayMs);
+
+    // 处理截至当前时刻的所有tick，按到期先后触发回调。
+    // 回调中可以重设或取消任何定时器，也可以销毁其所属对象（此时定时器已摘除）
+    void advance();
+
+    unsigned tickMs() const { return tickMs_; }
+
+    // CLOCK_MONOTONIC_COARSE毫秒数，不受系统时间调整影响
+    static uint64_t monotonicMs();
+
+private:
+    static const unsigned kLevels = 4;
+    static const unsigned kSlotBits = 6;
+    static const unsigned kSlots = 1u << kSlotBits;
+
+    uint64_t nowTick() const;
+    void place(WheelTimer* timer);
+    unsigned cascade(unsigned level);
+    static void link(TimerLink* head, TimerLink* node);
+
+    TimerLink slots_[kLevels][kSlots];
+    uint64_t current_; // 下一个待处理的tick
+    uint64_t originMs_;
+    unsigned tickMs_;
+
+    TimerWheel(const TimerWheel&);
+    TimerWheel& operator=(const TimerWheel&);
+};
+
+#endif // TIMER_WHEEL_H
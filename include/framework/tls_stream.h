@@ -0,0 +1,66 @@
+// include/framework/tls_stream.h
+#ifndef TLS_STREAM_H
+#define TLS_STREAM_H
+
+#include <cstdint>
+#include <openssl/ssl.h>
+#include <event2/event.h>
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+
+// 基于内存BIO的TLS会话，密文的收发由调用方负责搬运
+// 与bufferevent_openssl不同，握手阶段通过SSL_read_early_data驱动，
+// 因此可以接收TLS 1.3 0-RTT早期数据
+class TlsStream {
+public:
+    explicit TlsStream(SSL* ssl); // 接管ssl的所有权
+    ~TlsStream();
+
+    // 消费ciphertextIn中的全部密文，解密出的明文追加到plaintext，
+    // 握手等需要回送的记录追加到ciphertextOut。返回false表示连接应当关闭
+    bool decrypt(evbuffer* ciphertextIn, evbuffer* plaintext, evbuffer* ciphertextOut);
+
+    // 加密plaintext中至多limit字节的数据写入ciphertextOut；
+    // 握手尚未完成且已过0-RTT阶段时，未能发送的明文保留在plaintext中
+    bool encrypt(evbuffer* plaintext, evbuffer* ciphertextOut, size_t limit = SIZE_MAX);
+
+    SSL* ssl() const { return ssl_; }
+
+    // 连接空闲时调用：内存BIO扩容后不会缩小，无残留数据时替换为新的空BIO
+    void releaseBuffers();
+
+    // 握手未完成时收到的明文均来自早期数据，可能被重放
+    bool inEarlyData() const { return SSL_in_init(ssl_) != 0; }
+
+    // 创建以TlsStream为过滤层的bufferevent，可直接交给evhttp_set_bevcb使用。
+    // 底层bufferevent设有写高水位，超出的明文留在过滤层的输出缓冲中，
+    // 与bufferevent_openssl一样，输出缓冲的长度即为尚未发出的积压
+    static bufferevent* newBufferevent(event_base* base, SSL* ssl);
+
+    // 查找newBufferevent创建的bufferevent对应的TlsStream，其他bufferevent返回NULL
+    static TlsStream* fromBufferevent(bufferevent* bev);
+
+private:
+    void flushCiphertext(evbuffer* ciphertextOut);
+
+    static bufferevent_filter_result inputFilter(evbuffer* src, evbuffer* dst,
+        ev_ssize_t limit, bufferevent_flush_mode mode, void* ctx);
+    static bufferevent_filter_result outputFilter(evbuffer* src, evbuffer* dst,
+        ev_ssize_t limit, bufferevent_flush_mode mode, void* ctx);
+    static void outputAddedCallback(evbuffer* buffer, const evbuffer_cb_info* info, void* ctx);
+    static void flushCallback(evutil_socket_t fd, short events, void* ctx);
+    static void freeStream(void* ctx);
+
+    SSL* ssl_;
+    BIO* rbio_;        // 收到的密文，由SSL读取
+    BIO* wbio_;        // SSL产生的密文，等待发送
+    bool earlyPhase_;  // SSL_read_early_data尚未返回FINISH
+    bool earlyRead_;   // 已成功读取过早期数据，此后允许发送0.5-RTT数据
+    bufferevent* bev_; // newBufferevent创建的过滤层bufferevent
+    event* flushEvent_; // 补发输出过滤的一次性事件
+
+    TlsStream(const TlsStream&);
+    TlsStream& operator=(const TlsStream&);
+};
+
+#endif // TLS_STREAM_H
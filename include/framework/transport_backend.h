@@ -0,0 +1,85 @@
+// include/framework/transport_backend.h
+#ifndef TRANSPORT_BACKEND_H
+#define TRANSPORT_BACKEND_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <functional>
+#include <event2/event.h>
+#include "framework/compression.h"
+#include "framework/connection_state.h"
+#include "framework/string_ref.h"
+
+// 请求头与请求体的长度上限，按监听器分别配置
+struct RequestLimits {
+    size_t maxHeaderSize = 8192;            // 请求行与请求头的总长度，超出时以431响应
+    size_t maxBodySize = 4 * 1024 * 1024;   // 请求体长度，按Content-Length在读取请求体之前拒绝
+};
+
+// 按请求目标（/rpc/<Service>/<method>）在读取请求体之前解析出的路由
+struct RequestRoute {
+    bool found = true;      // 路径指明的方法不存在时为false，应直接以404回应而不解析请求体
+    size_t bodyLimit = 0;   // 本请求的请求体上限：方法设置了上限时以方法为准，否则为监听器的上限
+};
+
+// 路径未指明方法时返回found=true与监听器的上限，方法留待从请求体中得知
+typedef std::function<RequestRoute(StringRef target, size_t listenerLimit)> RouteResolver;
+
+// 二进制帧协议：把methodId映射为请求目标/rpc/<Service>/<method>，未知的methodId返回false
+typedef std::function<bool(uint32_t methodId, StringRef& target)> MethodIdResolver;
+
+// 分段产生的响应体：传输在输出积压低于上限时逐段拉取，响应体不必整体驻留内存
+class ResponseStream {
+public:
+    virtual ~ResponseStream() {}
+
+    // 把下一段响应体写入chunk（调用前已清空），返回false表示这是最后一段
+    // 抛出异常表示响应体无法完成，传输应中止连接而不是发出看似完整的响应
+    virtual bool next(std::string& chunk) = 0;
+};
+
+// 一次JSON-RPC调用：传输层填入请求体，分发器填回响应体及所调方法的响应属性
+struct RpcCall {
+    StringRef body;             // 指向调用方的读缓冲，调用期间须保持有效
+    ContentCoding encoding = CODING_IDENTITY; // 请求体的Content-Encoding，由分发器流式解压
+    StringRef target;           // 请求目标（路径），与body同样指向调用方的缓冲
+    bool streamable = false;    // 传输支持分块发送响应（HTTP/1.1），由传输层在分发前设置
+    std::string response;
+    std::unique_ptr<ResponseStream> stream; // 调用了流式方法且streamable时代替response
+    bool compressible = true;   // 所调用的方法允许压缩响应
+    uint64_t receivedCycles = 0; // 传输层解析完请求头时的cycleNow()，0表示传输层不计时
+    bool trace = false;         // 请求带有X-Rpc-Trace头（仅在--debug-trace时由传输层识别）
+    std::string timing;         // 追踪请求的各阶段耗时，传输层以Server-Timing响应头返回
+
+    explicit RpcCall(StringRef requestBody) : body(requestBody) {}
+};
+
+// 执行一次JSON-RPC调用，各传输后端与协议共用
+typedef std::function<void(RpcCall& call, ConnectionState& state)> RpcDispatcher;
+
+// 传输后端：负责接收连接、收发字节，并把完整的请求交给RpcDispatcher
+// 启动时由--backend选择，RpcServer只依赖此接口驱动事件循环
+class TransportBackend {
+public:
+    virtual ~TransportBackend() {}
+
+    virtual const char* name() const = 0;
+
+    // 运行事件循环，直到没有活动的监听与连接
+    virtual void run() = 0;
+};
+
+// 默认后端：libevent事件循环，连接由原生HTTP引擎或evhttp（及HTTP/2监听）处理
+class LibeventBackend : public TransportBackend {
+public:
+    explicit LibeventBackend(event_base* base) : base_(base) {}
+
+    const char* name() const override { return "libevent"; }
+    void run() override;
+
+private:
+    event_base* base_; // 不持有，由RpcServer释放
+};
+
+#endif // TRANSPORT_BACKEND_H
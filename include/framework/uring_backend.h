@@ -0,0 +1,87 @@
+// include/framework/uring_backend.h
+#ifndef URING_BACKEND_H
+#define URING_BACKEND_H
+
+#ifdef RPC_HAVE_LIBURING
+
+#include <vector>
+#include <unordered_set>
+#include <liburing.h>
+#include <openssl/ssl.h>
+#include "framework/http_connection.h"
+#include "framework/timer_wheel.h"
+#include "framework/transport_backend.h"
+
+// io_uring传输后端（需内核6.0+）
+// 监听套接字使用multishot accept，连接使用multishot recv，接收缓冲取自向内核注册的
+// 共享缓冲环而不是每连接独占；每轮循环产生的所有提交合并为一次io_uring_submit_and_wait。
+// TLS复用TlsStream的内存BIO实现，HTTP/1.1由HttpConnection分帧，支持keep-alive与流水线；
+// 尚未发出的响应达到maxPendingOutput时停止分发并撤销接收，发完后恢复。
+// 各连接的超时挂在后端自己的时间轮上，由一个反复提交的IORING_OP_TIMEOUT驱动
+class UringBackend : public TransportBackend {
+public:
+    UringBackend(SSL_CTX* sslCtx, const RpcDispatcher& dispatcher);
+    ~UringBackend() override;
+
+    // 初始化提交队列与接收缓冲环
+    bool init();
+
+    // 添加监听地址，tls为false时提供明文HTTP；options须比后端存活更久
+    bool listen(const char* address, int port, bool tls, const HttpOptions& options);
+
+    const char* name() const override { return "io_uring"; }
+    void run() override;
+
+private:
+    struct Connection;
+
+    struct ListenSocket {
+        int fd;
+        bool tls;
+        const HttpOptions* options; // 本监听器的连接策略与请求上限
+    };
+
+    // 提交项的user_data：低3位为操作类型，其余为连接指针或监听器下标
+    enum Op { OP_ACCEPT = 1, OP_RECV = 2, OP_SEND = 3, OP_TICK = 4, OP_CANCEL = 5 };
+
+    io_uring_sqe* getSqe();
+    void armAccept(size_t index);
+    void armRecv(Connection* conn);
+    void armSend(Connection* conn);
+    void armTick();
+    void pauseReading(Connection* conn);
+
+    void onAccept(size_t index, const io_uring_cqe* cqe);
+    void onRecv(Connection* conn, const io_uring_cqe* cqe);
+    void onSend(Connection* conn, const io_uring_cqe* cqe);
+
+    bool handleInput(Connection* conn, const char* data, size_t len);
+    bool flushRequests(Connection* conn);
+    bool handleRequests(Connection* conn);
+    static bool outputBlocked(const Connection* conn);
+    void recycleBuffer(unsigned short bufferId);
+    void closeConnection(Connection* conn);
+    void linger(Connection* conn);
+    void releaseIfIdle(Connection* conn);
+    void updateDeadline(Connection* conn, bool wrote = false);
+    static void connectionTimeout(void* arg);
+    static void destroyConnection(Connection* conn);
+
+    io_uring ring_;
+    bool ringReady_;
+    io_uring_buf_ring* bufRing_;  // 内核提供缓冲环
+    char* bufPool_;               // 缓冲环引用的内存
+    SSL_CTX* sslCtx_;
+    RpcDispatcher dispatcher_;
+    std::vector<ListenSocket> listeners_;
+    std::unordered_set<Connection*> connections_;
+    TimerWheel timers_;
+    __kernel_timespec tick_; // 驱动timers_的超时间隔
+
+    UringBackend(const UringBackend&);
+    UringBackend& operator=(const UringBackend&);
+};
+
+#endif // RPC_HAVE_LIBURING
+
+#endif // URING_BACKEND_H
@@ -0,0 +1,92 @@
+// include/framework/websocket.h
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <event2/buffer.h>
+#include "framework/binary_connection.h"
+#include "framework/http_parser.h"
+#include "framework/transport_backend.h"
+
+// WebSocket（RFC 6455）长连接会话：HTTP/1.1连接经Upgrade握手后转为双向消息通道
+//   文本消息：一个JSON-RPC请求对象，响应作为一条文本消息返回
+//   二进制消息：一个或多个完整的二进制请求帧（格式见binary_connection.h），响应帧合为一条二进制消息返回
+// 客户端可连续发送多个请求而不必等待响应，以JSON-RPC的id或二进制帧的requestId对应响应，
+// 不得假设响应按请求顺序到达。这是协议约定：当前服务端在事件循环上逐条同步分发，
+// 调用之间不并发执行，响应实际按消息顺序返回。升级策略见HttpOptions::webSocket
+
+// 握手协商出的会话参数
+struct WebSocketSettings {
+    bool deflate = false;
+    int serverWindowBits = 15; // 服务端压缩窗口，客户端以server_max_window_bits限定
+};
+
+enum WebSocketHandshake {
+    WS_HANDSHAKE_OK,           // 已写出101响应
+    WS_HANDSHAKE_BAD_REQUEST,  // 缺少或错误的握手头，以400拒绝
+    WS_HANDSHAKE_BAD_VERSION   // 不支持的Sec-WebSocket-Version，以426拒绝并给出支持的版本
+};
+
+// 426响应附带的头部行
+static const char kWebSocketVersionHeader[] = "Sec-WebSocket-Version: 13\r\n";
+
+// 校验升级请求（调用方已确认Connection含upgrade），通过时写出101响应并填充settings
+WebSocketHandshake acceptWebSocket(const HttpRequest& request, const WebSocketPolicy& policy,
+                                   evbuffer* output, WebSocketSettings& settings);
+
+// 关闭帧中的状态码
+enum WebSocketCloseCode {
+    WS_CLOSE_NORMAL = 1000,
+    WS_CLOSE_PROTOCOL_ERROR = 1002,
+    WS_CLOSE_INVALID_DATA = 1007,
+    WS_CLOSE_TOO_BIG = 1009
+};
+
+// 握手完成后的消息分帧与分发：与HttpConnection一样不涉及I/O，由其在UPGRADED阶段转交
+// 单帧消息直接在读缓冲上解除掩码并分发，分片消息才拼接；控制帧可插在分片之间
+class WebSocketConnection {
+public:
+    // dispatcher、state与options须比WebSocketConnection存活更久
+    WebSocketConnection(const RpcDispatcher& dispatcher, ConnectionState& state, const HttpOptions& options,
+                        const WebSocketSettings& settings);
+    ~WebSocketConnection();
+
+    void process(evbuffer* input, evbuffer* output);
+
+    // 已发出关闭帧，输出发送完毕后关闭连接
+    bool closing() const { return closing_; }
+
+private:
+    bool readFrame(evbuffer* input, evbuffer* output);
+    void handleControl(unsigned opcode, const char* payload, size_t length, evbuffer* output);
+    void handleMessage(unsigned opcode, bool compressed, StringRef data, evbuffer* output);
+    void handleBinary(StringRef data, evbuffer* output);
+    void sendMessage(evbuffer* output, unsigned opcode, StringRef body, bool compressible);
+    void writeFrame(evbuffer* output, unsigned char first, StringRef payload);
+    void close(evbuffer* output, WebSocketCloseCode code);
+
+    const RpcDispatcher& dispatcher_;
+    ConnectionState& state_;
+    const HttpOptions& options_;
+    WebSocketSettings settings_;
+    bool closing_;
+
+    // 进行中的分片消息，messageOpcode_为0表示没有
+    unsigned messageOpcode_;
+    bool messageCompressed_;
+    std::string message_;
+    std::string inflated_;
+    std::string deflated_;
+
+    // 二进制消息交给二进制帧协议的状态机处理，经这两个缓冲往返
+    BinaryConnection frames_;
+    evbuffer* framesIn_;
+    evbuffer* framesOut_;
+
+    WebSocketConnection(const WebSocketConnection&);
+    WebSocketConnection& operator=(const WebSocketConnection&);
+};
+
+#endif // WEBSOCKET_H
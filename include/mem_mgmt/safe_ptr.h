@@ -7,6 +7,8 @@
 #include "weak_ptr.h"
 
 // 安全指针类，支持线程安全的引用计数
+// 各实例的互斥量只保护实例自身的成员；多个实例共享的计数用原子指令增减，
+// 否则从同一指针拷贝出的副本在各自析构时会丢失更新
 template<typename T>
 class SafePtr {
 public:
@@ -16,7 +18,7 @@ public:
     }
     ~SafePtr() {
         LockGuard lock(&mutex_);
-        if (--(*refCount_) == 0) {
+        if (__sync_sub_and_fetch(refCount_, 1) == 0) {
             if (deleter_) {
                 deleter_(ptr_);
             } else {
@@ -40,7 +42,7 @@ public:
         if (this != &other) {
             LockGuard lock1(&mutex_);
             LockGuard lock2(&other.mutex_);
-            if (--(*refCount_) == 0) {
+            if (__sync_sub_and_fetch(refCount_, 1) == 0) {
                 if (deleter_) {
                     deleter_(ptr_);
                 } else {
@@ -51,7 +53,7 @@ public:
             ptr_ = other.ptr_;
             refCount_ = other.refCount_;
             deleter_ = other.deleter_;
-            (*refCount_)++;
+            __sync_add_and_fetch(refCount_, 1);
         }
         return *this;
     }
@@ -61,7 +63,7 @@ public:
         if (this != &other) {
             LockGuard lock1(&mutex_);
             LockGuard lock2(&other.mutex_);
-            if (--(*refCount_) == 0) {
+            if (__sync_sub_and_fetch(refCount_, 1) == 0) {
                 if (deleter_) {
                     deleter_(ptr_);
                 } else {
@@ -105,7 +107,7 @@ public:
     }
     void reset(T* ptr = NULL, void (*deleter)(T*) = NULL) {
         LockGuard lock(&mutex_);
-        if (--(*refCount_) == 0) {
+        if (__sync_sub_and_fetch(refCount_, 1) == 0) {
             if (deleter_) {
                 deleter_(ptr_);
             } else {
@@ -20,6 +20,9 @@ private:
 
     // 处理 subtract 方法的静态函数
     static nlohmann::json subtractHandler(void* context, const nlohmann::json& params);
+
+    // 处理 range 方法的静态函数
+    static ResultStream* rangeHandler(void* context, const nlohmann::json& params);
 #endif
 };
 
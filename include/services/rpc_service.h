@@ -2,10 +2,13 @@
 #ifndef RPC_SERVICE_H
 #define RPC_SERVICE_H
 
+#include <memory>
 #include <string>
 #include <stdexcept>
+#include <vector>
 #include <nlohmann/json.hpp>
 #if CPP11_SUPPORTED
+#include <functional>
 #include <unordered_map>
 #endif
 
@@ -18,14 +21,60 @@
     #endif
 #endif
 
+// 方法级属性，注册时随处理函数一并登记
+struct MethodOptions {
+    // 幂等且可安全重放：只有带此标记的方法才会接受TLS 1.3 0-RTT早期数据中的请求
+    bool replaySafe;
+    // 允许压缩响应体：结果本身已是压缩数据或高熵内容时应关闭，避免白费CPU
+    bool compressible;
+    // 请求体长度上限（字节），0表示沿用监听器的上限；只在请求路径指明了方法时生效
+    size_t maxBodySize;
+
+    MethodOptions() : replaySafe(false), compressible(true), maxBodySize(0) {}
+};
+
+// 流式方法的结果：逐个产生result数组的元素
+// 服务端按连接的输出积压拉取，积压达到上限时暂停，整个结果不必驻留内存，首个元素产生后即可开始发送
+class ResultStream {
+public:
+    virtual ~ResultStream() {}
+
+    // 产生下一个元素，没有更多元素时返回false
+    // 抛出异常时响应已部分发出，服务端中止连接（分块响应不以结束块收尾），客户端据此得知结果不完整
+    virtual bool next(nlohmann::json& element) = 0;
+};
+
+#if CPP11_SUPPORTED
+// 以函数实现的ResultStream，函数语义同next，适合在lambda中维护游标
+class GeneratorStream : public ResultStream {
+public:
+    explicit GeneratorStream(std::function<bool(nlohmann::json&)> generator) : generator_(generator) {}
+
+    bool next(nlohmann::json& element) override { return generator_(element); }
+
+private:
+    std::function<bool(nlohmann::json&)> generator_;
+};
+#endif
+
 class RpcService {
 public:
 #if CPP11_SUPPORTED
     // C++11实现版本
     using MethodHandler = std::function<nlohmann::json(const nlohmann::json&)>;
+    // 流式方法：校验参数后返回结果流，参数错误等在此抛出时按普通错误响应
+    using StreamHandler = std::function<std::unique_ptr<ResultStream>(const nlohmann::json&)>;
     
-    void registerMethod(const std::string& name, MethodHandler handler) {
+    void registerMethod(const std::string& name, MethodHandler handler,
+                        const MethodOptions& options = MethodOptions()) {
         methodHandlers_[name] = handler;
+        methodOptions_[name] = options;
+    }
+
+    void registerStreamMethod(const std::string& name, StreamHandler handler,
+                              const MethodOptions& options = MethodOptions()) {
+        streamHandlers_[name] = handler;
+        methodOptions_[name] = options;
     }
 #else
     // C++98兼容版本
@@ -38,11 +87,109 @@ public:
 
     void registerMethod(const std::string& name, 
                        MethodHandler handler, 
-                       void* context) {
+                       void* context,
+                       const MethodOptions& options = MethodOptions()) {
         HandlerInfo info = { handler, context };
         methodHandlers_[name] = info;
+        methodOptions_[name] = options;
     }
+
+    // 返回的结果流由调用方delete
+    typedef ResultStream* (*StreamHandler)(void* context, const nlohmann::json&);
+
+    struct StreamHandlerInfo {
+        StreamHandler handler;
+        void* context;
+    };
+
+    void registerStreamMethod(const std::string& name,
+                              StreamHandler handler,
+                              void* context,
+                              const MethodOptions& options = MethodOptions()) {
+        StreamHandlerInfo info = { handler, context };
+        streamHandlers_[name] = info;
+        methodOptions_[name] = options;
+    }
+#endif
+
+    // 方法是否允许在0-RTT早期数据中调用，未注册的方法一律视为不可重放
+    bool isReplaySafe(const std::string& method) const {
+#if CPP11_SUPPORTED
+        auto it = methodOptions_.find(method);
+#else
+        std::map<std::string, MethodOptions>::const_iterator it = methodOptions_.find(method);
+#endif
+        return it != methodOptions_.end() && it->second.replaySafe;
+    }
+
+    // 方法的响应是否允许压缩，未注册的方法按默认值处理
+    bool isCompressible(const std::string& method) const {
+#if CPP11_SUPPORTED
+        auto it = methodOptions_.find(method);
+#else
+        std::map<std::string, MethodOptions>::const_iterator it = methodOptions_.find(method);
 #endif
+        return it == methodOptions_.end() || it->second.compressible;
+    }
+
+    // 已注册的方法名
+    std::vector<std::string> methodNames() const {
+        std::vector<std::string> names;
+#if CPP11_SUPPORTED
+        for (auto it = methodHandlers_.begin(); it != methodHandlers_.end(); ++it) {
+#else
+        for (std::map<std::string, HandlerInfo>::const_iterator it = methodHandlers_.begin();
+             it != methodHandlers_.end(); ++it) {
+#endif
+            names.push_back(it->first);
+        }
+#if CPP11_SUPPORTED
+        for (auto it = streamHandlers_.begin(); it != streamHandlers_.end(); ++it) {
+#else
+        for (std::map<std::string, StreamHandlerInfo>::const_iterator it = streamHandlers_.begin();
+             it != streamHandlers_.end(); ++it) {
+#endif
+            names.push_back(it->first);
+        }
+        return names;
+    }
+
+    bool hasMethod(const std::string& method) const {
+        return methodHandlers_.find(method) != methodHandlers_.end() || isStreamMethod(method);
+    }
+
+    bool isStreamMethod(const std::string& method) const {
+        return streamHandlers_.find(method) != streamHandlers_.end();
+    }
+
+    // 打开流式方法的结果流；方法不存在或不是流式方法时抛出
+#if CPP11_SUPPORTED
+    std::unique_ptr<ResultStream> openStream(const std::string& method, const nlohmann::json& params) {
+        auto it = streamHandlers_.find(method);
+        if (it == streamHandlers_.end()) {
+            throw std::runtime_error("Method not found");
+        }
+        return it->second(params);
+    }
+#else
+    ResultStream* openStream(const std::string& method, const nlohmann::json& params) {
+        std::map<std::string, StreamHandlerInfo>::iterator it = streamHandlers_.find(method);
+        if (it == streamHandlers_.end()) {
+            throw std::runtime_error("Method not found");
+        }
+        return it->second.handler(it->second.context, params);
+    }
+#endif
+
+    // 方法级请求体上限，未注册或未设置时返回0
+    size_t maxBodySize(const std::string& method) const {
+#if CPP11_SUPPORTED
+        auto it = methodOptions_.find(method);
+#else
+        std::map<std::string, MethodOptions>::const_iterator it = methodOptions_.find(method);
+#endif
+        return it != methodOptions_.end() ? it->second.maxBodySize : 0;
+    }
 
     nlohmann::json executeMethod(const std::string& method, 
                                 const nlohmann::json& params) {
@@ -52,7 +199,8 @@ public:
         std::map<std::string, HandlerInfo>::iterator it = methodHandlers_.find(method);
 #endif
         if (it == methodHandlers_.end()) {
-            throw std::runtime_error("Method not found");
+            // 流式方法须经openStream调用，结果可能大到不宜在内存中展开
+            throw std::runtime_error(isStreamMethod(method) ? "Stream method, use openStream" : "Method not found");
         }
         
 #if CPP11_SUPPORTED
@@ -65,8 +213,12 @@ public:
 private:
 #if CPP11_SUPPORTED
     std::unordered_map<std::string, MethodHandler> methodHandlers_;
+    std::unordered_map<std::string, StreamHandler> streamHandlers_;
+    std::unordered_map<std::string, MethodOptions> methodOptions_;
 #else
     std::map<std::string, HandlerInfo> methodHandlers_;
+    std::map<std::string, StreamHandlerInfo> streamHandlers_;
+    std::map<std::string, MethodOptions> methodOptions_;
 #endif
 };
 
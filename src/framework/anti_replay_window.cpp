@@ -0,0 +1,43 @@
+// src/framework/anti_replay_window.cpp
+#include "framework/anti_replay_window.h"
+#include <openssl/evp.h>
+
+bool AntiReplayWindow::accept(SSL_SESSION* session) {
+    if (!session) {
+        return false;
+    }
+
+    // 票据过旧：无法在窗口内判断是否已被使用过
+    const time_t now = time(nullptr);
+    const time_t issued = static_cast<time_t>(SSL_SESSION_get_time(session));
+    if (now - issued > windowSec_ || issued > now) {
+        return false;
+    }
+
+    expire(now);
+
+    // 以恢复主密钥的摘要标识票据，每张票据对应唯一的PSK
+    unsigned char key[SSL_MAX_MASTER_KEY_LENGTH];
+    const size_t keyLen = SSL_SESSION_get_master_key(session, key, sizeof(key));
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLen = 0;
+    if (keyLen == 0 || !EVP_Digest(key, keyLen, digest, &digestLen, EVP_sha256(), nullptr)) {
+        return false;
+    }
+    OPENSSL_cleanse(key, sizeof(key));
+
+    std::string ticketId(reinterpret_cast<const char*>(digest), digestLen);
+    if (!seen_.insert(ticketId).second) {
+        return false; // 同一票据再次携带早期数据，视为重放
+    }
+    order_.push_back(std::make_pair(now, ticketId));
+    return true;
+}
+
+void AntiReplayWindow::expire(time_t now) {
+    // 超出窗口的票据已不可能通过时间检查，无需继续记录
+    while (!order_.empty() && now - order_.front().first > windowSec_) {
+        seen_.erase(order_.front().second);
+        order_.pop_front();
+    }
+}
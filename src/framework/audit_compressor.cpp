@@ -0,0 +1,106 @@
+// src/framework/audit_compressor.cpp
+#include "framework/audit_compressor.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <zlib.h>
+
+AuditCompressor::AuditCompressor() : stopping_(false) {}
+
+AuditCompressor::~AuditCompressor() {
+    if (worker_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_one();
+        worker_.join();
+    }
+}
+
+void AuditCompressor::enqueue(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(path);
+        if (!worker_.joinable()) {
+            worker_ = std::thread(&AuditCompressor::run, this);
+        }
+    }
+    ready_.notify_one();
+}
+
+void AuditCompressor::run() {
+    pthread_setname_np(pthread_self(), "audit-gzip");
+    // Linux上nice值按线程生效：压缩只在CPU空闲时推进，不拖慢I/O线程
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+    for (;;) {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (queue_.empty() && !stopping_) {
+                ready_.wait(lock);
+            }
+            if (stopping_) {
+                return;
+            }
+            path = queue_.front();
+            queue_.pop_front();
+        }
+        compress(path);
+    }
+}
+
+bool AuditCompressor::compress(const std::string& path) {
+    const std::string target = path + ".gz";
+    const std::string temp = target + ".tmp";
+    const int in = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        std::cerr << "Audit compress failed (" << path << "): " << strerror(errno) << std::endl;
+        return false;
+    }
+    const int out = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    gzFile gz = out >= 0 ? gzdopen(out, "wb") : nullptr;
+    if (!gz) {
+        std::cerr << "Audit compress failed (" << temp << "): " << strerror(errno) << std::endl;
+        if (out >= 0) {
+            ::close(out);
+        }
+        ::close(in);
+        return false;
+    }
+
+    std::vector<char> buffer(256 * 1024);
+    bool ok = true;
+    for (;;) {
+        const ssize_t n = ::read(in, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            ok = n == 0;
+            break;
+        }
+        if (gzwrite(gz, buffer.data(), static_cast<unsigned>(n)) != static_cast<int>(n)) {
+            ok = false;
+            break;
+        }
+    }
+    ::close(in);
+    // 删除原文件之前压缩结果必须已落盘
+    ok = ok && gzflush(gz, Z_FINISH) == Z_OK && fsync(out) == 0;
+    ok = gzclose(gz) == Z_OK && ok;
+    if (ok && rename(temp.c_str(), target.c_str()) == 0) {
+        unlink(path.c_str());
+        return true;
+    }
+    std::cerr << "Audit compress failed (" << path << "), left uncompressed" << std::endl;
+    unlink(temp.c_str());
+    return false;
+}
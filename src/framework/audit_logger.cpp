@@ -0,0 +1,427 @@
+// src/framework/audit_logger.cpp
+#include "framework/audit_logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static_assert(sizeof(AuditRecord) == 128, "AuditRecord must stay 128 bytes");
+
+namespace {
+
+std::atomic<uint64_t> nextLoggerId(1);
+std::atomic<unsigned> reopenRequests(0); // 信号处理函数中递增，须为无锁原子量
+
+void copyField(char* dest, size_t capacity, uint8_t& length, StringRef value) {
+    const size_t n = std::min(value.size, capacity);
+    memcpy(dest, value.data, n);
+    length = static_cast<uint8_t>(n);
+}
+
+// 方法名可能来自请求路径或二进制帧，按JSON字符串转义；非ASCII字节以\u00XX写出，
+// 截断处落在多字节字符中间时仍是合法的JSON
+void appendJsonString(std::string& out, const char* data, size_t size) {
+    static const char kHex[] = "0123456789abcdef";
+    out += '"';
+    for (size_t i = 0; i < size; ++i) {
+        const unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20 || c >= 0x7f) {
+            out += "\\u00";
+            out += kHex[c >> 4];
+            out += kHex[c & 0xf];
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
+AuditRing::AuditRing(size_t capacity)
+    : mask_(0), head_(0), cachedTail_(0), dropped_(0), tail_(0) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    slots_.resize(size);
+    mask_ = size - 1;
+}
+
+AuditRecord* AuditRing::reserve() {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - cachedTail_ > mask_) {
+        cachedTail_ = tail_.load(std::memory_order_acquire);
+        if (head - cachedTail_ > mask_) {
+            return nullptr;
+        }
+    }
+    return &slots_[head & mask_];
+}
+
+bool AuditRing::publish() {
+    const uint64_t head = head_.load(std::memory_order_relaxed) + 1;
+    head_.store(head, std::memory_order_release);
+    // 按生产者缓存的tail_估算，只会偏高，因此每次从低于一半涨上来都会经过这一点
+    return head - cachedTail_ == (mask_ + 1) / 2;
+}
+
+size_t AuditRing::peek(const AuditRecord*& records, size_t max) const {
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const size_t contiguous = mask_ + 1 - static_cast<size_t>(tail & mask_);
+    records = &slots_[tail & mask_];
+    return std::min(std::min(static_cast<size_t>(head - tail), contiguous), max);
+}
+
+void AuditRing::release(size_t count) {
+    tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+AuditLogger::AuditLogger()
+    : open_(false), fd_(-1), id_(nextLoggerId.fetch_add(1)), fileBytes_(0), openedAt_(0), rotateRetryAt_(0),
+      rotateFailed_(false), reopenSeen_(reopenRequests.load()), stopping_(false), reportedDrops_(0),
+      reportedLimited_(0), writeFailed_(false) {}
+
+AuditLogger::~AuditLogger() {
+    if (worker_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        worker_.join();
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    segments_.close();
+}
+
+bool AuditLogger::open(const AuditOptions& options) {
+    if (open_) {
+        return false;
+    }
+    options_ = options;
+    // 上次退出时未压完或未轮到压缩的文件（包括退出时关闭的最后一个段），须在创建新段之前列出
+    const std::vector<std::string> pending = options.compress ? uncompressedAuditFiles(options.path)
+                                                              : std::vector<std::string>();
+    if (options.format == AUDIT_FORMAT_BINARY) {
+        if (!segments_.open(options.path, options.segmentSize)) {
+            return false;
+        }
+    } else if (!openJsonFile()) {
+        return false;
+    }
+    for (size_t i = 0; i < pending.size(); ++i) {
+        compressor_.enqueue(pending[i]);
+    }
+    const AuditOptions defaults;
+    if (options_.ringCapacity == 0) {
+        options_.ringCapacity = defaults.ringCapacity;
+    }
+    if (options_.flushIntervalMs == 0) {
+        options_.flushIntervalMs = defaults.flushIntervalMs;
+    }
+    open_ = true;
+    worker_ = std::thread(&AuditLogger::run, this);
+    return true;
+}
+
+bool AuditClientLimiter::allow(StringRef client, uint32_t second, unsigned limit) {
+    if (slots_.empty()) {
+        slots_.resize(kSlots);
+    }
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for (size_t i = 0; i < client.size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(client.data[i])) * 1099511628211ull;
+    }
+    Slot& slot = slots_[hash & (kSlots - 1)];
+    if (slot.hash != hash || slot.second != second) {
+        slot.hash = hash;
+        slot.second = second;
+        slot.count = 0;
+    }
+    if (slot.count >= limit) {
+        return false;
+    }
+    ++slot.count;
+    return true;
+}
+
+// 线程首次写日志时创建并登记自己的状态，此后直接使用线程局部的指针
+AuditProducer* AuditLogger::threadProducer() {
+    static thread_local AuditProducer* producer = nullptr;
+    static thread_local uint64_t owner = 0;
+    if (owner != id_) {
+        std::unique_ptr<AuditProducer> created(new AuditProducer(options_.ringCapacity));
+        producer = created.get();
+        std::lock_guard<std::mutex> lock(producersMutex_);
+        producers_.push_back(std::move(created));
+        owner = id_;
+    }
+    return producer;
+}
+
+bool AuditLogger::admit(StringRef client, bool error) {
+    if (!open_) {
+        return false;
+    }
+    AuditProducer* producer = threadProducer();
+    if (!error && options_.sampleRate > 1) {
+        if (--producer->sampleCountdown > 0) {
+            return false;
+        }
+        producer->sampleCountdown = options_.sampleRate;
+    }
+    if (options_.maxPerClientPerSec > 0) {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+        if (!producer->limiter.allow(client, static_cast<uint32_t>(now.tv_sec), options_.maxPerClientPerSec)) {
+            producer->limited.store(producer->limited.load(std::memory_order_relaxed) + 1,
+                                    std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+void AuditLogger::log(StringRef client, uint16_t clientPort, StringRef method, uint32_t latencyUs, bool error) {
+    if (!open_) {
+        return;
+    }
+    AuditRing* ring = &threadProducer()->ring;
+    AuditRecord* record = ring->reserve();
+    if (!record) {
+        ring->countDrop();
+        return;
+    }
+    timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    record->timestampMs = static_cast<uint64_t>(now.tv_sec) * 1000 + static_cast<uint64_t>(now.tv_nsec) / 1000000;
+    record->clientPort = clientPort;
+    record->latencyUs = latencyUs;
+    record->flags = error ? AUDIT_RECORD_ERROR : 0;
+    copyField(record->client, AuditRecord::kClientSize, record->clientLength, client);
+    copyField(record->method, AuditRecord::kMethodSize, record->methodLength, method);
+    if (ring->publish()) {
+        wake_.notify_one(); // 突发流量下不必等到下一个刷新周期
+    }
+}
+
+uint64_t AuditLogger::dropped() const {
+    std::lock_guard<std::mutex> lock(producersMutex_);
+    uint64_t total = 0;
+    for (size_t i = 0; i < producers_.size(); ++i) {
+        total += producers_[i]->ring.dropped();
+    }
+    return total;
+}
+
+void AuditLogger::run() {
+    pthread_setname_np(pthread_self(), "audit-writer");
+    std::string batch;
+    for (;;) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            if (!stopping_) {
+                wake_.wait_for(lock, std::chrono::milliseconds(options_.flushIntervalMs));
+            }
+            stopping = stopping_;
+        }
+        batch.clear();
+        drain(batch);
+        if (options_.format == AUDIT_FORMAT_BINARY) {
+            segments_.commit();
+        } else if (!batch.empty()) {
+            writeBatch(batch);
+        }
+        maintain();
+        if (stopping) {
+            break; // 停止前的最后一轮已取空所有缓冲
+        }
+    }
+}
+
+size_t AuditLogger::drain(std::string& batch) {
+    static const size_t kMaxRecordsPerPass = 1024;
+    size_t count = 0;
+    uint64_t drops = 0;
+    uint64_t limited = 0;
+    std::lock_guard<std::mutex> lock(producersMutex_);
+    for (size_t i = 0; i < producers_.size(); ++i) {
+        AuditRing& ring = producers_[i]->ring;
+        const AuditRecord* records;
+        size_t n;
+        while ((n = ring.peek(records, kMaxRecordsPerPass)) > 0) {
+            for (size_t j = 0; j < n; ++j) {
+                const AuditRecord& record = records[j];
+                if (options_.format == AUDIT_FORMAT_BINARY) {
+                    segments_.appendCall(record.timestampMs, StringRef(record.client, record.clientLength),
+                                         record.clientPort, StringRef(record.method, record.methodLength),
+                                         record.latencyUs, (record.flags & AUDIT_RECORD_ERROR) != 0);
+                } else {
+                    format(record, batch);
+                }
+            }
+            ring.release(n);
+            count += n;
+        }
+        drops += ring.dropped();
+        limited += producers_[i]->limited.load(std::memory_order_relaxed);
+    }
+    appendCount(AUDIT_ENTRY_DROPPED, "dropped", drops, reportedDrops_, batch);
+    appendCount(AUDIT_ENTRY_RATE_LIMITED, "rateLimited", limited, reportedLimited_, batch);
+    return count;
+}
+
+// 计数有增长时把增量写成一条记录
+void AuditLogger::appendCount(AuditEntryType type, const char* name, uint64_t total, uint64_t& reported,
+                              std::string& batch) {
+    if (total <= reported) {
+        return;
+    }
+    const time_t now = time(nullptr);
+    if (options_.format == AUDIT_FORMAT_BINARY) {
+        segments_.appendCount(type, total - reported, static_cast<uint64_t>(now) * 1000);
+    } else {
+        char line[96];
+        snprintf(line, sizeof(line), "{\"%s\":%llu,\"timestamp\":%lld}\n", name,
+                 static_cast<unsigned long long>(total - reported), static_cast<long long>(now));
+        batch += line;
+    }
+    reported = total;
+}
+
+void AuditLogger::requestReopen() {
+    reopenRequests.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 两批记录之间处理重新打开与轮转
+void AuditLogger::maintain() {
+    const unsigned requests = reopenRequests.load(std::memory_order_relaxed);
+    const bool reopen = requests != reopenSeen_;
+    reopenSeen_ = requests;
+    const time_t now = time(nullptr);
+
+    if (options_.format == AUDIT_FORMAT_BINARY) {
+        const bool expired = options_.rotateIntervalSec > 0 && !segments_.empty() &&
+                             static_cast<uint64_t>(now) * 1000 >= segments_.openedMs() + options_.rotateIntervalSec * 1000ull;
+        if (reopen || expired) {
+            segments_.rotate();
+        }
+        std::vector<std::string> finished;
+        segments_.takeFinished(finished); // 包括写满segmentSize自行换下的段
+        for (size_t i = 0; options_.compress && i < finished.size(); ++i) {
+            compressor_.enqueue(finished[i]);
+        }
+        return;
+    }
+
+    if (reopen && !openJsonFile()) {
+        // 外部工具（如logrotate）改名后重新打开原路径；打不开时继续写原来的文件
+        std::cerr << "Audit log reopen failed (" << options_.path << "): " << strerror(errno) << std::endl;
+    }
+    const bool full = options_.rotateBytes > 0 && fileBytes_ >= options_.rotateBytes;
+    const bool expired = options_.rotateIntervalSec > 0 && fileBytes_ > 0 &&
+                         now - openedAt_ >= static_cast<time_t>(options_.rotateIntervalSec);
+    if ((full || expired) && now >= rotateRetryAt_) {
+        rotateJson();
+    }
+}
+
+// 打开（必要时创建）JSON日志文件，成功后替换当前的文件
+bool AuditLogger::openJsonFile() {
+    const int fd = ::open(options_.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    fileBytes_ = fstat(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = fd;
+    openedAt_ = time(nullptr);
+    return true;
+}
+
+// 把当前文件改名为下一个序号并重新打开原路径；新文件打不开时改回原名，继续写原来的文件
+void AuditLogger::rotateJson() {
+    const std::string rotated = auditSequencePath(options_.path, lastAuditSequence(options_.path) + 1);
+    if (rename(options_.path.c_str(), rotated.c_str()) != 0) {
+        reportRotate("rename", errno);
+        return;
+    }
+    if (!openJsonFile()) {
+        const int err = errno;
+        rename(rotated.c_str(), options_.path.c_str());
+        reportRotate("reopen", err);
+        return;
+    }
+    rotateFailed_ = false;
+    if (options_.compress) {
+        compressor_.enqueue(rotated);
+    }
+}
+
+// 同一次故障只报告一次，之后每秒重试
+void AuditLogger::reportRotate(const char* action, int err) {
+    if (!rotateFailed_) {
+        std::cerr << "Audit log rotation " << action << " failed (" << options_.path << "): " << strerror(err) << std::endl;
+        rotateFailed_ = true;
+    }
+    rotateRetryAt_ = time(nullptr) + 1;
+}
+
+void AuditLogger::format(const AuditRecord& record, std::string& out) {
+    char number[48];
+    out += "{\"client\":";
+    appendJsonString(out, record.client, record.clientLength);
+    if (record.flags & AUDIT_RECORD_ERROR) {
+        out += ",\"error\":true";
+    }
+    snprintf(number, sizeof(number), ",\"latencyUs\":%u", static_cast<unsigned>(record.latencyUs));
+    out += number;
+    out += ",\"method\":";
+    appendJsonString(out, record.method, record.methodLength);
+    snprintf(number, sizeof(number), ",\"port\":%u", static_cast<unsigned>(record.clientPort));
+    out += number;
+    snprintf(number, sizeof(number), ",\"timestamp\":%llu}\n",
+             static_cast<unsigned long long>(record.timestampMs / 1000));
+    out += number;
+}
+
+void AuditLogger::writeBatch(const std::string& batch) {
+    const char* data = batch.data();
+    size_t remaining = batch.size();
+    while (remaining > 0) {
+        const ssize_t n = ::write(fd_, data, remaining);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // 磁盘满等错误只报告一次，之后的批次照常尝试写入
+            if (!writeFailed_) {
+                std::cerr << "Audit log write failed (" << options_.path << "): " << strerror(errno) << std::endl;
+                writeFailed_ = true;
+            }
+            return;
+        }
+        data += n;
+        remaining -= static_cast<size_t>(n);
+        fileBytes_ += static_cast<uint64_t>(n);
+    }
+    writeFailed_ = false;
+}
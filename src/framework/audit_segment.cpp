@@ -0,0 +1,258 @@
+// src/framework/audit_segment.cpp
+#include "framework/audit_segment.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+static_assert(sizeof(AuditSegmentHeader) == 64, "AuditSegmentHeader must stay 64 bytes");
+static_assert(sizeof(AuditCallEntry) == 40, "AuditCallEntry must stay 40 bytes");
+static_assert(sizeof(AuditCountEntry) == 24, "AuditCountEntry must stay 24 bytes");
+
+namespace {
+
+const size_t kMinSegmentSize = 64 * 1024;
+const size_t kMaxMethodsPerSegment = 0xffff;
+
+size_t align8(size_t n) {
+    return (n + 7) & ~static_cast<size_t>(7);
+}
+
+uint64_t wallClockMs() {
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000 + static_cast<uint64_t>(now.tv_nsec) / 1000000;
+}
+
+// 列出目录中形如<name>.<数字>[.后缀]的文件：序号，以及是否带后缀（压缩过或正在压缩）
+void scanSequences(const std::string& basePath, std::vector<std::pair<uint64_t, bool> >& files) {
+    const size_t slash = basePath.rfind('/');
+    const std::string dir = slash == std::string::npos ? "." : basePath.substr(0, slash + 1);
+    const std::string prefix = (slash == std::string::npos ? basePath : basePath.substr(slash + 1)) + ".";
+    DIR* d = opendir(dir.c_str());
+    if (!d) {
+        return;
+    }
+    while (dirent* entry = readdir(d)) {
+        if (strncmp(entry->d_name, prefix.c_str(), prefix.size()) != 0) {
+            continue;
+        }
+        const char* digits = entry->d_name + prefix.size();
+        char* end = nullptr;
+        const unsigned long long sequence = strtoull(digits, &end, 10);
+        if (end != digits && (*end == '\0' || *end == '.')) {
+            files.push_back(std::make_pair(static_cast<uint64_t>(sequence), *end == '.'));
+        }
+    }
+    closedir(d);
+}
+
+} // namespace
+
+std::string auditSequencePath(const std::string& basePath, uint64_t sequence) {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%06llu", static_cast<unsigned long long>(sequence));
+    return basePath + suffix;
+}
+
+uint64_t lastAuditSequence(const std::string& basePath) {
+    std::vector<std::pair<uint64_t, bool> > files;
+    scanSequences(basePath, files);
+    uint64_t last = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        last = std::max(last, files[i].first);
+    }
+    return last;
+}
+
+std::vector<std::string> uncompressedAuditFiles(const std::string& basePath) {
+    std::vector<std::pair<uint64_t, bool> > files;
+    scanSequences(basePath, files);
+    std::sort(files.begin(), files.end());
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!files[i].second) {
+            paths.push_back(auditSequencePath(basePath, files[i].first));
+        }
+    }
+    return paths;
+}
+
+AuditSegmentWriter::AuditSegmentWriter()
+    : segmentSize_(kDefaultSegmentSize), sequence_(1), openedMs_(0), fd_(-1), map_(nullptr), used_(0),
+      failed_(false), reported_(false) {}
+
+bool AuditSegmentWriter::open(const std::string& basePath, size_t segmentSize) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    basePath_ = basePath;
+    segmentSize_ = (std::max(segmentSize, kMinSegmentSize) + page - 1) / page * page;
+    sequence_ = lastAuditSequence(basePath) + 1;
+    return openSegment();
+}
+
+void AuditSegmentWriter::close() {
+    if (map_) {
+        finishSegment();
+    }
+}
+
+bool AuditSegmentWriter::openSegment() {
+    std::string path;
+    for (int attempt = 0; attempt < 16; ++attempt, ++sequence_) {
+        path = auditSequencePath(basePath_, sequence_);
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd_ >= 0 || errno != EEXIST) {
+            break; // 已存在说明有别的段占用了这个序号，换下一个
+        }
+    }
+    if (fd_ < 0) {
+        report("create", path, errno);
+        return false;
+    }
+    const int err = posix_fallocate(fd_, 0, static_cast<off_t>(segmentSize_));
+    void* map = err == 0 ? mmap(nullptr, segmentSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0) : MAP_FAILED;
+    if (map == MAP_FAILED) {
+        report("preallocate", path, err ? err : errno);
+        ::close(fd_);
+        fd_ = -1;
+        unlink(path.c_str());
+        return false;
+    }
+    map_ = static_cast<uint8_t*>(map);
+    path_ = path;
+    reported_ = false;
+
+    AuditSegmentHeader* header = reinterpret_cast<AuditSegmentHeader*>(map_);
+    memcpy(header->magic, kAuditSegmentMagic, sizeof(header->magic));
+    header->version = kAuditSegmentVersion;
+    header->headerSize = sizeof(AuditSegmentHeader);
+    header->sequence = sequence_;
+    header->createdMs = wallClockMs();
+    openedMs_ = header->createdMs;
+    used_ = sizeof(AuditSegmentHeader);
+    header->usedBytes = used_;
+    methods_.clear();
+    return true;
+}
+
+// 同一次故障（如磁盘满）只报告一次，恢复后再出错时重新报告
+void AuditSegmentWriter::report(const char* action, const std::string& path, int err) {
+    if (!reported_) {
+        std::cerr << "Audit segment " << action << " failed (" << path << "): " << strerror(err) << std::endl;
+        reported_ = true;
+    }
+}
+
+// 段写满或关闭：记下实际长度，归还预分配而未用的空间
+void AuditSegmentWriter::finishSegment() {
+    commit();
+    munmap(map_, segmentSize_);
+    map_ = nullptr;
+    if (ftruncate(fd_, static_cast<off_t>(used_)) != 0) {
+        std::cerr << "Audit segment truncate failed: " << strerror(errno) << std::endl;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    ++sequence_;
+    finished_.push_back(path_);
+}
+
+// 换到下一个段；创建失败后到下一批才重试，磁盘满时不会每条记录都尝试一次
+bool AuditSegmentWriter::roll() {
+    if (failed_) {
+        return false;
+    }
+    if (map_) {
+        finishSegment();
+    }
+    if (!openSegment()) {
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+void AuditSegmentWriter::appendCall(uint64_t timestampMs, StringRef client, uint16_t port,
+                                    StringRef method, uint32_t latencyUs, bool error) {
+    const size_t nameLength = std::min<size_t>(method.size, 0xff);
+    const std::string name(method.data, nameLength);
+    std::unordered_map<std::string, uint16_t>::const_iterator it = methods_.find(name);
+    const size_t methodBytes = align8(sizeof(AuditMethodEntry) + nameLength);
+    const size_t needed = sizeof(AuditCallEntry) + (it == methods_.end() ? methodBytes : 0);
+    if (!fits(needed) || (it == methods_.end() && methods_.size() >= kMaxMethodsPerSegment)) {
+        if (!roll()) {
+            return;
+        }
+        it = methods_.end();
+    }
+
+    uint16_t methodId;
+    if (it == methods_.end()) {
+        methodId = static_cast<uint16_t>(methods_.size() + 1);
+        methods_[name] = methodId;
+        AuditMethodEntry* entry = reinterpret_cast<AuditMethodEntry*>(map_ + used_);
+        entry->type = AUDIT_ENTRY_METHOD;
+        entry->nameLength = static_cast<uint8_t>(nameLength);
+        entry->methodId = methodId;
+        memcpy(entry + 1, name.data(), nameLength); // 补齐部分来自预分配，已是0
+        used_ += methodBytes;
+    } else {
+        methodId = it->second;
+    }
+
+    AuditCallEntry* entry = reinterpret_cast<AuditCallEntry*>(map_ + used_);
+    memset(entry, 0, sizeof(*entry));
+    entry->type = AUDIT_ENTRY_CALL;
+    entry->port = port;
+    entry->methodId = methodId;
+    entry->flags = error ? AUDIT_CALL_ERROR : 0;
+    entry->timestampMs = timestampMs;
+    entry->latencyUs = latencyUs;
+    char address[INET6_ADDRSTRLEN];
+    const size_t length = std::min(client.size, sizeof(address) - 1);
+    memcpy(address, client.data, length);
+    address[length] = '\0';
+    if (inet_pton(AF_INET, address, entry->address) == 1) {
+        entry->family = 4;
+    } else if (inet_pton(AF_INET6, address, entry->address) == 1) {
+        entry->family = 6;
+    }
+    used_ += sizeof(AuditCallEntry);
+}
+
+void AuditSegmentWriter::appendCount(AuditEntryType type, uint64_t count, uint64_t timestampMs) {
+    if (!fits(sizeof(AuditCountEntry)) && !roll()) {
+        return;
+    }
+    AuditCountEntry* entry = reinterpret_cast<AuditCountEntry*>(map_ + used_);
+    memset(entry, 0, sizeof(*entry));
+    entry->type = static_cast<uint8_t>(type);
+    entry->count = count;
+    entry->timestampMs = timestampMs;
+    used_ += sizeof(AuditCountEntry);
+}
+
+void AuditSegmentWriter::rotate() {
+    if (map_ && empty()) {
+        return;
+    }
+    failed_ = false;
+    roll();
+}
+
+void AuditSegmentWriter::commit() {
+    if (map_) {
+        reinterpret_cast<AuditSegmentHeader*>(map_)->usedBytes = used_;
+    } else if (failed_) {
+        failed_ = false;
+        roll();
+    }
+}
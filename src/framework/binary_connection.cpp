@@ -0,0 +1,186 @@
+// src/framework/binary_connection.cpp
+#include "framework/binary_connection.h"
+#include "framework/http_response.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstring>
+
+static const StringRef kUnsupportedEncodingBody(
+    "{\"error\":{\"code\":-32600,\"message\":\"Unsupported payload encoding\"},\"id\":null,\"jsonrpc\":\"2.0\"}", 92);
+static const StringRef kProtocolErrorBody(
+    "{\"error\":{\"code\":-32600,\"message\":\"Invalid frame header\"},\"id\":null,\"jsonrpc\":\"2.0\"}", 84);
+
+uint32_t binaryMethodId(StringRef qualifiedName) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < qualifiedName.size; ++i) {
+        hash ^= static_cast<unsigned char>(qualifiedName.data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t readUint32(const unsigned char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return ntohl(value);
+}
+
+static void writeUint32(unsigned char* p, uint32_t value) {
+    value = htonl(value);
+    memcpy(p, &value, sizeof(value));
+}
+
+// 帧头中的编码值，本进程不支持的编码返回false
+static bool decodeCoding(uint8_t value, ContentCoding& coding) {
+    switch (value) {
+    case CODING_IDENTITY:
+    case CODING_GZIP:
+#ifdef RPC_HAVE_ZSTD
+    case CODING_ZSTD:
+#endif
+        coding = static_cast<ContentCoding>(value);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 与negotiateContentCoding相同，双方都支持时zstd优先
+static ContentCoding negotiateAccept(uint8_t mask) {
+#ifdef RPC_HAVE_ZSTD
+    if (mask & (1u << CODING_ZSTD)) {
+        return CODING_ZSTD;
+    }
+#endif
+    return (mask & (1u << CODING_GZIP)) ? CODING_GZIP : CODING_IDENTITY;
+}
+
+BinaryConnection::BinaryConnection(const RpcDispatcher& dispatcher, ConnectionState& state,
+                                   const HttpOptions& options)
+    : dispatcher_(dispatcher), state_(state), options_(options), phase_(READ_HEADER), served_(0),
+      requestId_(0), bodyLength_(0), encoding_(CODING_IDENTITY), accepted_(CODING_IDENTITY) {}
+
+void BinaryConnection::process(evbuffer* input, evbuffer* output) {
+    while (phase_ != CLOSING) {
+        if (phase_ == READ_HEADER && (outputBlocked(evbuffer_get_length(output)) || !readHeader(input, output))) {
+            return;
+        }
+        if (phase_ == SKIP_BODY) {
+            if (!skipBody(input)) {
+                return;
+            }
+            continue;
+        }
+        if (phase_ != READ_BODY || evbuffer_get_length(input) < bodyLength_) {
+            return;
+        }
+
+        const char* data = reinterpret_cast<const char*>(evbuffer_pullup(input, bodyLength_));
+        RpcCall call(StringRef(data, bodyLength_));
+        call.encoding = encoding_;
+        call.target = target_;
+        dispatcher_(call, state_);
+        evbuffer_drain(input, bodyLength_);
+
+        const ContentCoding coding = compressResponse(options_.compression, accepted_, call.compressible, call.response);
+        writeFrame(output, coding, BINARY_OK, StringRef(call.response));
+        phase_ = READ_HEADER;
+    }
+}
+
+TimeoutStage BinaryConnection::readStage(const evbuffer* input) const {
+    switch (phase_) {
+        case READ_HEADER:
+            return evbuffer_get_length(input) > 0 ? STAGE_HEADER : STAGE_IDLE;
+        case READ_BODY:
+        case SKIP_BODY:
+            return STAGE_BODY;
+        default:
+            return STAGE_WRITE;
+    }
+}
+
+// 解析请求帧头并消费之；返回false表示需要等待更多数据或连接已转入CLOSING
+bool BinaryConnection::readHeader(evbuffer* input, evbuffer* output) {
+    unsigned char header[kBinaryRequestHeaderSize];
+    if (evbuffer_copyout(input, header, sizeof(header)) != static_cast<ev_ssize_t>(sizeof(header))) {
+        return false;
+    }
+    requestId_ = readUint32(header + 4);
+    if (header[0] != kBinaryMagic || header[1] != kBinaryVersion) {
+        // 无法确定帧边界（例如对端在此端口上说HTTP），回复后关闭
+        writeFrame(output, CODING_IDENTITY, BINARY_PROTOCOL_ERROR, kProtocolErrorBody);
+        phase_ = CLOSING;
+        return false;
+    }
+    evbuffer_drain(input, sizeof(header));
+    bodyLength_ = readUint32(header + 12);
+    ++served_;
+
+    const uint32_t methodId = readUint32(header + 8);
+    target_ = StringRef();
+    if (methodId != 0 && (!options_.methodIds || !options_.methodIds(methodId, target_))) {
+        reject(output, BINARY_METHOD_NOT_FOUND, kMethodNotFoundBody);
+        return true;
+    }
+    // 与HTTP一样按路由确定请求体上限，超限的请求体不会进入缓冲
+    RequestRoute route;
+    route.bodyLimit = options_.limits.maxBodySize;
+    if (options_.route && target_.size > 0) {
+        route = options_.route(target_, route.bodyLimit);
+    }
+    if (!route.found) {
+        reject(output, BINARY_METHOD_NOT_FOUND, kMethodNotFoundBody);
+        return true;
+    }
+    if (bodyLength_ > route.bodyLimit) {
+        reject(output, BINARY_TOO_LARGE, StringRef(payloadTooLargeBody(bodyLength_, route.bodyLimit)));
+        return true;
+    }
+    if (!decodeCoding(header[2], encoding_)) {
+        reject(output, BINARY_UNSUPPORTED_ENCODING, kUnsupportedEncodingBody);
+        return true;
+    }
+    accepted_ = options_.compression.enabled ? negotiateAccept(header[3]) : CODING_IDENTITY;
+    phase_ = READ_BODY;
+    return true;
+}
+
+// 立即回应被拒绝的请求，随后跳过其请求体
+void BinaryConnection::reject(evbuffer* output, BinaryStatus status, StringRef body) {
+    writeFrame(output, CODING_IDENTITY, status, body);
+    phase_ = SKIP_BODY;
+}
+
+// 丢弃被拒绝请求的请求体，全部丢弃后返回true
+bool BinaryConnection::skipBody(evbuffer* input) {
+    const size_t skipped = std::min(evbuffer_get_length(input), bodyLength_);
+    evbuffer_drain(input, skipped);
+    bodyLength_ -= skipped;
+    if (bodyLength_ > 0) {
+        return false;
+    }
+    phase_ = READ_HEADER;
+    return true;
+}
+
+void BinaryConnection::writeFrame(evbuffer* output, ContentCoding coding, BinaryStatus status, StringRef body) {
+    // 帧头与响应体写入同一段连续空间
+    const size_t total = kBinaryResponseHeaderSize + body.size;
+    evbuffer_iovec vec;
+    if (evbuffer_reserve_space(output, static_cast<ev_ssize_t>(total), &vec, 1) != 1) {
+        return;
+    }
+    unsigned char* p = static_cast<unsigned char*>(vec.iov_base);
+    p[0] = kBinaryMagic;
+    p[1] = kBinaryVersion;
+    p[2] = static_cast<unsigned char>(coding);
+    p[3] = static_cast<unsigned char>(status);
+    writeUint32(p + 4, requestId_);
+    writeUint32(p + 8, static_cast<uint32_t>(body.size));
+    if (body.size > 0) {
+        memcpy(p + kBinaryResponseHeaderSize, body.data, body.size);
+    }
+    vec.iov_len = total;
+    evbuffer_commit_space(output, &vec, 1);
+}
@@ -0,0 +1,405 @@
+// src/framework/compression.cpp
+#include "framework/compression.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+const char* contentCodingName(ContentCoding coding) {
+    switch (coding) {
+    case CODING_GZIP: return "gzip";
+    case CODING_ZSTD: return "zstd";
+    default: return "identity";
+    }
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static StringRef trim(const char* begin, const char* end) {
+    while (begin < end && isSpace(*begin)) ++begin;
+    while (end > begin && isSpace(end[-1])) --end;
+    return StringRef(begin, end - begin);
+}
+
+// 解析";q=0.5"形式的参数，缺省为1；格式不合法的q值按0处理
+static double parseQuality(const char* begin, const char* end) {
+    while (begin < end) {
+        const char* semicolon = static_cast<const char*>(memchr(begin, ';', end - begin));
+        const char* paramEnd = semicolon ? semicolon : end;
+        StringRef param = trim(begin, paramEnd);
+        if (param.size >= 2 && (param.data[0] == 'q' || param.data[0] == 'Q') && param.data[1] == '=') {
+            char value[8] = {0};
+            const size_t n = param.size - 2 < sizeof(value) - 1 ? param.size - 2 : sizeof(value) - 1;
+            memcpy(value, param.data + 2, n);
+            char* parsedEnd = nullptr;
+            const double q = strtod(value, &parsedEnd);
+            if (parsedEnd == value || q < 0 || q > 1) {
+                return 0;
+            }
+            return q;
+        }
+        begin = semicolon ? semicolon + 1 : end;
+    }
+    return 1;
+}
+
+bool parseContentCoding(StringRef contentEncoding, ContentCoding& coding) {
+    const StringRef token = trim(contentEncoding.data, contentEncoding.data + contentEncoding.size);
+    if (token.empty() || token.equalsIgnoreCase("identity")) {
+        coding = CODING_IDENTITY;
+    } else if (token.equalsIgnoreCase("gzip") || token.equalsIgnoreCase("x-gzip")) {
+        coding = CODING_GZIP;
+#ifdef RPC_HAVE_ZSTD
+    } else if (token.equalsIgnoreCase("zstd")) {
+        coding = CODING_ZSTD;
+#endif
+    } else {
+        return false; // 含多重编码（如"gzip, zstd"）时同样拒绝
+    }
+    return true;
+}
+
+ContentCoding negotiateContentCoding(StringRef acceptEncoding) {
+    double gzipQ = -1;
+    double zstdQ = -1;
+    double wildcardQ = -1;
+
+    const char* p = acceptEncoding.data;
+    const char* const end = acceptEncoding.data + acceptEncoding.size;
+    while (p < end) {
+        const char* comma = static_cast<const char*>(memchr(p, ',', end - p));
+        const char* itemEnd = comma ? comma : end;
+        const char* semicolon = static_cast<const char*>(memchr(p, ';', itemEnd - p));
+        StringRef token = trim(p, semicolon ? semicolon : itemEnd);
+        const double q = semicolon ? parseQuality(semicolon + 1, itemEnd) : 1;
+
+        if (token.equalsIgnoreCase("gzip") || token.equalsIgnoreCase("x-gzip")) {
+            gzipQ = q;
+        } else if (token.equalsIgnoreCase("zstd")) {
+            zstdQ = q;
+        } else if (token.equals("*")) {
+            wildcardQ = q;
+        }
+        p = comma ? comma + 1 : end;
+    }
+
+    // 未显式列出的编码按通配符的q值处理
+    if (gzipQ < 0) gzipQ = wildcardQ;
+    if (zstdQ < 0) zstdQ = wildcardQ;
+
+#ifdef RPC_HAVE_ZSTD
+    if (zstdQ > 0 && zstdQ >= gzipQ) {
+        return CODING_ZSTD;
+    }
+#endif
+    if (gzipQ > 0) {
+        return CODING_GZIP;
+    }
+    return CODING_IDENTITY;
+}
+
+ResponseCompressor& ResponseCompressor::forThread() {
+    // 函数内static thread_local在首次使用时构造，线程退出时析构
+    static thread_local ResponseCompressor compressor;
+    return compressor;
+}
+
+ResponseCompressor::ResponseCompressor()
+    : deflateReady_(false), deflateLevel_(0), rawWindowBits_(0), rawLevel_(0) {
+    memset(&deflate_, 0, sizeof(deflate_));
+    memset(&rawDeflate_, 0, sizeof(rawDeflate_));
+#ifdef RPC_HAVE_ZSTD
+    zstd_ = nullptr;
+#endif
+}
+
+ResponseCompressor::~ResponseCompressor() {
+    if (deflateReady_) {
+        deflateEnd(&deflate_);
+    }
+    if (rawWindowBits_ != 0) {
+        deflateEnd(&rawDeflate_);
+    }
+#ifdef RPC_HAVE_ZSTD
+    ZSTD_freeCCtx(zstd_);
+#endif
+}
+
+bool ResponseCompressor::compress(ContentCoding coding, int level, StringRef input, std::string& output) {
+    switch (coding) {
+    case CODING_GZIP:
+        return gzip(level, input, output);
+#ifdef RPC_HAVE_ZSTD
+    case CODING_ZSTD:
+        return zstd(level, input, output);
+#endif
+    default:
+        return false;
+    }
+}
+
+bool ResponseCompressor::gzip(int level, StringRef input, std::string& output) {
+    if (!deflateReady_) {
+        // windowBits加16输出gzip封装（头部与CRC32尾部）
+        if (deflateInit2(&deflate_, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false;
+        }
+        deflateReady_ = true;
+        deflateLevel_ = level;
+    } else {
+        // 复用已分配的窗口与哈希表，只重置流状态
+        deflateReset(&deflate_);
+        if (level != deflateLevel_ && deflateParams(&deflate_, level, Z_DEFAULT_STRATEGY) == Z_OK) {
+            deflateLevel_ = level;
+        }
+    }
+
+    output.resize(deflateBound(&deflate_, static_cast<uLong>(input.size)));
+    deflate_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data));
+    deflate_.avail_in = static_cast<uInt>(input.size);
+    deflate_.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    deflate_.avail_out = static_cast<uInt>(output.size());
+    if (deflate(&deflate_, Z_FINISH) != Z_STREAM_END) {
+        return false;
+    }
+    output.resize(output.size() - deflate_.avail_out);
+    return true;
+}
+
+bool ResponseCompressor::deflateMessage(int level, int windowBits, StringRef input, std::string& output) {
+    // 窗口大小只能在初始化时指定，协商结果不同时才重建
+    if (rawWindowBits_ != windowBits || rawLevel_ != level) {
+        if (rawWindowBits_ != 0) {
+            deflateEnd(&rawDeflate_);
+            rawWindowBits_ = 0;
+        }
+        // 负的windowBits表示不带zlib/gzip封装的原始deflate流
+        if (deflateInit2(&rawDeflate_, level, Z_DEFLATED, -windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false;
+        }
+        rawWindowBits_ = windowBits;
+        rawLevel_ = level;
+    } else {
+        deflateReset(&rawDeflate_);
+    }
+
+    // 同步刷新比deflateBound多出空块的几个字节
+    output.resize(deflateBound(&rawDeflate_, static_cast<uLong>(input.size)) + 8);
+    rawDeflate_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data));
+    rawDeflate_.avail_in = static_cast<uInt>(input.size);
+    rawDeflate_.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    rawDeflate_.avail_out = static_cast<uInt>(output.size());
+    if (deflate(&rawDeflate_, Z_SYNC_FLUSH) != Z_OK || rawDeflate_.avail_in != 0) {
+        return false;
+    }
+    size_t written = output.size() - rawDeflate_.avail_out;
+    // 同步刷新以空的存储块00 00 ff ff结尾，按RFC 7692去掉
+    if (written < 4 || memcmp(&output[written - 4], "\x00\x00\xff\xff", 4) != 0) {
+        return false;
+    }
+    output.resize(written - 4);
+    return true;
+}
+
+#ifdef RPC_HAVE_ZSTD
+bool ResponseCompressor::zstd(int level, StringRef input, std::string& output) {
+    if (zstd_ == nullptr) {
+        zstd_ = ZSTD_createCCtx();
+        if (zstd_ == nullptr) {
+            return false;
+        }
+    }
+    output.resize(ZSTD_compressBound(input.size));
+    const size_t written = ZSTD_compressCCtx(zstd_, &output[0], output.size(), input.data, input.size, level);
+    if (ZSTD_isError(written)) {
+        return false;
+    }
+    output.resize(written);
+    return true;
+}
+#endif
+
+ContentCoding compressResponse(const CompressionPolicy& policy, ContentCoding accepted,
+                               bool compressible, std::string& body) {
+    if (!policy.enabled || accepted == CODING_IDENTITY || !compressible || body.size() < policy.minSize) {
+        return CODING_IDENTITY;
+    }
+
+    // 压缩结果写入线程内的暂存串，成功后与body交换：原body的缓冲留作下次的暂存区，稳态下不再分配
+    static thread_local std::string scratch;
+    const int level = accepted == CODING_ZSTD ? policy.zstdLevel : policy.gzipLevel;
+    if (!ResponseCompressor::forThread().compress(accepted, level, StringRef(body), scratch) ||
+        scratch.size() >= body.size()) {
+        return CODING_IDENTITY;
+    }
+    body.swap(scratch);
+    return accepted;
+}
+
+// 每线程复用的解压上下文，请求之间只做重置
+namespace {
+struct DecompressContexts {
+    z_stream inflate;
+    bool inflateReady;
+    z_stream rawInflate;    // permessage-deflate
+    bool rawInflateReady;
+#ifdef RPC_HAVE_ZSTD
+    ZSTD_DCtx* zstd;
+#endif
+
+    DecompressContexts() : inflateReady(false), rawInflateReady(false) {
+        memset(&inflate, 0, sizeof(inflate));
+        memset(&rawInflate, 0, sizeof(rawInflate));
+#ifdef RPC_HAVE_ZSTD
+        zstd = nullptr;
+#endif
+    }
+
+    ~DecompressContexts() {
+        if (inflateReady) {
+            inflateEnd(&inflate);
+        }
+        if (rawInflateReady) {
+            inflateEnd(&rawInflate);
+        }
+#ifdef RPC_HAVE_ZSTD
+        ZSTD_freeDCtx(zstd);
+#endif
+    }
+};
+
+DecompressContexts& decompressContexts() {
+    static thread_local DecompressContexts contexts;
+    return contexts;
+}
+} // namespace
+
+void inflateMessage(StringRef input, size_t maxSize, std::string& output) {
+    DecompressContexts& contexts = decompressContexts();
+    z_stream& stream = contexts.rawInflate;
+    if (!contexts.rawInflateReady) {
+        // 按最大窗口解压，可接受对端以任意较小窗口压缩的数据
+        if (inflateInit2(&stream, -15) != Z_OK) {
+            throw DecompressionError("inflate initialization failed", false);
+        }
+        contexts.rawInflateReady = true;
+    } else {
+        inflateReset(&stream);
+    }
+
+    static const unsigned char kTail[4] = {0x00, 0x00, 0xff, 0xff};
+    const StringRef chunks[2] = {input, StringRef(reinterpret_cast<const char*>(kTail), sizeof(kTail))};
+    output.resize(std::min<size_t>(std::max<size_t>(input.size * 4, 256), maxSize + 1));
+    size_t produced = 0;
+    for (int i = 0; i < 2; ++i) {
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(chunks[i].data));
+        stream.avail_in = static_cast<uInt>(chunks[i].size);
+        while (stream.avail_in > 0) {
+            if (produced == output.size()) {
+                if (output.size() > maxSize) {
+                    throw DecompressionError("decompressed message exceeds " + std::to_string(maxSize) + " bytes",
+                                             true);
+                }
+                output.resize(std::min(output.size() * 2, maxSize + 1));
+            }
+            stream.next_out = reinterpret_cast<Bytef*>(&output[produced]);
+            stream.avail_out = static_cast<uInt>(output.size() - produced);
+            const int rc = inflate(&stream, Z_SYNC_FLUSH);
+            produced = output.size() - stream.avail_out;
+            if (rc == Z_STREAM_END) {
+                break; // 对端以BFINAL结束了流，剩余输入忽略
+            }
+            if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                throw DecompressionError("malformed deflate message", false);
+            }
+        }
+    }
+    if (produced > maxSize) {
+        throw DecompressionError("decompressed message exceeds " + std::to_string(maxSize) + " bytes", true);
+    }
+    output.resize(produced);
+}
+
+RequestDecompressor::RequestDecompressor(ContentCoding coding, StringRef input, size_t maxSize)
+    : coding_(coding), input_(input), consumed_(0), maxSize_(maxSize), total_(0), finished_(false),
+      pos_(0), len_(0) {
+    DecompressContexts& contexts = decompressContexts();
+    if (coding_ == CODING_GZIP) {
+        // windowBits加32：自动识别gzip与zlib封装
+        if (!contexts.inflateReady) {
+            if (inflateInit2(&contexts.inflate, 15 + 32) != Z_OK) {
+                throw DecompressionError("inflate initialization failed", false);
+            }
+            contexts.inflateReady = true;
+        } else {
+            inflateReset(&contexts.inflate);
+        }
+#ifdef RPC_HAVE_ZSTD
+    } else if (coding_ == CODING_ZSTD) {
+        if (contexts.zstd == nullptr && (contexts.zstd = ZSTD_createDCtx()) == nullptr) {
+            throw DecompressionError("zstd initialization failed", false);
+        }
+        ZSTD_DCtx_reset(contexts.zstd, ZSTD_reset_session_only);
+#endif
+    } else {
+        // 未压缩的请求体应直接交给解析器
+        throw DecompressionError("unsupported content coding", false);
+    }
+}
+
+// 解压下一个窗口，输入耗尽且流已结束时返回false
+bool RequestDecompressor::fill() {
+    pos_ = 0;
+    len_ = 0;
+    while (len_ == 0 && !finished_) {
+#ifdef RPC_HAVE_ZSTD
+        len_ = coding_ == CODING_ZSTD ? zstdWindow() : inflateWindow();
+#else
+        len_ = inflateWindow();
+#endif
+        total_ += len_;
+        if (total_ > maxSize_) {
+            throw DecompressionError("decompressed body exceeds " + std::to_string(maxSize_) + " bytes", true);
+        }
+    }
+    return len_ > 0;
+}
+
+size_t RequestDecompressor::inflateWindow() {
+    z_stream& stream = decompressContexts().inflate;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input_.data + consumed_));
+    stream.avail_in = static_cast<uInt>(input_.size - consumed_);
+    stream.next_out = reinterpret_cast<Bytef*>(window_);
+    stream.avail_out = static_cast<uInt>(kWindowSize);
+
+    const int rc = inflate(&stream, Z_NO_FLUSH);
+    consumed_ = input_.size - stream.avail_in;
+    const size_t produced = kWindowSize - stream.avail_out;
+    if (rc == Z_STREAM_END) {
+        finished_ = true;
+    } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+        throw DecompressionError("malformed gzip body", false);
+    } else if (produced == 0 && consumed_ == input_.size) {
+        throw DecompressionError("truncated gzip body", false); // 输入耗尽而流未结束
+    }
+    return produced;
+}
+
+#ifdef RPC_HAVE_ZSTD
+size_t RequestDecompressor::zstdWindow() {
+    ZSTD_inBuffer in = { input_.data, input_.size, consumed_ };
+    ZSTD_outBuffer out = { window_, kWindowSize, 0 };
+    const size_t rc = ZSTD_decompressStream(decompressContexts().zstd, &out, &in);
+    consumed_ = in.pos;
+    if (ZSTD_isError(rc)) {
+        throw DecompressionError(std::string("malformed zstd body: ") + ZSTD_getErrorName(rc), false);
+    }
+    if (rc == 0 && consumed_ == input_.size) {
+        finished_ = true; // 帧已完整结束且输入耗尽
+    } else if (out.pos == 0 && consumed_ == input_.size) {
+        throw DecompressionError("truncated zstd body", false);
+    }
+    return out.pos;
+}
+#endif
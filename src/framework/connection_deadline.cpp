@@ -0,0 +1,43 @@
+// src/framework/connection_deadline.cpp
+#include "framework/connection_deadline.h"
+
+int ConnectionTimeouts::forStage(TimeoutStage stage) const {
+    switch (stage) {
+        case STAGE_HANDSHAKE: return handshakeSec;
+        case STAGE_HEADER:    return headerSec;
+        case STAGE_BODY:      return bodySec;
+        case STAGE_IDLE:      return idleSec;
+        case STAGE_WRITE:     return writeSec;
+        case STAGE_LINGER:    return lingerSec;
+        default:              return 0;
+    }
+}
+
+ConnectionDeadline::ConnectionDeadline(TimerWheel& wheel, const ConnectionTimeouts& timeouts,
+                                       WheelTimer::Callback onExpired, void* arg)
+    : wheel_(wheel), timeouts_(timeouts), timer_(onExpired, arg), stage_(STAGE_NONE), request_(0) {}
+
+void ConnectionDeadline::enter(TimeoutStage stage, unsigned request) {
+    // 写超时只在写出有进展时由restart延后：不读取响应却不断发来新请求的对端不能借此续期
+    const bool sameRequest = request == request_ || stage == STAGE_WRITE;
+    if (stage == stage_ && sameRequest && stage != STAGE_IDLE) {
+        return; // 保留原截止时间
+    }
+    stage_ = stage;
+    request_ = request;
+    restart();
+}
+
+void ConnectionDeadline::restart() {
+    const int seconds = timeouts_.forStage(stage_);
+    if (seconds > 0) {
+        wheel_.schedule(&timer_, static_cast<uint64_t>(seconds) * 1000);
+    } else {
+        timer_.cancel();
+    }
+}
+
+void ConnectionDeadline::cancel() {
+    stage_ = STAGE_NONE;
+    timer_.cancel();
+}
@@ -0,0 +1,27 @@
+// src/framework/connection_state.cpp
+#include "framework/connection_state.h"
+#include <openssl/x509.h>
+
+const char* listenerKindName(ListenerKind kind) {
+    static const char* const kNames[kListenerKindCount] = {"tls", "unix", "plain", "h2", "bin", "bin-unix"};
+    return kNames[kind];
+}
+
+// 读取TLS连接的校验结果、协议版本、加密套件与客户端证书主题
+void inspectTlsConnection(SSL* ssl, ConnectionState& state) {
+    // 验证 SSL 连接状态
+    if (SSL_get_verify_result(ssl) != X509_V_OK) {
+        state.rejectReason = "客户端证书验证失败";
+        return;
+    }
+
+    state.protocol = SSL_get_version(ssl);
+    state.cipher = SSL_get_cipher(ssl);
+    X509* peerCert = SSL_get_peer_certificate(ssl);
+    if (peerCert) {
+        char subject[256];
+        X509_NAME_oneline(X509_get_subject_name(peerCert), subject, sizeof(subject));
+        state.peerIdentity = subject;
+        X509_free(peerCert);
+    }
+}
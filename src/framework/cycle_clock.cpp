@@ -0,0 +1,33 @@
+// src/framework/cycle_clock.cpp
+#include "framework/cycle_clock.h"
+
+namespace {
+
+#if defined(__x86_64__) || defined(__i386__)
+uint64_t monotonicNs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+}
+
+double calibrate() {
+    const uint64_t startNs = monotonicNs();
+    const uint64_t startCycles = cycleNow();
+    const timespec pause = {0, 10 * 1000 * 1000};
+    nanosleep(&pause, nullptr);
+    const uint64_t elapsedNs = monotonicNs() - startNs;
+    const uint64_t elapsedCycles = cycleNow() - startCycles;
+    return elapsedCycles > 0 ? static_cast<double>(elapsedNs) / static_cast<double>(elapsedCycles) : 1.0;
+}
+#else
+double calibrate() {
+    return 1.0; // cycleNow已是纳秒
+}
+#endif
+
+} // namespace
+
+double nanosPerCycle() {
+    static const double ratio = calibrate();
+    return ratio;
+}
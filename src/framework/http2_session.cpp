@@ -0,0 +1,390 @@
+// src/framework/http2_session.cpp
+#include "framework/http2_session.h"
+
+#ifdef RPC_HAVE_NGHTTP2
+
+#include "framework/http_response.h"
+#include "framework/cycle_clock.h"
+#include <event2/event.h>
+#include <event2/buffer.h>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+// 单个连接允许同时处理的流数
+static const uint32_t kMaxConcurrentStreams = 100;
+
+// 构造响应头，名称须为小写；名称与值在帧发出前须保持有效，nghttp2不再复制
+static nghttp2_nv makeHeader(const char* name, const char* value, size_t valueLen) {
+    nghttp2_nv nv;
+    nv.name = reinterpret_cast<uint8_t*>(const_cast<char*>(name));
+    nv.value = reinterpret_cast<uint8_t*>(const_cast<char*>(value));
+    nv.namelen = strlen(name);
+    nv.valuelen = valueLen;
+    nv.flags = NGHTTP2_NV_FLAG_NO_COPY_NAME | NGHTTP2_NV_FLAG_NO_COPY_VALUE; // 仍允许写入HPACK动态表
+    return nv;
+}
+
+Http2Session::Http2Session(bufferevent* bev, const ConnectionState& state, const RpcDispatcher& dispatcher,
+                           const HttpOptions& options, TimerWheel& timers, const CloseHandler& onClose)
+    : bev_(bev), session_(nullptr), state_(state), dispatcher_(dispatcher), options_(options),
+      deadline_(timers, options.timeouts, Http2Session::timeoutCallback, this), requests_(0), writeMark_(0),
+      readPaused_(false), onClose_(onClose) {
+}
+
+Http2Session::~Http2Session() {
+    if (session_) {
+        nghttp2_session_del(session_);
+    }
+    bufferevent_free(bev_);
+}
+
+bool Http2Session::start() {
+    nghttp2_session_callbacks* callbacks = nullptr;
+    if (nghttp2_session_callbacks_new(&callbacks) != 0) {
+        return false;
+    }
+    nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks, Http2Session::onBeginHeaders);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, Http2Session::onHeader);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, Http2Session::onDataChunk);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, Http2Session::onFrameRecv);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, Http2Session::onStreamClose);
+    const int rv = nghttp2_session_server_new(&session_, callbacks, this);
+    nghttp2_session_callbacks_del(callbacks);
+    if (rv != 0) {
+        session_ = nullptr;
+        return false;
+    }
+
+    nghttp2_settings_entry settings[] = {
+        {NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, kMaxConcurrentStreams},
+        {NGHTTP2_SETTINGS_MAX_HEADER_LIST_SIZE, static_cast<uint32_t>(options_.limits.maxHeaderSize)}
+    };
+    if (nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, settings,
+                                sizeof(settings) / sizeof(settings[0])) != 0) {
+        return false;
+    }
+
+    bufferevent_setcb(bev_, Http2Session::readCallback, Http2Session::writeCallback,
+                      Http2Session::eventCallback, this);
+    bufferevent_enable(bev_, EV_READ | EV_WRITE);
+
+    // 握手期间客户端可能已随连接前言发来请求
+    if (evbuffer_get_length(bufferevent_get_input(bev_)) > 0) {
+        readCallback(bev_, this);
+        return true;
+    }
+    if (!flush()) {
+        return false;
+    }
+    updateDeadline();
+    return true;
+}
+
+// 请求体收齐后立即分发，响应以数据提供器的形式挂到流上
+void Http2Session::handleRequest(int32_t streamId, Stream* stream) {
+    ++requests_;
+    if (stream->unsupportedEncoding) {
+        const nghttp2_nv status = makeHeader(":status", "415", 3);
+        nghttp2_submit_response(session_, streamId, &status, 1, nullptr);
+        return;
+    }
+
+    RpcCall call((StringRef(stream->request)));
+    call.encoding = stream->encoding;
+    call.target = StringRef(stream->target);
+    call.receivedCycles = stream->receivedCycles;
+    call.trace = stream->trace;
+    dispatcher_(call, state_);
+    stream->response.swap(call.response);
+    stream->timing.swap(call.timing);
+    stream->request.clear();
+    const ContentCoding coding = compressResponse(options_.compression, stream->accepted, call.compressible,
+                                                  stream->response);
+    stream->contentLength = std::to_string(stream->response.size());
+
+    nghttp2_nv headers[7];
+    size_t count = 0;
+    headers[count++] = makeHeader(":status", "200", 3);
+    headers[count++] = makeHeader("content-type", kJsonContentType, sizeof(kJsonContentType) - 1);
+    headers[count++] = makeHeader("strict-transport-security", kHstsHeaderValue, sizeof(kHstsHeaderValue) - 1);
+    headers[count++] = makeHeader("content-length", stream->contentLength.data(), stream->contentLength.size());
+    if (coding != CODING_IDENTITY) {
+        const char* name = contentCodingName(coding);
+        headers[count++] = makeHeader("content-encoding", name, strlen(name));
+        headers[count++] = makeHeader("vary", "accept-encoding", 15);
+    }
+    if (!stream->timing.empty()) {
+        headers[count++] = makeHeader("server-timing", stream->timing.data(), stream->timing.size());
+    }
+
+    nghttp2_data_provider provider;
+    provider.source.ptr = stream;
+    provider.read_callback = Http2Session::readResponse;
+    nghttp2_submit_response(session_, streamId, headers, count, &provider);
+}
+
+// 路径指明的方法不存在（404）或请求体超出上限（413）：立即响应，此后该流上的数据直接丢弃；
+// 响应发完而请求未结束时nghttp2会以RST_STREAM(NO_ERROR)通知对端停止发送
+void Http2Session::rejectRequest(int32_t streamId, Stream* stream, const char* status, const std::string& body) {
+    stream->rejected = true;
+    stream->request.clear();
+    stream->response = body;
+    stream->contentLength = std::to_string(stream->response.size());
+
+    const nghttp2_nv headers[] = {
+        makeHeader(":status", status, 3),
+        makeHeader("content-type", kJsonContentType, sizeof(kJsonContentType) - 1),
+        makeHeader("content-length", stream->contentLength.data(), stream->contentLength.size())
+    };
+    nghttp2_data_provider provider;
+    provider.source.ptr = stream;
+    provider.read_callback = Http2Session::readResponse;
+    nghttp2_submit_response(session_, streamId, headers, sizeof(headers) / sizeof(headers[0]), &provider);
+}
+
+// 把nghttp2待发送的帧写入bufferevent；积压达到上限时停下，其余帧留在nghttp2中，输出发出后再取
+bool Http2Session::flush() {
+    while (!outputBlocked()) {
+        const uint8_t* data = nullptr;
+        const ssize_t n = nghttp2_session_mem_send(session_, &data);
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        bufferevent_write(bev_, data, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+bool Http2Session::outputBlocked() const {
+    return evbuffer_get_length(bufferevent_get_output(bev_)) >= options_.maxPendingOutput;
+}
+
+// 尚未发出的响应字节：输出缓冲中的帧，加上积压或流量控制窗口不足而尚未取出的响应体
+size_t Http2Session::pendingOutput() const {
+    size_t pending = evbuffer_get_length(bufferevent_get_output(bev_));
+    for (std::unordered_map<int32_t, Stream>::const_iterator it = streams_.begin(); it != streams_.end(); ++it) {
+        pending += it->second.response.size() - it->second.sent;
+    }
+    return pending;
+}
+
+// 每次I/O之后按会话所处的阶段计时，各阶段的含义见connection_deadline.h
+void Http2Session::updateDeadline() {
+    const size_t pending = pendingOutput();
+    TimeoutStage stage;
+    if (pending > 0) {
+        stage = STAGE_WRITE;
+    } else if (!streams_.empty()) {
+        stage = STAGE_BODY; // 有流的请求尚未收齐
+    } else {
+        stage = STAGE_IDLE;
+    }
+    if (stage == STAGE_WRITE && deadline_.stage() != STAGE_WRITE) {
+        writeMark_ = pending;
+    }
+    deadline_.enter(stage, requests_);
+}
+
+// 写超时到期时先确认确实停滞：bufferevent只在输出写空时回调，期间的写出进展收不到通知
+void Http2Session::onTimeout() {
+    if (deadline_.stage() == STAGE_WRITE) {
+        const size_t pending = pendingOutput();
+        if (pending < writeMark_) {
+            writeMark_ = pending;
+            if (pending == 0) {
+                updateDeadline();
+            } else {
+                deadline_.restart();
+            }
+            return;
+        }
+    }
+    close();
+}
+
+void Http2Session::close() {
+    onClose_(this); // 由所有者释放会话，此后不可再访问成员
+}
+
+void Http2Session::readCallback(bufferevent* bev, void* ctx) {
+    Http2Session* self = static_cast<Http2Session*>(ctx);
+    evbuffer* input = bufferevent_get_input(bev);
+    if (self->outputBlocked()) {
+        // 未处理的输入留在缓冲中，输出发出后继续
+        bufferevent_disable(bev, EV_READ);
+        self->readPaused_ = true;
+        self->updateDeadline();
+        return;
+    }
+    const size_t len = evbuffer_get_length(input);
+    const unsigned char* data = evbuffer_pullup(input, -1);
+
+    const ssize_t consumed = nghttp2_session_mem_recv(self->session_, data, len);
+    if (consumed < 0) {
+        self->close();
+        return;
+    }
+    evbuffer_drain(input, static_cast<size_t>(consumed));
+
+    if (!self->flush()) {
+        self->close();
+        return;
+    }
+    if (self->outputBlocked()) {
+        bufferevent_disable(bev, EV_READ);
+        self->readPaused_ = true;
+    }
+    self->updateDeadline();
+}
+
+// 输出写空后继续取出留在nghttp2中的帧，恢复因积压暂停的读取；
+// 若双方都已无事可做（如收到GOAWAY）则关闭连接
+void Http2Session::writeCallback(bufferevent* bev, void* ctx) {
+    Http2Session* self = static_cast<Http2Session*>(ctx);
+    evbuffer* output = bufferevent_get_output(bev);
+    if (evbuffer_get_length(output) > 0) {
+        return;
+    }
+    if (!self->flush()) {
+        self->close();
+        return;
+    }
+    if (self->readPaused_ && !self->outputBlocked()) {
+        self->readPaused_ = false;
+        bufferevent_enable(bev, EV_READ);
+        readCallback(bev, self); // 处理暂停期间留在输入缓冲中的数据
+        return;
+    }
+    if (evbuffer_get_length(output) == 0 &&
+        !nghttp2_session_want_read(self->session_) && !nghttp2_session_want_write(self->session_)) {
+        self->close();
+        return;
+    }
+    self->updateDeadline();
+}
+
+void Http2Session::eventCallback(bufferevent* /*bev*/, short events, void* ctx) {
+    if (events & (BEV_EVENT_EOF | BEV_EVENT_ERROR | BEV_EVENT_TIMEOUT)) {
+        static_cast<Http2Session*>(ctx)->close();
+    }
+}
+
+void Http2Session::timeoutCallback(void* arg) {
+    static_cast<Http2Session*>(arg)->onTimeout();
+}
+
+int Http2Session::onBeginHeaders(nghttp2_session* session, const nghttp2_frame* frame, void* ctx) {
+    if (frame->hd.type == NGHTTP2_HEADERS && frame->headers.cat == NGHTTP2_HCAT_REQUEST) {
+        Stream* stream = &static_cast<Http2Session*>(ctx)->streams_[frame->hd.stream_id];
+        nghttp2_session_set_stream_user_data(session, frame->hd.stream_id, stream);
+    }
+    return 0;
+}
+
+// 只保存:path、content-length、编码相关与x-rpc-trace请求头；HPACK解码后的名称均为小写
+int Http2Session::onHeader(nghttp2_session* session, const nghttp2_frame* frame, const uint8_t* name,
+                           size_t namelen, const uint8_t* value, size_t valuelen, uint8_t /*flags*/,
+                           void* ctx) {
+    Http2Session* self = static_cast<Http2Session*>(ctx);
+    if (frame->hd.type != NGHTTP2_HEADERS) {
+        return 0;
+    }
+    Stream* stream = static_cast<Stream*>(nghttp2_session_get_stream_user_data(session, frame->hd.stream_id));
+    if (!stream) {
+        return 0;
+    }
+    // 请求头总量超限时重置该流（回调返回TEMPORAL_CALLBACK_FAILURE即RST_STREAM）
+    stream->headerBytes += namelen + valuelen + 32;
+    if (stream->headerBytes > self->options_.limits.maxHeaderSize) {
+        return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+    }
+
+    const StringRef header(reinterpret_cast<const char*>(value), valuelen);
+    if (namelen == 5 && memcmp(name, ":path", 5) == 0) {
+        stream->target.assign(header.data, header.size);
+    } else if (namelen == 14 && memcmp(name, "content-length", 14) == 0) {
+        stream->declaredLength = static_cast<size_t>(strtoull(header.str().c_str(), nullptr, 10));
+    } else if (namelen == 15 && memcmp(name, "accept-encoding", 15) == 0 && self->options_.compression.enabled) {
+        stream->accepted = negotiateContentCoding(header);
+    } else if (namelen == 16 && memcmp(name, "content-encoding", 16) == 0) {
+        stream->unsupportedEncoding = !parseContentCoding(header, stream->encoding);
+    } else if (namelen == 11 && memcmp(name, "x-rpc-trace", 11) == 0 && self->options_.traceHeader) {
+        stream->trace = true;
+    }
+    return 0;
+}
+
+int Http2Session::onDataChunk(nghttp2_session* session, uint8_t /*flags*/, int32_t streamId,
+                              const uint8_t* data, size_t len, void* ctx) {
+    Stream* stream = static_cast<Stream*>(nghttp2_session_get_stream_user_data(session, streamId));
+    if (!stream || stream->rejected) {
+        return 0;
+    }
+    // 未声明content-length的请求体边收边检查
+    if (stream->request.size() + len > stream->bodyLimit) {
+        static_cast<Http2Session*>(ctx)->rejectRequest(streamId, stream, "413",
+            payloadTooLargeBody(stream->request.size() + len, stream->bodyLimit));
+        return 0;
+    }
+    stream->request.append(reinterpret_cast<const char*>(data), len);
+    return 0;
+}
+
+// 请求以END_STREAM结束（无请求体时在HEADERS帧上，否则在最后一个DATA帧上）
+int Http2Session::onFrameRecv(nghttp2_session* session, const nghttp2_frame* frame, void* ctx) {
+    Http2Session* self = static_cast<Http2Session*>(ctx);
+    // 请求头收齐后即按路径解析路由：方法不存在时直接404，否则按content-length提前拒绝超限的请求体
+    if (frame->hd.type == NGHTTP2_HEADERS && frame->headers.cat == NGHTTP2_HCAT_REQUEST) {
+        Stream* stream = static_cast<Stream*>(nghttp2_session_get_stream_user_data(session, frame->hd.stream_id));
+        if (stream) {
+            RequestRoute route;
+            route.bodyLimit = self->options_.limits.maxBodySize;
+            if (self->options_.route) {
+                route = self->options_.route(StringRef(stream->target), route.bodyLimit);
+            }
+            stream->bodyLimit = route.bodyLimit;
+            stream->receivedCycles = cycleNow();
+            if (!route.found) {
+                self->rejectRequest(frame->hd.stream_id, stream, "404", kMethodNotFoundBody.str());
+            } else if (stream->declaredLength > stream->bodyLimit) {
+                self->rejectRequest(frame->hd.stream_id, stream, "413",
+                                    payloadTooLargeBody(stream->declaredLength, stream->bodyLimit));
+            }
+        }
+    }
+
+    if ((frame->hd.type != NGHTTP2_HEADERS && frame->hd.type != NGHTTP2_DATA) ||
+        !(frame->hd.flags & NGHTTP2_FLAG_END_STREAM)) {
+        return 0;
+    }
+    Stream* stream = static_cast<Stream*>(nghttp2_session_get_stream_user_data(session, frame->hd.stream_id));
+    if (stream && !stream->rejected) {
+        self->handleRequest(frame->hd.stream_id, stream);
+    }
+    return 0;
+}
+
+int Http2Session::onStreamClose(nghttp2_session* /*session*/, int32_t streamId,
+                                uint32_t /*errorCode*/, void* ctx) {
+    static_cast<Http2Session*>(ctx)->streams_.erase(streamId);
+    return 0;
+}
+
+ssize_t Http2Session::readResponse(nghttp2_session* /*session*/, int32_t /*streamId*/, uint8_t* buf,
+                                   size_t length, uint32_t* dataFlags, nghttp2_data_source* source,
+                                   void* /*ctx*/) {
+    Stream* stream = static_cast<Stream*>(source->ptr);
+    const size_t n = std::min(length, stream->response.size() - stream->sent);
+    memcpy(buf, stream->response.data() + stream->sent, n);
+    stream->sent += n;
+    if (stream->sent == stream->response.size()) {
+        *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+    }
+    return static_cast<ssize_t>(n);
+}
+
+#endif // RPC_HAVE_NGHTTP2
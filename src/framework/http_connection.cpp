@@ -0,0 +1,277 @@
+// src/framework/http_connection.cpp
+#include "framework/http_connection.h"
+#include "framework/http_response.h"
+#include "framework/websocket.h"
+#include "framework/cycle_clock.h"
+#include <algorithm>
+
+HttpConnection::HttpConnection(const RpcDispatcher& dispatcher, ConnectionState& state,
+                               const HttpOptions& options)
+    : dispatcher_(dispatcher), state_(state), options_(options), phase_(READ_HEAD), served_(0), aborted_(false),
+      headLength_(0), contentLength_(0), targetOffset_(0), targetLength_(0), keepAlive_(true), minorVersion_(1),
+      accepted_(CODING_IDENTITY), encoding_(CODING_IDENTITY), receivedCycles_(0), trace_(false) {}
+
+// WebSocketConnection只在此处完整可见
+HttpConnection::~HttpConnection() {}
+
+TimeoutStage HttpConnection::readStage(const evbuffer* input) const {
+    switch (phase_) {
+        case READ_HEAD:
+            return evbuffer_get_length(input) > 0 ? STAGE_HEADER : STAGE_IDLE;
+        case READ_BODY:
+        case SKIP_BODY:
+            return STAGE_BODY;
+        case UPGRADED:
+            return STAGE_IDLE;
+        default:
+            return STAGE_WRITE; // 流式响应与关闭前都在等输出发出
+    }
+}
+
+bool HttpConnection::closing() const {
+    return phase_ == CLOSING || (webSocket_ && webSocket_->closing());
+}
+
+void HttpConnection::process(evbuffer* input, evbuffer* output, size_t queued) {
+    while (phase_ != CLOSING) {
+        if (phase_ == UPGRADED) {
+            webSocket_->process(input, output);
+            return;
+        }
+        if (phase_ == READ_HEAD &&
+            (outputBlocked(queued + evbuffer_get_length(output)) || !readHead(input, output))) {
+            return;
+        }
+        if (phase_ == UPGRADED) {
+            continue; // 升级请求之后已到达的字节属于WebSocket
+        }
+        if (phase_ == STREAMING) {
+            if (!writeStream(output, queued)) {
+                return;
+            }
+            continue;
+        }
+        if (phase_ == SKIP_BODY) {
+            if (!skipBody(input)) {
+                return;
+            }
+            continue;
+        }
+
+        const size_t requestLength = headLength_ + contentLength_;
+        if (evbuffer_get_length(input) < requestLength) {
+            return; // 请求体尚未收齐
+        }
+
+        // 小请求通常整个位于同一块内存中，pullup不产生拷贝
+        const char* data = reinterpret_cast<const char*>(evbuffer_pullup(input, requestLength));
+        RpcCall call(StringRef(data + headLength_, contentLength_));
+        call.encoding = encoding_;
+        call.target = StringRef(data + targetOffset_, targetLength_);
+        call.streamable = minorVersion_ >= 1; // HTTP/1.0不支持分块传输编码
+        call.receivedCycles = receivedCycles_;
+        call.trace = trace_;
+        dispatcher_(call, state_);
+        evbuffer_drain(input, requestLength);
+        ++served_;
+
+        std::string traced;
+        const StringRef headers = responseHeaders(call, traced);
+        if (call.stream) {
+            ResponseHeaderBlock::ok().writeChunkedHead(output, headers);
+            stream_ = std::move(call.stream);
+            phase_ = STREAMING;
+            continue;
+        }
+        writeResponse(output, call, headers);
+        phase_ = keepAlive_ ? READ_HEAD : CLOSING;
+    }
+}
+
+// 解析请求头，成功后进入READ_BODY；返回false表示需要等待更多数据或连接已转入CLOSING
+bool HttpConnection::readHead(evbuffer* input, evbuffer* output) {
+    const size_t available = evbuffer_get_length(input);
+    if (available == 0) {
+        return false;
+    }
+
+    // 先在首个内存块上原地解析，请求头跨块时才连续化
+    evbuffer_iovec first;
+    evbuffer_peek(input, -1, nullptr, &first, 1);
+    const size_t maxHeaderSize = options_.limits.maxHeaderSize;
+    const size_t window = std::min(available, maxHeaderSize);
+    const char* data = static_cast<const char*>(first.iov_base);
+    size_t len = std::min(first.iov_len, window);
+
+    HttpRequest request;
+    HttpParseResult result = parseHttpRequest(data, len, request);
+    if (result == HTTP_PARSE_INCOMPLETE && len < window) {
+        data = reinterpret_cast<const char*>(evbuffer_pullup(input, window));
+        len = window;
+        result = parseHttpRequest(data, len, request);
+    }
+
+    if (result == HTTP_PARSE_INCOMPLETE) {
+        if (window == maxHeaderSize) {
+            writeError(output, "431 Request Header Fields Too Large");
+        }
+        return false;
+    }
+    if (result == HTTP_PARSE_ERROR) {
+        writeError(output, "400 Bad Request");
+        return false;
+    }
+    receivedCycles_ = cycleNow();
+    trace_ = options_.traceHeader && request.header("X-Rpc-Trace") != nullptr;
+
+    // 升级到其他协议（如h2c）的请求按普通请求处理，RFC 7230允许忽略Upgrade
+    const StringRef* upgradeProtocol = request.header("Upgrade");
+    if (request.upgrade && options_.webSocket.enabled && upgradeProtocol &&
+        upgradeProtocol->equalsIgnoreCase("websocket")) {
+        return upgrade(request, input, output);
+    }
+
+    // 按路径解析路由，并按Content-Length在读取请求体之前拒绝，超限的请求体不会进入缓冲
+    RequestRoute route;
+    route.bodyLimit = options_.limits.maxBodySize;
+    if (options_.route) {
+        route = options_.route(request.target, options_.limits.maxBodySize);
+    }
+    if (request.contentLength > route.bodyLimit) {
+        writeError(output, kPayloadTooLargeStatus, payloadTooLargeBody(request.contentLength, route.bodyLimit));
+        return false;
+    }
+
+    encoding_ = CODING_IDENTITY;
+    const StringRef* contentEncoding = request.header("Content-Encoding");
+    if (contentEncoding && !parseContentCoding(*contentEncoding, encoding_)) {
+        writeError(output, "415 Unsupported Media Type");
+        return false;
+    }
+
+    headLength_ = request.headLength;
+    targetOffset_ = request.target.data - data;
+    targetLength_ = request.target.size;
+    contentLength_ = request.contentLength;
+    minorVersion_ = request.minorVersion;
+    accepted_ = CODING_IDENTITY;
+    if (options_.compression.enabled) {
+        const StringRef* acceptEncoding = request.header("Accept-Encoding");
+        if (acceptEncoding) {
+            accepted_ = negotiateContentCoding(*acceptEncoding);
+        }
+    }
+    // 达到单连接请求数上限后，以Connection: close结束本连接
+    keepAlive_ = request.keepAlive &&
+        (options_.maxRequests == 0 || served_ + 1 < options_.maxRequests);
+
+    // 路径指明的方法不存在：立即回应404，请求体边界已知，丢弃后连接仍可继续使用
+    if (!route.found) {
+        ResponseHeaderBlock::notFound().write(output, kMethodNotFoundBody, connectionHeader());
+        evbuffer_drain(input, headLength_);
+        ++served_;
+        phase_ = SKIP_BODY;
+        return true;
+    }
+    phase_ = READ_BODY;
+    return true;
+}
+
+// 完成WebSocket握手，此后连接上的字节交给WebSocketConnection；握手不合法时回复错误并关闭
+bool HttpConnection::upgrade(const HttpRequest& request, evbuffer* input, evbuffer* output) {
+    WebSocketSettings settings;
+    switch (acceptWebSocket(request, options_.webSocket, output, settings)) {
+    case WS_HANDSHAKE_OK:
+        break;
+    case WS_HANDSHAKE_BAD_VERSION:
+        writeError(output, "426 Upgrade Required", std::string(), kWebSocketVersionHeader);
+        return false;
+    default:
+        writeError(output, "400 Bad Request");
+        return false;
+    }
+    evbuffer_drain(input, request.headLength);
+    ++served_;
+    webSocket_.reset(new WebSocketConnection(dispatcher_, state_, options_, settings));
+    phase_ = UPGRADED;
+    return true;
+}
+
+// 丢弃已回应请求的请求体，全部丢弃后返回true
+bool HttpConnection::skipBody(evbuffer* input) {
+    const size_t skipped = std::min(evbuffer_get_length(input), contentLength_);
+    evbuffer_drain(input, skipped);
+    contentLength_ -= skipped;
+    if (contentLength_ > 0) {
+        return false;
+    }
+    phase_ = keepAlive_ ? READ_HEAD : CLOSING;
+    return true;
+}
+
+// 按输出积压拉取流式响应体，全部发出后返回true；积压达到上限时返回false，由引擎在输出发出后再次调用process
+bool HttpConnection::writeStream(evbuffer* output, size_t queued) {
+    bool more = true;
+    while (more) {
+        if (outputBlocked(queued + evbuffer_get_length(output))) {
+            return false;
+        }
+        chunk_.clear();
+        try {
+            more = stream_->next(chunk_);
+        } catch (...) {
+            // 已发出的部分无法撤回：不写结束块直接关闭，客户端据此得知响应不完整
+            stream_.reset();
+            phase_ = CLOSING;
+            return false;
+        }
+        writeChunk(output, StringRef(chunk_));
+    }
+    evbuffer_add(output, kLastChunk.data, kLastChunk.size);
+    stream_.reset();
+    std::string().swap(chunk_);
+    phase_ = keepAlive_ ? READ_HEAD : CLOSING;
+    return true;
+}
+
+// HTTP/1.1默认长连接；HTTP/1.0须显式确认keep-alive，否则客户端会等待连接关闭
+StringRef HttpConnection::connectionHeader() const {
+    if (!keepAlive_) {
+        return kConnectionClose;
+    }
+    return minorVersion_ == 0 ? kConnectionKeepAlive : StringRef();
+}
+
+// 追踪的请求把Server-Timing头拼在Connection头之前，其余请求不产生拼接
+StringRef HttpConnection::responseHeaders(const RpcCall& call, std::string& scratch) const {
+    const StringRef connection = connectionHeader();
+    if (call.timing.empty()) {
+        return connection;
+    }
+    scratch = "Server-Timing: ";
+    scratch += call.timing;
+    scratch += "\r\n";
+    scratch.append(connection.data, connection.size);
+    return StringRef(scratch);
+}
+
+void HttpConnection::writeResponse(evbuffer* output, RpcCall& call, StringRef headers) {
+    const ContentCoding coding = compressResponse(options_.compression, accepted_, call.compressible, call.response);
+    ResponseHeaderBlock::ok(coding).write(output, StringRef(call.response), headers);
+}
+
+// 协议错误或拒绝读取请求体后无法确定下一个请求的边界，回复错误并关闭连接
+void HttpConnection::writeError(evbuffer* output, const char* status, const std::string& body,
+                                const char* extraHeaders) {
+    evbuffer_add_printf(output,
+        "HTTP/1.1 %s\r\n"
+        "%s%s%s%s"
+        "Content-Length: %zu\r\n"
+        "Connection: close\r\n"
+        "\r\n", status,
+        body.empty() ? "" : "Content-Type: ", body.empty() ? "" : kJsonContentType, body.empty() ? "" : "\r\n",
+        extraHeaders, body.size());
+    evbuffer_add(output, body.data(), body.size());
+    phase_ = CLOSING;
+    aborted_ = true;
+}
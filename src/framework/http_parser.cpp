@@ -0,0 +1,179 @@
+// src/framework/http_parser.cpp
+#include "framework/http_parser.h"
+#include <cstring>
+#include <strings.h>
+
+const StringRef* HttpRequest::header(const char* name) const {
+    for (size_t i = 0; i < headerCount; ++i) {
+        if (headers[i].name.equalsIgnoreCase(name)) {
+            return &headers[i].value;
+        }
+    }
+    return nullptr;
+}
+
+// RFC 7230 token字符：方法名与请求头名称只允许这些字符
+static bool isTokenChar(unsigned char c) {
+    static const char kSeparators[] = "()<>@,;:\\\"/[]?={} \t";
+    return c > 0x20 && c < 0x7f && !memchr(kSeparators, c, sizeof(kSeparators) - 1);
+}
+
+// 查找以CRLF结尾的一行，lineEnd指向CR；裸LF视为格式错误
+static HttpParseResult findLineEnd(const char* p, const char* end, const char*& lineEnd) {
+    const char* lf = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (!lf) {
+        return HTTP_PARSE_INCOMPLETE;
+    }
+    if (lf == p || lf[-1] != '\r') {
+        return HTTP_PARSE_ERROR;
+    }
+    lineEnd = lf - 1;
+    return HTTP_PARSE_OK;
+}
+
+static bool containsTokenIgnoreCase(StringRef value, const char* token) {
+    const size_t tokenLen = strlen(token);
+    for (size_t i = 0; i + tokenLen <= value.size; ++i) {
+        if (strncasecmp(value.data + i, token, tokenLen) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseRequestLine(const char* p, const char* lineEnd, HttpRequest& request) {
+    const char* methodEnd = p;
+    while (methodEnd < lineEnd && isTokenChar(static_cast<unsigned char>(*methodEnd))) {
+        ++methodEnd;
+    }
+    if (methodEnd == p || methodEnd == lineEnd || *methodEnd != ' ') {
+        return false;
+    }
+    request.method = StringRef(p, methodEnd - p);
+
+    const char* target = methodEnd + 1;
+    const char* targetEnd = static_cast<const char*>(memchr(target, ' ', lineEnd - target));
+    if (!targetEnd || targetEnd == target) {
+        return false;
+    }
+    request.target = StringRef(target, targetEnd - target);
+
+    const char* version = targetEnd + 1;
+    if (lineEnd - version != 8 || memcmp(version, "HTTP/1.", 7) != 0 ||
+        (version[7] != '0' && version[7] != '1')) {
+        return false;
+    }
+    request.minorVersion = version[7] - '0';
+    request.keepAlive = request.minorVersion == 1;
+    return true;
+}
+
+static bool parseContentLength(StringRef value, size_t& length) {
+    if (value.empty()) {
+        return false;
+    }
+    size_t result = 0;
+    for (size_t i = 0; i < value.size; ++i) {
+        const char c = value.data[i];
+        if (c < '0' || c > '9' || result > (static_cast<size_t>(-1) - 9) / 10) {
+            return false;
+        }
+        result = result * 10 + (c - '0');
+    }
+    length = result;
+    return true;
+}
+
+HttpParseResult parseHttpRequest(const char* data, size_t len, HttpRequest& request) {
+    const char* const end = data + len;
+    request.headerCount = 0;
+    request.contentLength = 0;
+
+    const char* lineEnd = nullptr;
+    HttpParseResult result = findLineEnd(data, end, lineEnd);
+    if (result != HTTP_PARSE_OK) {
+        return result;
+    }
+    if (!parseRequestLine(data, lineEnd, request)) {
+        return HTTP_PARSE_ERROR;
+    }
+
+    bool haveLength = false;
+    for (const char* line = lineEnd + 2; ; line = lineEnd + 2) {
+        result = findLineEnd(line, end, lineEnd);
+        if (result != HTTP_PARSE_OK) {
+            return result;
+        }
+        if (lineEnd == line) {
+            request.headLength = lineEnd + 2 - data;
+            return HTTP_PARSE_OK;
+        }
+
+        const char* nameEnd = line;
+        while (nameEnd < lineEnd && isTokenChar(static_cast<unsigned char>(*nameEnd))) {
+            ++nameEnd;
+        }
+        if (nameEnd == line || nameEnd == lineEnd || *nameEnd != ':') {
+            return HTTP_PARSE_ERROR; // 含折行（obs-fold）与名称后的空白
+        }
+        if (request.headerCount == kMaxHttpHeaders) {
+            return HTTP_PARSE_ERROR;
+        }
+
+        const char* value = nameEnd + 1;
+        const char* valueEnd = lineEnd;
+        while (value < valueEnd && (*value == ' ' || *value == '\t')) {
+            ++value;
+        }
+        while (valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) {
+            --valueEnd;
+        }
+
+        HttpHeader& header = request.headers[request.headerCount++];
+        header.name = StringRef(line, nameEnd - line);
+        header.value = StringRef(value, valueEnd - value);
+
+        if (header.name.equalsIgnoreCase("Content-Length")) {
+            size_t length = 0;
+            // 重复且不一致的Content-Length可被用于请求走私，直接拒绝
+            if (!parseContentLength(header.value, length) ||
+                (haveLength && length != request.contentLength)) {
+                return HTTP_PARSE_ERROR;
+            }
+            request.contentLength = length;
+            haveLength = true;
+        } else if (header.name.equalsIgnoreCase("Transfer-Encoding")) {
+            return HTTP_PARSE_ERROR; // 不支持分块传输编码
+        } else if (header.name.equalsIgnoreCase("Connection")) {
+            if (containsTokenIgnoreCase(header.value, "close")) {
+                request.keepAlive = false;
+            } else if (containsTokenIgnoreCase(header.value, "keep-alive")) {
+                request.keepAlive = true;
+            }
+            if (containsTokenIgnoreCase(header.value, "upgrade")) {
+                request.upgrade = true;
+            }
+        }
+    }
+}
+
+bool parseMethodPath(StringRef target, StringRef& service, StringRef& method) {
+    static const char kPrefix[] = "/rpc/";
+    static const size_t kPrefixLen = sizeof(kPrefix) - 1;
+
+    const char* query = static_cast<const char*>(memchr(target.data, '?', target.size));
+    const size_t pathLen = query ? static_cast<size_t>(query - target.data) : target.size;
+    if (pathLen <= kPrefixLen || memcmp(target.data, kPrefix, kPrefixLen) != 0) {
+        return false;
+    }
+
+    const char* begin = target.data + kPrefixLen;
+    const char* end = target.data + pathLen;
+    const char* slash = static_cast<const char*>(memchr(begin, '/', end - begin));
+    if (!slash || slash == begin || slash + 1 == end || memchr(slash + 1, '/', end - slash - 1)) {
+        return false;
+    }
+    service = StringRef(begin, slash - begin);
+    method = StringRef(slash + 1, end - slash - 1);
+    return true;
+}
@@ -0,0 +1,103 @@
+// src/framework/http_response.cpp
+#include "framework/http_response.h"
+#include <cstdio>
+#include <cstring>
+
+ResponseHeaderBlock::ResponseHeaderBlock(const char* status, const char* extraHeaders) {
+    prefix_ = "HTTP/1.1 ";
+    prefix_ += status;
+    prefix_ += "\r\nContent-Type: ";
+    prefix_ += kJsonContentType;
+    prefix_ += "\r\nStrict-Transport-Security: ";
+    prefix_ += kHstsHeaderValue;
+    prefix_ += "\r\n";
+    prefix_ += extraHeaders;
+    fixedLength_ = prefix_.size();
+    prefix_ += "Content-Length: ";
+}
+
+const ResponseHeaderBlock& ResponseHeaderBlock::ok(ContentCoding coding) {
+    static const ResponseHeaderBlock identity("200 OK");
+    static const ResponseHeaderBlock gzip("200 OK", "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n");
+    static const ResponseHeaderBlock zstd("200 OK", "Content-Encoding: zstd\r\nVary: Accept-Encoding\r\n");
+    switch (coding) {
+    case CODING_GZIP: return gzip;
+    case CODING_ZSTD: return zstd;
+    default: return identity;
+    }
+}
+
+const ResponseHeaderBlock& ResponseHeaderBlock::notFound() {
+    static const ResponseHeaderBlock block(kNotFoundStatus);
+    return block;
+}
+
+// 十进制格式化，从缓冲末尾向前写，返回首字符位置
+static char* formatDecimal(size_t value, char* end) {
+    char* p = end;
+    do {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    return p;
+}
+
+void ResponseHeaderBlock::write(evbuffer* output, StringRef body, StringRef connection) const {
+    char digits[24];
+    char* const digitsEnd = digits + sizeof(digits);
+    const char* length = formatDecimal(body.size, digitsEnd);
+    const size_t lengthLen = digitsEnd - length;
+    const size_t total = prefix_.size() + lengthLen + 2 + connection.size + 2 + body.size;
+
+    // 预留一段连续空间，头部与响应体各拷贝一次，不产生中间字符串
+    evbuffer_iovec vec;
+    if (evbuffer_reserve_space(output, static_cast<ev_ssize_t>(total), &vec, 1) != 1) {
+        return;
+    }
+    char* p = static_cast<char*>(vec.iov_base);
+    memcpy(p, prefix_.data(), prefix_.size());
+    p += prefix_.size();
+    memcpy(p, length, lengthLen);
+    p += lengthLen;
+    memcpy(p, "\r\n", 2);
+    p += 2;
+    if (connection.size > 0) {
+        memcpy(p, connection.data, connection.size);
+        p += connection.size;
+    }
+    memcpy(p, "\r\n", 2);
+    p += 2;
+    if (body.size > 0) {
+        memcpy(p, body.data, body.size);
+    }
+    vec.iov_len = total;
+    evbuffer_commit_space(output, &vec, 1);
+}
+
+void ResponseHeaderBlock::writeChunkedHead(evbuffer* output, StringRef connection) const {
+    static const char kChunked[] = "Transfer-Encoding: chunked\r\n";
+    evbuffer_add(output, prefix_.data(), fixedLength_);
+    evbuffer_add(output, kChunked, sizeof(kChunked) - 1);
+    if (connection.size > 0) {
+        evbuffer_add(output, connection.data, connection.size);
+    }
+    evbuffer_add(output, "\r\n", 2);
+}
+
+void writeChunk(evbuffer* output, StringRef data) {
+    if (data.size == 0) {
+        return;
+    }
+    evbuffer_add_printf(output, "%zx\r\n", data.size);
+    evbuffer_add(output, data.data, data.size);
+    evbuffer_add(output, "\r\n", 2);
+}
+
+std::string payloadTooLargeBody(size_t contentLength, size_t limit) {
+    // 与RpcServer::errorBody的输出格式一致（键按字母序）
+    char body[160];
+    snprintf(body, sizeof(body),
+             "{\"error\":{\"code\":-32600,\"message\":\"Request body too large: %zu bytes exceeds limit of %zu\"},"
+             "\"id\":null,\"jsonrpc\":\"2.0\"}", contentLength, limit);
+    return body;
+}
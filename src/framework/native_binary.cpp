@@ -0,0 +1,152 @@
+// src/framework/native_binary.cpp
+#include "framework/native_binary.h"
+#include <event2/buffer.h>
+
+NativeBinaryConnection::NativeBinaryConnection(bufferevent* bev, const ConnectionState& state,
+                                               const HttpOptions& options, TimerWheel& timers,
+                                               const Inspector& inspector, const RpcDispatcher& dispatcher,
+                                               const CloseHandler& onClose)
+    : bev_(bev), state_(state), inspected_(false), peerClosed_(false), readPaused_(false), writeMark_(0),
+      options_(options), deadline_(timers, options.timeouts, NativeBinaryConnection::timeoutCallback, this),
+      inspector_(inspector), dispatcher_(dispatcher), onClose_(onClose),
+      frames_(dispatcher_, state_, options_) {}
+
+NativeBinaryConnection::~NativeBinaryConnection() {
+    bufferevent_free(bev_);
+}
+
+void NativeBinaryConnection::start() {
+    bufferevent_setcb(bev_, NativeBinaryConnection::readCallback, NativeBinaryConnection::writeCallback,
+                      NativeBinaryConnection::eventCallback, this);
+    bufferevent_enable(bev_, EV_READ | EV_WRITE);
+    updateDeadline();
+}
+
+// 与NativeHttpConnection相同，按帧计请求头与请求体的期限
+void NativeBinaryConnection::updateDeadline() {
+    const size_t pending = NativeHttpConnection::pendingOutput(bev_);
+    TimeoutStage stage;
+    if (NativeHttpConnection::handshaking(bev_)) {
+        stage = STAGE_HANDSHAKE;
+    } else if (pending > 0) {
+        stage = STAGE_WRITE;
+    } else {
+        stage = frames_.readStage(bufferevent_get_input(bev_));
+    }
+    if (stage == STAGE_WRITE && deadline_.stage() != STAGE_WRITE) {
+        writeMark_ = pending;
+    }
+    deadline_.enter(stage, frames_.served());
+}
+
+void NativeBinaryConnection::onTimeout() {
+    const TimeoutStage stage = deadline_.stage();
+    if (stage == STAGE_WRITE) {
+        const size_t pending = NativeHttpConnection::pendingOutput(bev_);
+        if (pending < writeMark_) {
+            writeMark_ = pending;
+            if (pending == 0) {
+                updateDeadline();
+            } else {
+                deadline_.restart();
+            }
+            return;
+        }
+    } else if (stage == STAGE_HANDSHAKE && !NativeHttpConnection::handshaking(bev_)) {
+        updateDeadline();
+        return;
+    }
+    close();
+}
+
+void NativeBinaryConnection::onRead() {
+    if (!inspected_) {
+        inspected_ = inspector_(bev_, state_);
+    }
+
+    evbuffer* output = bufferevent_get_output(bev_);
+    frames_.process(bufferevent_get_input(bev_), output);
+    if (!frames_.closing() && frames_.outputBlocked(NativeHttpConnection::pendingOutput(bev_))) {
+        bufferevent_disable(bev_, EV_READ);
+        readPaused_ = true;
+        updateDeadline();
+        return;
+    }
+    if (frames_.closing() || peerClosed_) {
+        bufferevent_disable(bev_, EV_READ);
+        if (evbuffer_get_length(output) == 0) {
+            onWriteDrained();
+            return;
+        }
+    }
+    updateDeadline();
+}
+
+void NativeBinaryConnection::onWriteDrained() {
+    if (readPaused_) {
+        readPaused_ = false;
+        if (!peerClosed_) {
+            bufferevent_enable(bev_, EV_READ);
+        }
+        onRead();
+        return;
+    }
+    if (!frames_.closing() && !peerClosed_) {
+        if (options_.leanIdle && evbuffer_get_length(bufferevent_get_input(bev_)) == 0) {
+            NativeHttpConnection::releaseIdleBuffers(bev_);
+        }
+        updateDeadline();
+        return;
+    }
+
+    // 与NativeHttpConnection相同：TLS过滤层的输出还在底层bufferevent中时，等底层发完再关闭
+    bufferevent* underlying = bufferevent_get_underlying(bev_);
+    if (underlying && evbuffer_get_length(bufferevent_get_output(underlying)) > 0) {
+        bufferevent_setcb(underlying, nullptr, NativeBinaryConnection::underlyingWriteCallback,
+                          NativeBinaryConnection::eventCallback, this);
+        bufferevent_enable(underlying, EV_WRITE);
+        updateDeadline();
+        return;
+    }
+    close();
+}
+
+void NativeBinaryConnection::close() {
+    onClose_(this);
+}
+
+void NativeBinaryConnection::readCallback(bufferevent* /*bev*/, void* ctx) {
+    static_cast<NativeBinaryConnection*>(ctx)->onRead();
+}
+
+void NativeBinaryConnection::writeCallback(bufferevent* /*bev*/, void* ctx) {
+    static_cast<NativeBinaryConnection*>(ctx)->onWriteDrained();
+}
+
+void NativeBinaryConnection::underlyingWriteCallback(bufferevent* /*bev*/, void* ctx) {
+    static_cast<NativeBinaryConnection*>(ctx)->close();
+}
+
+void NativeBinaryConnection::timeoutCallback(void* arg) {
+    static_cast<NativeBinaryConnection*>(arg)->onTimeout();
+}
+
+void NativeBinaryConnection::eventCallback(bufferevent* bev, short events, void* ctx) {
+    NativeBinaryConnection* conn = static_cast<NativeBinaryConnection*>(ctx);
+    // bufferevent_openssl完成握手，转入等待请求（TlsStream过滤层没有此事件，由握手超时到期时确认）
+    if (events == BEV_EVENT_CONNECTED) {
+        conn->updateDeadline();
+        return;
+    }
+    // 对端只关闭了写方向：发完已产生的响应后再关闭
+    if ((events & BEV_EVENT_EOF) && !(events & BEV_EVENT_ERROR) &&
+        evbuffer_get_length(bufferevent_get_output(bev)) > 0) {
+        conn->peerClosed_ = true;
+        bufferevent_disable(bev, EV_READ);
+        conn->updateDeadline();
+        return;
+    }
+    if (events & (BEV_EVENT_EOF | BEV_EVENT_ERROR | BEV_EVENT_TIMEOUT)) {
+        conn->close();
+    }
+}
@@ -0,0 +1,229 @@
+// src/framework/native_http.cpp
+#include "framework/native_http.h"
+#include "framework/tls_stream.h"
+#include <event2/event.h>
+#include <event2/buffer.h>
+#include <event2/bufferevent_ssl.h>
+#include <sys/socket.h>
+
+// 延迟关闭期间最多丢弃的数据量，等待时长见ConnectionTimeouts::lingerSec
+static const size_t kMaxLingerBytes = 1024 * 1024;
+
+NativeHttpConnection::NativeHttpConnection(bufferevent* bev, const ConnectionState& state,
+                                           const HttpOptions& options, TimerWheel& timers,
+                                           const Inspector& inspector, const RpcDispatcher& dispatcher,
+                                           const CloseHandler& onClose)
+    : bev_(bev), state_(state), inspected_(false), peerClosed_(false), readPaused_(false), lingering_(false),
+      lingerBytes_(0), writeMark_(0), options_(options),
+      deadline_(timers, options.timeouts, NativeHttpConnection::timeoutCallback, this),
+      inspector_(inspector), dispatcher_(dispatcher), onClose_(onClose),
+      http_(dispatcher_, state_, options_) {}
+
+NativeHttpConnection::~NativeHttpConnection() {
+    bufferevent_free(bev_);
+}
+
+void NativeHttpConnection::start() {
+    bufferevent_setcb(bev_, NativeHttpConnection::readCallback, NativeHttpConnection::writeCallback,
+                      NativeHttpConnection::eventCallback, this);
+    bufferevent_enable(bev_, EV_READ | EV_WRITE);
+    updateDeadline();
+}
+
+bool NativeHttpConnection::handshaking(bufferevent* bev) {
+    TlsStream* stream = TlsStream::fromBufferevent(bev);
+    SSL* ssl = stream ? stream->ssl() : bufferevent_openssl_get_ssl(bev);
+    return ssl && SSL_in_init(ssl);
+}
+
+size_t NativeHttpConnection::pendingOutput(bufferevent* bev) {
+    size_t pending = evbuffer_get_length(bufferevent_get_output(bev));
+    bufferevent* underlying = bufferevent_get_underlying(bev);
+    if (underlying) {
+        pending += evbuffer_get_length(bufferevent_get_output(underlying));
+    }
+    return pending;
+}
+
+// 每次I/O之后按连接所处的阶段计时，超时与各阶段的含义见connection_deadline.h
+void NativeHttpConnection::updateDeadline() {
+    const size_t pending = pendingOutput(bev_);
+    TimeoutStage stage;
+    if (lingering_) {
+        stage = STAGE_LINGER;
+    } else if (handshaking(bev_)) {
+        stage = STAGE_HANDSHAKE;
+    } else if (pending > 0) {
+        stage = STAGE_WRITE;
+    } else {
+        stage = http_.readStage(bufferevent_get_input(bev_));
+    }
+    if (stage == STAGE_WRITE && deadline_.stage() != STAGE_WRITE) {
+        writeMark_ = pending;
+    }
+    deadline_.enter(stage, http_.served());
+}
+
+// 写超时与握手超时到期时先确认确实停滞：写出进展与握手完成发生在TLS层，连接收不到通知
+void NativeHttpConnection::onTimeout() {
+    const TimeoutStage stage = deadline_.stage();
+    if (stage == STAGE_WRITE) {
+        const size_t pending = pendingOutput(bev_);
+        if (pending < writeMark_) {
+            writeMark_ = pending;
+            if (pending == 0) {
+                updateDeadline();
+            } else {
+                deadline_.restart();
+            }
+            return;
+        }
+    } else if (stage == STAGE_HANDSHAKE && !handshaking(bev_)) {
+        updateDeadline();
+        return;
+    }
+    close();
+}
+
+void NativeHttpConnection::releaseIdleBuffers(bufferevent* bev) {
+    // 已读空的缓冲区没有数据，但读取时预留的空间仍挂在链上
+    evbuffer* input = bufferevent_get_input(bev);
+    if (evbuffer_get_length(input) == 0) {
+        evbuffer_drain(input, 0);
+    }
+
+    // 内存BIO扩容后不会缩小，空闲时整体替换
+    TlsStream* stream = TlsStream::fromBufferevent(bev);
+    if (stream) {
+        stream->releaseBuffers();
+    }
+}
+
+void NativeHttpConnection::onRead() {
+    // 0-RTT阶段的结果只用于当前数据，握手完成后重新检查
+    if (!inspected_) {
+        inspected_ = inspector_(bev_, state_);
+    }
+
+    // TLS过滤层的密文在底层bufferevent中，积压须连同底层一起计算
+    evbuffer* output = bufferevent_get_output(bev_);
+    http_.process(bufferevent_get_input(bev_), output, pendingOutput(bev_) - evbuffer_get_length(output));
+    if (!http_.closing() && http_.outputBlocked(pendingOutput(bev_))) {
+        // 已缓冲的流水线请求留在输入中，积压发完后继续处理
+        bufferevent_disable(bev_, EV_READ);
+        readPaused_ = true;
+        updateDeadline();
+        return;
+    }
+    if (http_.closing() || peerClosed_) {
+        bufferevent_disable(bev_, EV_READ);
+        // 过滤层会立即把输出搬到底层，此时写回调不会再触发
+        if (evbuffer_get_length(output) == 0) {
+            onWriteDrained();
+            return;
+        }
+    }
+    updateDeadline();
+}
+
+// 输出缓冲已交给传输层
+void NativeHttpConnection::onWriteDrained() {
+    if (readPaused_) {
+        readPaused_ = false;
+        if (!peerClosed_) {
+            bufferevent_enable(bev_, EV_READ);
+        }
+        onRead();
+        return;
+    }
+    if (!http_.closing() && !peerClosed_) {
+        if (options_.leanIdle && evbuffer_get_length(bufferevent_get_input(bev_)) == 0) {
+            releaseIdleBuffers(bev_);
+        }
+        updateDeadline();
+        return;
+    }
+
+    // 过滤层（TlsStream）的输出只是进入了底层bufferevent，等底层发完再关闭，
+    // 此时不再需要过滤层，直接接管底层的回调
+    bufferevent* underlying = bufferevent_get_underlying(bev_);
+    if (underlying && evbuffer_get_length(bufferevent_get_output(underlying)) > 0) {
+        bufferevent_setcb(underlying, nullptr, NativeHttpConnection::underlyingWriteCallback,
+                          NativeHttpConnection::eventCallback, this);
+        bufferevent_enable(underlying, EV_WRITE);
+        updateDeadline();
+        return;
+    }
+    finish();
+}
+
+// 响应已全部发出。请求未读完即被拒绝时，对端可能仍在发送请求体，此时直接close会使内核
+// 以RST回应后续数据，对端可能因此读不到响应；先关闭写方向，丢弃剩余输入直到对端关闭或超时
+void NativeHttpConnection::finish() {
+    bufferevent* raw = bufferevent_get_underlying(bev_);
+    if (!raw) {
+        raw = bev_;
+    }
+    const evutil_socket_t fd = bufferevent_getfd(raw);
+    if (!http_.aborted() || peerClosed_ || fd < 0 || shutdown(fd, SHUT_WR) != 0) {
+        close();
+        return;
+    }
+
+    bufferevent_setcb(raw, NativeHttpConnection::lingerReadCallback, nullptr,
+                      NativeHttpConnection::eventCallback, this);
+    bufferevent_enable(raw, EV_READ);
+    lingering_ = true;
+    updateDeadline();
+    lingerReadCallback(raw, this);
+}
+
+void NativeHttpConnection::close() {
+    onClose_(this);
+}
+
+void NativeHttpConnection::readCallback(bufferevent* /*bev*/, void* ctx) {
+    static_cast<NativeHttpConnection*>(ctx)->onRead();
+}
+
+void NativeHttpConnection::writeCallback(bufferevent* /*bev*/, void* ctx) {
+    static_cast<NativeHttpConnection*>(ctx)->onWriteDrained();
+}
+
+void NativeHttpConnection::underlyingWriteCallback(bufferevent* /*bev*/, void* ctx) {
+    static_cast<NativeHttpConnection*>(ctx)->finish();
+}
+
+void NativeHttpConnection::timeoutCallback(void* arg) {
+    static_cast<NativeHttpConnection*>(arg)->onTimeout();
+}
+
+void NativeHttpConnection::lingerReadCallback(bufferevent* bev, void* ctx) {
+    NativeHttpConnection* conn = static_cast<NativeHttpConnection*>(ctx);
+    evbuffer* input = bufferevent_get_input(bev);
+    conn->lingerBytes_ += evbuffer_get_length(input);
+    evbuffer_drain(input, evbuffer_get_length(input));
+    if (conn->lingerBytes_ > kMaxLingerBytes) {
+        conn->close();
+    }
+}
+
+void NativeHttpConnection::eventCallback(bufferevent* bev, short events, void* ctx) {
+    NativeHttpConnection* conn = static_cast<NativeHttpConnection*>(ctx);
+    // bufferevent_openssl完成握手，转入等待请求（TlsStream过滤层没有此事件，由握手超时到期时确认）
+    if (events == BEV_EVENT_CONNECTED) {
+        conn->updateDeadline();
+        return;
+    }
+    // 对端只关闭了写方向：发完已产生的响应后再关闭
+    if ((events & BEV_EVENT_EOF) && !(events & BEV_EVENT_ERROR) &&
+        evbuffer_get_length(bufferevent_get_output(bev)) > 0) {
+        conn->peerClosed_ = true;
+        bufferevent_disable(bev, EV_READ);
+        conn->updateDeadline();
+        return;
+    }
+    if (events & (BEV_EVENT_EOF | BEV_EVENT_ERROR | BEV_EVENT_TIMEOUT)) {
+        conn->close();
+    }
+}
@@ -0,0 +1,237 @@
+// src/framework/rpc_metrics.cpp
+#include "framework/rpc_metrics.h"
+#include <cstdio>
+
+namespace {
+
+std::atomic<uint64_t> nextMetricsId(1);
+
+// 直方图导出时每4个桶取一个边界（半个2的幂区间），每个序列的le集合固定，
+// 不同实例、不同时刻的同名桶才能直接相加与求rate
+const unsigned kExportStride = 4;
+static_assert(LatencyBuckets::kCount % kExportStride == 0, "last bucket must be exported");
+
+// 只由所属线程写入：读出再写回，省去读改写指令的总线锁
+inline void bump(std::atomic<uint64_t>& counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void appendLabels(std::string& out, const std::string& method, ListenerKind listener) {
+    out += "{method=\"";
+    out += method;
+    out += "\",listener=\"";
+    out += listenerKindName(listener);
+    out += '"';
+}
+
+void appendValue(std::string& out, uint64_t value) {
+    char number[24];
+    snprintf(number, sizeof(number), " %llu\n", static_cast<unsigned long long>(value));
+    out += number;
+}
+
+} // namespace
+
+const char* requestPhaseName(RequestPhase phase) {
+    static const char* const kNames[kPhaseCount] = {"read", "parse", "params", "method", "lookup", "execute", "respond"};
+    return kNames[phase];
+}
+
+std::string serverTiming(const PhaseClock& phases) {
+    const double millisPerCycle = nanosPerCycle() / 1e6;
+    std::string value;
+    uint64_t total = 0;
+    char item[48];
+    for (int phase = 0; phase < kPhaseCount; ++phase) {
+        if (phases.cycles[phase] == 0) {
+            continue;
+        }
+        total += phases.cycles[phase];
+        snprintf(item, sizeof(item), "%s;dur=%.3f, ", requestPhaseName(static_cast<RequestPhase>(phase)),
+                 static_cast<double>(phases.cycles[phase]) * millisPerCycle);
+        value += item;
+    }
+    snprintf(item, sizeof(item), "total;dur=%.3f", static_cast<double>(total) * millisPerCycle);
+    value += item;
+    return value;
+}
+
+uint64_t LatencyBuckets::upperBound(unsigned index) {
+    if (index < (1u << kSubBits)) {
+        return index;
+    }
+    const unsigned shift = (index >> kSubBits) - 1;
+    const uint64_t lower = static_cast<uint64_t>((1u << kSubBits) + (index & ((1u << kSubBits) - 1))) << shift;
+    return lower + (static_cast<uint64_t>(1) << shift) - 1;
+}
+
+MetricsShard::MetricsShard(size_t methods)
+    : calls(methods * kListenerKindCount * kMetricCodeCount),
+      buckets(methods * kListenerKindCount * LatencyBuckets::kCount),
+      sumUs(methods * kListenerKindCount),
+      phaseCycles(methods * kPhaseCount) {}
+
+RpcMetrics::RpcMetrics() : id_(nextMetricsId.fetch_add(1)) {
+    methodNames_.push_back("unknown");
+}
+
+void RpcMetrics::addMethod(const std::string& service, const std::string& method) {
+    unsigned& index = methods_[service][method];
+    if (index == kUnknownMethod) {
+        index = static_cast<unsigned>(methodNames_.size());
+        methodNames_.push_back(service + "." + method);
+    }
+}
+
+unsigned RpcMetrics::methodIndex(const std::string& service, const std::string& method) const {
+    std::unordered_map<std::string, std::unordered_map<std::string, unsigned> >::const_iterator it =
+        methods_.find(service);
+    if (it == methods_.end()) {
+        return kUnknownMethod;
+    }
+    std::unordered_map<std::string, unsigned>::const_iterator found = it->second.find(method);
+    return found == it->second.end() ? kUnknownMethod : found->second;
+}
+
+unsigned RpcMetrics::codeIndex(int code) {
+    for (unsigned i = 0; i + 1 < kMetricCodeCount; ++i) {
+        if (kMetricCodes[i] == code) {
+            return i;
+        }
+    }
+    return kMetricCodeCount - 1;
+}
+
+// 线程首次记录时创建并登记自己的分片，此后直接使用线程局部的指针
+MetricsShard* RpcMetrics::threadShard() {
+    static thread_local MetricsShard* shard = nullptr;
+    static thread_local uint64_t owner = 0;
+    if (owner != id_) {
+        std::unique_ptr<MetricsShard> created(new MetricsShard(methodNames_.size()));
+        shard = created.get();
+        std::lock_guard<std::mutex> lock(shardsMutex_);
+        shards_.push_back(std::move(created));
+        owner = id_;
+    }
+    return shard;
+}
+
+void RpcMetrics::record(unsigned method, ListenerKind listener, int code, uint32_t latencyUs,
+                        const PhaseClock& phases) {
+    MetricsShard* shard = threadShard();
+    const size_t series = method * kListenerKindCount + listener;
+    bump(shard->calls[series * kMetricCodeCount + codeIndex(code)], 1);
+    bump(shard->buckets[series * LatencyBuckets::kCount + LatencyBuckets::index(latencyUs)], 1);
+    bump(shard->sumUs[series], latencyUs);
+    for (int phase = 0; phase < kPhaseCount; ++phase) {
+        bump(shard->phaseCycles[method * kPhaseCount + phase], phases.cycles[phase]);
+    }
+}
+
+void RpcMetrics::render(std::string& out) const {
+    const size_t seriesCount = methodNames_.size() * kListenerKindCount;
+    std::vector<uint64_t> calls(seriesCount * kMetricCodeCount);
+    std::vector<uint64_t> buckets(seriesCount * LatencyBuckets::kCount);
+    std::vector<uint64_t> sumUs(seriesCount);
+    std::vector<uint64_t> phaseCycles(methodNames_.size() * kPhaseCount);
+    {
+        std::lock_guard<std::mutex> lock(shardsMutex_);
+        for (size_t s = 0; s < shards_.size(); ++s) {
+            const MetricsShard& shard = *shards_[s];
+            for (size_t i = 0; i < calls.size(); ++i) {
+                calls[i] += shard.calls[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < sumUs.size(); ++i) {
+                sumUs[i] += shard.sumUs[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < phaseCycles.size(); ++i) {
+                phaseCycles[i] += shard.phaseCycles[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    out += "# HELP rpc_requests_total JSON-RPC calls by method, listener and response code (0 = success).\n";
+    out += "# TYPE rpc_requests_total counter\n";
+    for (size_t series = 0; series < seriesCount; ++series) {
+        const std::string& method = methodNames_[series / kListenerKindCount];
+        const ListenerKind listener = static_cast<ListenerKind>(series % kListenerKindCount);
+        for (unsigned c = 0; c < kMetricCodeCount; ++c) {
+            const uint64_t n = calls[series * kMetricCodeCount + c];
+            if (n == 0) {
+                continue;
+            }
+            out += "rpc_requests_total";
+            appendLabels(out, method, listener);
+            if (c + 1 < kMetricCodeCount) {
+                char code[32];
+                snprintf(code, sizeof(code), ",code=\"%d\"}", kMetricCodes[c]);
+                out += code;
+            } else {
+                out += ",code=\"other\"}";
+            }
+            appendValue(out, n);
+        }
+    }
+
+    out += "# HELP rpc_request_duration_microseconds Time from dispatch to response, log-bucketed.\n";
+    out += "# TYPE rpc_request_duration_microseconds histogram\n";
+    for (size_t series = 0; series < seriesCount; ++series) {
+        const std::string& method = methodNames_[series / kListenerKindCount];
+        const ListenerKind listener = static_cast<ListenerKind>(series % kListenerKindCount);
+        const uint64_t* seriesBuckets = &buckets[series * LatencyBuckets::kCount];
+        uint64_t total = 0;
+        for (unsigned b = 0; b < LatencyBuckets::kCount; ++b) {
+            total += seriesBuckets[b];
+        }
+        if (total == 0) {
+            continue;
+        }
+        // 未导出的桶计入下一个导出边界的累计值；kCount是kExportStride的倍数，最后一个桶总会导出
+        uint64_t cumulative = 0;
+        for (unsigned b = 0; b < LatencyBuckets::kCount; ++b) {
+            cumulative += seriesBuckets[b];
+            if (b % kExportStride != kExportStride - 1) {
+                continue;
+            }
+            char le[40];
+            snprintf(le, sizeof(le), ",le=\"%llu\"}", static_cast<unsigned long long>(LatencyBuckets::upperBound(b)));
+            out += "rpc_request_duration_microseconds_bucket";
+            appendLabels(out, method, listener);
+            out += le;
+            appendValue(out, cumulative);
+        }
+        out += "rpc_request_duration_microseconds_bucket";
+        appendLabels(out, method, listener);
+        out += ",le=\"+Inf\"}";
+        appendValue(out, cumulative);
+        out += "rpc_request_duration_microseconds_sum";
+        appendLabels(out, method, listener);
+        out += '}';
+        appendValue(out, sumUs[series]);
+        out += "rpc_request_duration_microseconds_count";
+        appendLabels(out, method, listener);
+        out += '}';
+        appendValue(out, cumulative);
+    }
+
+    // 各阶段只累计总耗时，除以同一方法的rpc_requests_total即为平均值
+    out += "# HELP rpc_request_phase_microseconds_total Time spent in each dispatch phase, TSC-timed.\n";
+    out += "# TYPE rpc_request_phase_microseconds_total counter\n";
+    const double microsPerCycle = nanosPerCycle() / 1000.0;
+    for (size_t m = 0; m < methodNames_.size(); ++m) {
+        for (int phase = 0; phase < kPhaseCount; ++phase) {
+            const uint64_t cycles = phaseCycles[m * kPhaseCount + phase];
+            if (cycles == 0) {
+                continue;
+            }
+            char line[160];
+            snprintf(line, sizeof(line), "rpc_request_phase_microseconds_total{method=\"%s\",phase=\"%s\"} %.3f\n",
+                     methodNames_[m].c_str(), requestPhaseName(static_cast<RequestPhase>(phase)),
+                     static_cast<double>(cycles) * microsPerCycle);
+            out += line;
+        }
+    }
+}
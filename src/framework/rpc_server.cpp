@@ -1,19 +1,29 @@
 // src/framework/rpc_server.cpp
 #include "framework/rpc_server.h" // 添加 rpc_server.h 头文件包含
 #include "framework/ioc_container.h" // 修改包含路径
+#include "framework/tls_stream.h"
+#include "framework/http_response.h"
+#include "framework/uring_backend.h"
 #include "services/rpc_service.h"
 #include "mem_mgmt/safe_ptr.h"
 #include "mem_mgmt/weak_ptr.h"
 #include "mem_mgmt/lock_guard.h"
+#include <event2/event.h>
 #include <event2/listener.h>
 #include <event2/buffer.h>
 #include <event2/bufferevent_ssl.h> // 添加 bufferevent_ssl 头文件包含
 #include <openssl/ssl.h> // 添加 OpenSSL 头文件包含
 #include <openssl/err.h> // 添加 OpenSSL 错误处理头文件包含
 #include <iostream>
-#include <sstream>
 #include <nlohmann/json.hpp>
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#include <algorithm>
 
 using namespace std;
 
@@ -24,47 +34,96 @@ static void initOpenSSL() {
     OpenSSL_add_all_algorithms();
 }
 
-// URI路径分割工具
-vector<string> RpcServer::splitUri(const string& uri) {
-    vector<string> tokens;
-    istringstream iss(uri);
-    string token;
-    
-    while (getline(iss, token, '/')) {
-        if (!token.empty()) {
-            tokens.push_back(token);
-        }
-    }
-    return tokens;
-}
-
-// 发送成功响应
-void RpcServer::sendSuccessResponse(evhttp_request* req,
-    const nlohmann::json& result,
-    const nlohmann::json& id) 
-{
+// 构造成功响应体
+std::string RpcServer::successBody(const nlohmann::json& result, const nlohmann::json& id) {
     nlohmann::json response = {
         {"jsonrpc", "2.0"},
         {"result", result},
         {"id", id}
     };
+    return response.dump();
+}
 
-    evbuffer* output = evhttp_request_get_output_buffer(req);
-    evhttp_add_header(evhttp_request_get_output_headers(req), 
-        "Content-Type", "application/json");
-    evhttp_add_header(evhttp_request_get_output_headers(req), 
-        "Strict-Transport-Security", 
-        "max-age=63072000; includeSubDomains");        
-    evbuffer_add_printf(output, "%s", response.dump().c_str());
-    evhttp_send_reply(req, HTTP_OK, nullptr, output);
+namespace {
+
+// 流式响应体每段的目标长度：逐个元素成块时分块开销与系统调用过多
+const size_t kStreamChunkSize = 16 * 1024;
+
+// 流式方法的响应体{"id":...,"jsonrpc":"2.0","result":[...]}，键序与successBody一致
+// 每次拉取时向结果流取元素，攒够kStreamChunkSize即交给传输
+class JsonResponseStream : public ResponseStream {
+public:
+    JsonResponseStream(std::unique_ptr<RpcService> service, std::unique_ptr<ResultStream> results,
+                       const std::string& method, const nlohmann::json& id)
+        : service_(std::move(service)), results_(std::move(results)), method_(method), id_(id),
+          started_(false), empty_(true) {}
+
+    bool next(std::string& chunk) override {
+        if (!started_) {
+            chunk = "{\"id\":" + id_.dump() + ",\"jsonrpc\":\"2.0\",\"result\":[";
+            started_ = true;
+        }
+        try {
+            while (chunk.size() < kStreamChunkSize) {
+                if (!results_->next(element_)) {
+                    chunk += "]}";
+                    return false;
+                }
+                if (!empty_) {
+                    chunk += ',';
+                }
+                empty_ = false;
+                chunk += element_.dump();
+            }
+        } catch (const std::exception& e) {
+            cerr << "Stream " << method_ << " aborted: " << e.what() << endl;
+            throw;
+        }
+        return true;
+    }
+
+private:
+    std::unique_ptr<RpcService> service_; // 结果流可能引用服务实例，须最后析构
+    std::unique_ptr<ResultStream> results_;
+    std::string method_;
+    nlohmann::json id_;
+    nlohmann::json element_;
+    bool started_;
+    bool empty_;
+};
+
+// 不能分块发送的传输（HTTP/2、二进制帧、WebSocket、HTTP/1.0）把流式响应体拼接完整后一次发出；
+// 超过limit即放弃，单个请求不能在事件循环上产生任意大的响应，峰值内存与流式发送时的积压上限相当
+bool collectResponse(ResponseStream& body, size_t limit, std::string& response) {
+    std::string chunk;
+    bool more = true;
+    while (more) {
+        chunk.clear();
+        more = body.next(chunk);
+        if (response.size() + chunk.size() > limit) {
+            response.clear();
+            return false;
+        }
+        response += chunk;
+    }
+    return true;
 }
 
-// 发送错误响应
-void RpcServer::sendErrorResponse(evhttp_request* req,
-  int code,
-  const std::string& message,
-  const nlohmann::json& id) 
-{
+} // namespace
+
+// evhttp兼容模式下进行中的流式响应，按连接登记，连接关闭时由connectionClosedCallback清理
+struct EvhttpStream {
+    evhttp_request* req;
+    evhttp_connection* conn;
+    std::unique_ptr<ResponseStream> body;
+    size_t highWater;   // 待发送的输出达到此长度时暂停拉取；流式响应期间预读的后续请求也以此为限
+    bool failed;        // 结果流中途失败，等待连接关闭
+    bool pumping;       // 正在pumpEvhttpStream中，期间的发空回调不再重入
+    std::string chunk;
+};
+
+// 构造错误响应体
+std::string RpcServer::errorBody(int code, const std::string& message, const nlohmann::json& id) {
     nlohmann::json error = {
         {"code", code},
         {"message", message}
@@ -75,22 +134,52 @@ void RpcServer::sendErrorResponse(evhttp_request* req,
         {"error", error},
         {"id", id}
     };
+    return response.dump();
+}
 
+// 通过evhttp发送JSON响应
+// evhttp自行序列化其响应头链表，无法使用预先格式化的头部块，兼容模式保留逐个添加
+void RpcServer::sendJsonResponse(evhttp_request* req, const std::string& body, ContentCoding coding) {
     evbuffer* output = evhttp_request_get_output_buffer(req);
     evhttp_add_header(evhttp_request_get_output_headers(req), 
-        "Content-Type", "application/json");
+        "Content-Type", kJsonContentType);
     evhttp_add_header(evhttp_request_get_output_headers(req), 
-        "Strict-Transport-Security", 
-        "max-age=63072000; includeSubDomains");
-    evbuffer_add_printf(output, "%s", response.dump().c_str());
+        "Strict-Transport-Security", kHstsHeaderValue);
+    if (coding != CODING_IDENTITY) {
+        evhttp_add_header(evhttp_request_get_output_headers(req),
+            "Content-Encoding", contentCodingName(coding));
+        evhttp_add_header(evhttp_request_get_output_headers(req), "Vary", "Accept-Encoding");
+    }
+    evbuffer_add(output, body.data(), body.size());
     evhttp_send_reply(req, HTTP_OK, nullptr, output);
 }
 
 // 构造函数
-RpcServer::RpcServer(int port, const char* certPath, const char* keyPath) 
-    : sslCtx_(nullptr), base_(nullptr), http_(nullptr) {
+RpcServer::RpcServer(int port, const char* certPath, const char* keyPath,
+                     const ServerOptions& options) 
+    : sslCtx_(nullptr), base_(nullptr), http_(nullptr),
+      options_(options), replayWindow_(options.replayWindowSec), timers_(kConnectionTimerTickMs) {
     
     initOpenSSL();
+
+    for (int kind = 0; kind < kListenerKindCount; ++kind) {
+        HttpOptions& http = httpOptions_[kind];
+        http.maxRequests = options_.keepAliveRequests;
+        http.timeouts = options_.timeouts;
+        http.leanIdle = options_.leanIdle;
+        http.compression = options_.compression;
+        http.limits = options_.limits[kind];
+        http.route = [this](StringRef target, size_t listenerLimit) {
+            return resolveRoute(target, listenerLimit);
+        };
+        http.methodIds = [this](uint32_t methodId, StringRef& target) {
+            return resolveMethodId(methodId, target);
+        };
+        http.webSocket.enabled = options_.webSocket && !isBinaryListener(static_cast<ListenerKind>(kind));
+        http.webSocket.deflate = options_.webSocketDeflate;
+        http.webSocket.maxInflatedSize = options_.maxDecompressedSize;
+        http.traceHeader = options_.debugTrace;
+    }
     
     // 创建SSL上下文
     sslCtx_ = SSL_CTX_new(TLS_server_method());
@@ -117,6 +206,20 @@ RpcServer::RpcServer(int port, const char* certPath, const char* keyPath)
     // 启用会话票据
     SSL_CTX_set_num_tickets(sslCtx_, 5); // 合理数量平衡安全与性能    
 
+    // 空闲连接省内存：连接无待处理数据时释放OpenSSL的读写缓冲（每连接约数十KB）
+    if (options_.leanIdle) {
+        SSL_CTX_set_mode(sslCtx_, SSL_MODE_RELEASE_BUFFERS);
+    }
+
+    // 启用TLS 1.3 0-RTT早期数据（可选）
+    // 早期数据可被重放，除OpenSSL自带的单次票据检查外再由防重放窗口把关，
+    // 请求处理时还会限制只能调用声明为可重放的方法
+    if (options_.earlyData) {
+        SSL_CTX_set_max_early_data(sslCtx_, options_.maxEarlyData);
+        SSL_CTX_set_recv_max_early_data(sslCtx_, options_.maxEarlyData);
+        SSL_CTX_set_allow_early_data_cb(sslCtx_, RpcServer::allowEarlyDataCallback, this);
+    }
+
     // 加载证书链
     if (SSL_CTX_use_certificate_chain_file(sslCtx_, certPath) <= 0) {
         cerr << "Error loading certificate: " 
@@ -141,206 +244,1258 @@ RpcServer::RpcServer(int port, const char* certPath, const char* keyPath)
         throw runtime_error("Key validation failed");
     }
 
+    if (!options_.audit.path.empty() && !audit_.open(options_.audit)) {
+        cerr << "Error opening audit log " << options_.audit.path << ": " << strerror(errno) << endl;
+        SSL_CTX_free(sslCtx_);
+        throw runtime_error("Audit log open failed");
+    }
+
+    // 二进制帧协议的methodId表，二进制监听与WebSocket的二进制消息共用（后者也用于io_uring后端）
+    if (options_.binaryPort > 0 || !options_.binarySocketPath.empty() || options_.webSocket) {
+        buildBinaryMethodTable();
+    }
+    // 指标的方法表：只为已注册的方法建立时间序列
+    if (options_.adminPort > 0) {
+        IocContainer& container = IocContainer::getInstance();
+        const std::vector<std::string> serviceIds = container.serviceIds();
+        for (size_t i = 0; i < serviceIds.size(); ++i) {
+            const std::vector<std::string> methods = container.getService(serviceIds[i])->methodNames();
+            for (size_t j = 0; j < methods.size(); ++j) {
+                metrics_.addMethod(serviceIds[i], methods[j]);
+            }
+        }
+    }
+    if (options_.adminPort > 0 || options_.debugTrace) {
+        nanosPerCycle(); // 校准阶段计时的时钟，不落在第一个请求上
+    }
+
+    // 选择传输后端
+    if (options_.backend == "io_uring") {
+        initUringBackend(port);
+        return;
+    }
+    if (options_.backend != "libevent") {
+        freeResources();
+        throw runtime_error("Unknown transport backend: " + options_.backend);
+    }
+    if (options_.httpEngine != "native" && options_.httpEngine != "evhttp") {
+        freeResources();
+        throw runtime_error("Unknown HTTP engine: " + options_.httpEngine);
+    }
+    if (options_.webSocket && options_.httpEngine == "evhttp") {
+        freeResources();
+        throw runtime_error("WebSocket requires the native HTTP engine");
+    }
+    // evhttp自行accept，连接数不经onConnectionOpened统计
+    if (options_.maxConnections > 0 && options_.httpEngine == "evhttp") {
+        freeResources();
+        throw runtime_error("--max-connections requires the native HTTP engine");
+    }
+
     // 初始化事件循环
     base_ = event_base_new();
     if (!base_) {
         SSL_CTX_free(sslCtx_);
         throw runtime_error("Could not initialize event base");
     }
+    backend_ = new LibeventBackend(base_);
+
+    // 所有原生连接的超时挂在同一个时间轮上，由一个周期事件驱动
+    timerTick_ = event_new(base_, -1, EV_PERSIST, RpcServer::timerTickCallback, this);
+    timeval tick = {0, static_cast<suseconds_t>(kConnectionTimerTickMs * 1000)};
+    if (!timerTick_ || event_add(timerTick_, &tick) != 0) {
+        freeResources();
+        throw runtime_error("Could not start connection timer");
+    }
 
     // 创建HTTP服务器
-    http_ = evhttp_new(base_);
-    if (!http_) {
-        event_base_free(base_);
-        SSL_CTX_free(sslCtx_);
+    Listener* tls = addListener(LISTENER_TLS);
+    if (!tls) {
+        freeResources();
         throw runtime_error("Could not create HTTP server");
     }
+    http_ = tls->http;
 
-    // 设置SSL回调
-    evhttp_set_bevcb(http_, RpcServer::bevCallback, this);
+    // 设置SSL回调（原生引擎在接受连接时自行创建TLS bufferevent）
+    if (http_) {
+        evhttp_set_bevcb(http_, RpcServer::bevCallback, this);
+    }
 
     // 绑定端口
-    if (evhttp_bind_socket(http_, "0.0.0.0", port) != 0) {
-        evhttp_free(http_);
-        event_base_free(base_);
-        SSL_CTX_free(sslCtx_);
+    if (!bindListener(tls, "0.0.0.0", port)) {
+        freeResources();
         throw runtime_error("Could not bind to port");
     }
 
-    cout << "Server started on port " << port << endl;
+    cout << "Server started on port " << port << " (" << options_.httpEngine << ")" << endl;
+
+    // 同机sidecar使用的Unix域套接字
+    if (!options_.unixSocketPath.empty()) {
+        Listener* local = addListener(LISTENER_UNIX);
+        if (!local || !bindUnixSocket(local, options_.unixSocketPath)) {
+            freeResources();
+            throw runtime_error("Could not bind unix socket " + options_.unixSocketPath);
+        }
+        cout << "Listening on unix socket " << options_.unixSocketPath << endl;
+    }
+
+    // 仅回环地址可达的明文HTTP
+    if (options_.plainPort > 0) {
+        Listener* plain = addListener(LISTENER_PLAIN);
+        if (!plain || !bindListener(plain, "127.0.0.1", options_.plainPort)) {
+            freeResources();
+            throw runtime_error("Could not bind plaintext loopback port");
+        }
+        cout << "Listening on 127.0.0.1:" << options_.plainPort << " (plaintext)" << endl;
+    }
+
+    // HTTP/2（多路复用，经ALPN协商）
+    if (options_.http2Port > 0) {
+#ifdef RPC_HAVE_NGHTTP2
+        if (!bindHttp2(options_.http2Port)) {
+            freeResources();
+            throw runtime_error("Could not bind HTTP/2 port");
+        }
+        cout << "Listening on port " << options_.http2Port << " (HTTP/2)" << endl;
+#else
+        freeResources();
+        throw runtime_error("HTTP/2 support not compiled in, rebuild with NGHTTP2=1");
+#endif
+    }
+
+    // 内部调用方使用的二进制帧协议
+    if (options_.binaryPort > 0) {
+        Listener* binary = addListener(LISTENER_BINARY);
+        if (!binary || !bindListener(binary, "0.0.0.0", options_.binaryPort)) {
+            freeResources();
+            throw runtime_error("Could not bind binary protocol port");
+        }
+        cout << "Listening on port " << options_.binaryPort << " (binary frames)" << endl;
+    }
+    if (!options_.binarySocketPath.empty()) {
+        Listener* binaryLocal = addListener(LISTENER_BINARY_UNIX);
+        if (!binaryLocal || !bindUnixSocket(binaryLocal, options_.binarySocketPath)) {
+            freeResources();
+            throw runtime_error("Could not bind unix socket " + options_.binarySocketPath);
+        }
+        cout << "Listening on unix socket " << options_.binarySocketPath << " (binary frames)" << endl;
+    }
+
+    if (options_.adminPort > 0) {
+        if (!bindAdmin(options_.adminPort)) {
+            freeResources();
+            throw runtime_error("Could not bind admin port");
+        }
+        cout << "Listening on 127.0.0.1:" << options_.adminPort << " (admin, /metrics)" << endl;
+    }
 }
 
-// SSL连接回调
-bufferevent* RpcServer::bevCallback(event_base* base, void* arg) {
-    auto* server = static_cast<RpcServer*>(arg);
-    SSL* ssl = SSL_new(server->sslCtx_);
-    return bufferevent_openssl_socket_new(base, -1, ssl,
-                                        BUFFEREVENT_SSL_ACCEPTING,
-                                        BEV_OPT_CLOSE_ON_FREE);
+// 管理端口请求很少，直接用evhttp处理，不经过RPC的分发与限制
+bool RpcServer::bindAdmin(int port) {
+    admin_ = evhttp_new(base_);
+    if (!admin_ || evhttp_bind_socket(admin_, "127.0.0.1", static_cast<ev_uint16_t>(port)) != 0) {
+        return false;
+    }
+    evhttp_set_allowed_methods(admin_, EVHTTP_REQ_GET | EVHTTP_REQ_HEAD);
+    evhttp_set_cb(admin_, "/metrics", RpcServer::metricsCallback, this);
+    return true;
 }
 
-void RpcServer::logAudit(const std::map<std::string, std::string>& auditData) {
-    try {
-        nlohmann::json auditLog;
-        for (std::map<std::string, std::string>::const_iterator it = auditData.begin(); it != auditData.end(); ++it) {
-            auditLog[it->first] = it->second;
+void RpcServer::metricsCallback(evhttp_request* req, void* arg) {
+    RpcServer* server = static_cast<RpcServer*>(arg);
+    std::string body;
+    server->metrics_.render(body);
+    body += "# HELP rpc_audit_dropped_total Audit records dropped because the ring was full.\n";
+    body += "# TYPE rpc_audit_dropped_total counter\n";
+    body += "rpc_audit_dropped_total " + std::to_string(server->audit_.dropped()) + "\n";
+
+    evkeyvalq* headers = evhttp_request_get_output_headers(req);
+    evhttp_add_header(headers, "Content-Type", "text/plain; version=0.0.4");
+    evbuffer* buffer = evbuffer_new();
+    evbuffer_add(buffer, body.data(), body.size());
+    evhttp_send_reply(req, HTTP_OK, "OK", buffer);
+    evbuffer_free(buffer);
+}
+
+// 为每个已注册的方法计算methodId，启动时发现哈希冲突即报错，不让两个方法共用一个标识
+void RpcServer::buildBinaryMethodTable() {
+    IocContainer& container = IocContainer::getInstance();
+    const std::vector<std::string> serviceIds = container.serviceIds();
+    for (size_t i = 0; i < serviceIds.size(); ++i) {
+        auto service = container.getService(serviceIds[i]);
+        const std::vector<std::string> methods = service->methodNames();
+        for (size_t j = 0; j < methods.size(); ++j) {
+            const std::string qualified = serviceIds[i] + "." + methods[j];
+            const uint32_t id = binaryMethodId(StringRef(qualified));
+            const std::string path = "/rpc/" + serviceIds[i] + "/" + methods[j];
+            if (id == 0 || !binaryMethods_.insert(std::make_pair(id, path)).second) {
+                freeResources();
+                throw runtime_error("Binary method id collision: " + qualified);
+            }
+        }
+    }
+}
+
+// methodId -> 请求目标，未知的methodId返回false
+bool RpcServer::resolveMethodId(uint32_t methodId, StringRef& target) const {
+    std::unordered_map<uint32_t, std::string>::const_iterator it = binaryMethods_.find(methodId);
+    if (it == binaryMethods_.end()) {
+        return false;
+    }
+    target = StringRef(it->second);
+    return true;
+}
+
+// 创建io_uring后端并绑定HTTPS端口与明文回环端口
+void RpcServer::initUringBackend(int port) {
+#ifdef RPC_HAVE_LIBURING
+    if (!options_.unixSocketPath.empty() || options_.http2Port > 0 ||
+        options_.binaryPort > 0 || !options_.binarySocketPath.empty() || options_.adminPort > 0 ||
+        options_.maxConnections > 0) {
+        freeResources();
+        throw runtime_error("io_uring backend does not support --unix-socket, --h2-port, binary listeners, "
+                            "--admin-port or --max-connections");
+    }
+
+    UringBackend* uring = new UringBackend(sslCtx_, makeDispatcher());
+    backend_ = uring;
+    if (!uring->init()) {
+        freeResources();
+        throw runtime_error("Could not initialize io_uring");
+    }
+    if (!uring->listen("0.0.0.0", port, true, httpOptions_[LISTENER_TLS])) {
+        freeResources();
+        throw runtime_error("Could not bind to port");
+    }
+    cout << "Server started on port " << port << " (io_uring)" << endl;
+
+    if (options_.plainPort > 0) {
+        if (!uring->listen("127.0.0.1", options_.plainPort, false, httpOptions_[LISTENER_PLAIN])) {
+            freeResources();
+            throw runtime_error("Could not bind plaintext loopback port");
         }
-        std::ostringstream oss;
-        oss << time(nullptr);
-        auditLog["timestamp"] = oss.str();
+        cout << "Listening on 127.0.0.1:" << options_.plainPort << " (plaintext)" << endl;
+    }
+#else
+    (void)port;
+    freeResources();
+    throw runtime_error("io_uring backend not compiled in, rebuild with LIBURING=1");
+#endif
+}
 
-        // 方式2：格式化JSON（推荐用于日志）
-        std::string logEntry = auditLog.dump(4);
+// 创建监听器，evhttp模式下同时创建其evhttp实例
+Listener* RpcServer::addListener(ListenerKind kind) {
+    evhttp* http = nullptr;
+    if (options_.httpEngine == "evhttp" && !isBinaryListener(kind)) {
+        http = evhttp_new(base_);
+        if (!http) {
+            return nullptr;
+        }
+        // evhttp的超时同时作用于握手、空闲等待与读写，不区分阶段；单连接请求数上限在requestHandler中处理
+        if (options_.timeouts.idleSec > 0) {
+            evhttp_set_timeout(http, options_.timeouts.idleSec);
+        }
+        // evhttp按Content-Length在读取请求体前以413拒绝；它在请求路由之前生效，只能用监听器级上限
+        const RequestLimits& limits = options_.limits[kind];
+        evhttp_set_max_headers_size(http, static_cast<ev_ssize_t>(limits.maxHeaderSize));
+        evhttp_set_max_body_size(http, static_cast<ev_ssize_t>(limits.maxBodySize));
+    }
+    Listener* listener = new Listener;
+    listener->server = this;
+    listener->kind = kind;
+    listener->http = http;
+    listener->native = nullptr;
+    listeners_.push_back(listener);
+    return listener;
+}
 
-        // 写入日志文件或发送到日志系统
-        //logService.write(logEntry);
-        std::cout << "Audit Log: " << logEntry << std::endl;
+// 绑定TCP地址并开始接收连接
+bool RpcServer::bindListener(Listener* listener, const char* address, int port) {
+    if (listener->http) {
+        return evhttp_bind_socket(listener->http, address, static_cast<ev_uint16_t>(port)) == 0;
+    }
 
-    } catch (const nlohmann::json::exception& e) {
-        std::cerr << "JSON serialization error: " << e.what() << std::endl;
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+        return false;
     }
+    listener->native = evconnlistener_new_bind(base_, RpcServer::nativeAcceptCallback, listener,
+        LEV_OPT_CLOSE_ON_FREE | LEV_OPT_REUSEABLE, -1,
+        reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    return listener->native != nullptr;
 }
 
-void RpcServer::requestHandler(evhttp_request* req, void* arg) {
-    nlohmann::json requestJson;
-    nlohmann::json id = nullptr;
+// 在已绑定并监听的套接字上接收连接，成功后套接字归监听器所有
+bool RpcServer::acceptSocket(Listener* listener, evutil_socket_t fd) {
+    if (listener->http) {
+        return evhttp_accept_socket(listener->http, fd) == 0;
+    }
+    listener->native = evconnlistener_new(base_, RpcServer::nativeAcceptCallback, listener,
+        LEV_OPT_CLOSE_ON_FREE, -1, fd);
+    return listener->native != nullptr;
+}
+
+// 清理上次运行遗留的套接字文件：路径上须是套接字，且已没有进程在监听（连接被拒绝），
+// 否则拒绝启动，以免误删普通文件或抢走另一个运行中实例的套接字
+static bool removeStaleSocket(const sockaddr_un& addr, const std::string& path) {
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) {
+        return errno == ENOENT;
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        cerr << "Refusing to replace " << path << ": not a socket" << endl;
+        return false;
+    }
+    evutil_socket_t probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) {
+        return false;
+    }
+    const bool live = connect(probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+    const int probeError = errno;
+    evutil_closesocket(probe);
+    if (live) {
+        cerr << "Unix socket " << path << " is in use by another process" << endl;
+        return false;
+    }
+    if (probeError != ECONNREFUSED) {
+        cerr << "Cannot probe unix socket " << path << ": " << strerror(probeError) << endl;
+        return false;
+    }
+    return unlink(path.c_str()) == 0 || errno == ENOENT;
+}
+
+// 绑定Unix域套接字并交给监听器接收连接
+bool RpcServer::bindUnixSocket(Listener* listener, const std::string& path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        cerr << "Unix socket path too long: " << path << endl;
+        return false;
+    }
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    evutil_socket_t fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    if (!removeStaleSocket(addr, path)) {
+        evutil_closesocket(fd);
+        return false;
+    }
+    // 套接字文件创建时即为0660，只允许同组用户连接，最终以SO_PEERCRED校验为准；
+    // bind之后再chmod会留下一段按umask放开权限的窗口
+    const mode_t previousMask = umask(0117);
+    const bool bound = bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    const int bindError = errno;
+    umask(previousMask);
+    if (!bound || listen(fd, SOMAXCONN) != 0 ||
+        evutil_make_socket_nonblocking(fd) != 0) {
+        cerr << "Error binding unix socket " << path << ": " << strerror(bound ? errno : bindError) << endl;
+        evutil_closesocket(fd);
+        if (bound) {
+            unlink(path.c_str());
+        }
+        return false;
+    }
+    unixSockets_.push_back(path);
+
+    if (!acceptSocket(listener, fd)) {
+        evutil_closesocket(fd);
+        return false;
+    }
+    return true;
+}
+
+// 通过SO_PEERCRED校验Unix域套接字对端进程的uid
+bool RpcServer::isTrustedPeer(evutil_socket_t fd, std::string& identity) const {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (fd < 0 || getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) {
+        return false;
+    }
+    identity = "uid:" + std::to_string(cred.uid);
+    if (cred.uid == geteuid()) {
+        return true;
+    }
+    return std::find(options_.trustedUids.begin(), options_.trustedUids.end(), cred.uid)
+        != options_.trustedUids.end();
+}
+
+// 获取连接级状态：已缓存则直接返回，否则检查连接并在握手完成后缓存
+ConnectionState* RpcServer::getConnectionState(evhttp_connection* conn, const Listener* listener,
+                                               ConnectionState& scratch) {
+    std::unordered_map<evhttp_connection*, ConnectionState*>::iterator it = connections_.find(conn);
+    if (it != connections_.end()) {
+        return it->second;
+    }
+
+    // 0-RTT请求到达时握手尚未完成，结果只用于本次请求，握手完成后的请求会重新检查
+    if (!inspectConnection(conn, listener, scratch)) {
+        return &scratch;
+    }
+
+    ConnectionState* state = new ConnectionState(scratch);
+    connections_[conn] = state;
+    evhttp_connection_set_closecb(conn, RpcServer::connectionClosedCallback, this);
+    logConnection(*state);
+    return state;
+}
+
+void RpcServer::logConnection(const ConnectionState& state) {
+    const char* framing = isBinaryListener(state.kind) ? " (binary)" : "";
+    if (state.protocol) {
+        std::cout << "Connection: " << state.clientIP << ":" << state.clientPort
+            << " using protocol: " << state.protocol << framing << ", cipher: " << state.cipher << endl;
+    } else {
+        const bool local = state.kind == LISTENER_UNIX || state.kind == LISTENER_BINARY_UNIX;
+        std::cout << "Connection: " << state.clientIP << ":" << state.clientPort
+            << " using local transport: " << (local ? "unix" : "plaintext") << framing << endl;
+    }
+}
+
+// 检查evhttp连接的传输层属性，返回false表示握手尚未完成、结果不可缓存
+bool RpcServer::inspectConnection(evhttp_connection* conn, const Listener* listener,
+                                  ConnectionState& state) const {
+    state.kind = listener->kind;
+
+    // 获取客户端地址信息
+    char* peerAddr = nullptr;
+    evhttp_connection_get_peer(conn, &peerAddr, &state.clientPort);
+    state.clientIP = peerAddr ? peerAddr : "unknown";
 
-    // 新增SSL连接检测
-    // 获取底层连接对象
-    evhttp_connection* conn = evhttp_request_get_connection(req);
-    
     // 通过连接获取 bufferevent
-    bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+    return inspectTransport(evhttp_connection_get_bufferevent(conn), state);
+}
+
+// 按监听类型检查bufferevent的传输层属性，state.kind须已设置
+bool RpcServer::inspectTransport(bufferevent* bev, ConnectionState& state) const {
+    if (state.kind == LISTENER_UNIX || state.kind == LISTENER_BINARY_UNIX) {
+        // Unix域套接字不经过TLS，以对端进程的uid鉴权
+        if (!bev || !isTrustedPeer(bufferevent_getfd(bev), state.peerIdentity)) {
+            state.rejectReason = "Untrusted local peer";
+        }
+        return true;
+    }
+    if (state.kind == LISTENER_PLAIN) {
+        // 明文监听只绑定在回环地址上，无需额外校验
+        return true;
+    }
 
     // 获取 SSL 对象
     SSL* ssl = nullptr;
     if (bev) {
         ssl = bufferevent_openssl_get_ssl(bev);
+        if (!ssl) {
+            TlsStream* stream = TlsStream::fromBufferevent(bev);
+            if (stream) {
+                ssl = stream->ssl();
+                state.earlyData = stream->inEarlyData();
+            }
+        }
     }
-
     if (!ssl) {
-        sendErrorResponse(req, -32000, "Not a secure connection", nullptr);
+        state.rejectReason = "Not a secure connection";
+        return true;
+    }
+
+    inspectTlsConnection(ssl, state);
+    return !state.earlyData;
+}
+
+// 连接关闭时释放其状态
+void RpcServer::connectionClosedCallback(evhttp_connection* conn, void* arg) {
+    RpcServer* server = static_cast<RpcServer*>(arg);
+    std::unordered_map<evhttp_connection*, ConnectionState*>::iterator it = server->connections_.find(conn);
+    if (it != server->connections_.end()) {
+        delete it->second;
+        server->connections_.erase(it);
+    }
+
+    // 流式响应未发完连接即断开：evhttp已把请求从连接上摘下而不释放，须由send_reply_end释放；
+    // 请求仍挂在连接上时随连接一并释放
+    std::unordered_map<evhttp_connection*, EvhttpStream*>::iterator stream = server->evhttpStreams_.find(conn);
+    if (stream != server->evhttpStreams_.end()) {
+        if (!evhttp_request_get_connection(stream->second->req)) {
+            evhttp_send_reply_end(stream->second->req);
+        }
+        delete stream->second;
+        server->evhttpStreams_.erase(stream);
+    }
+}
+
+// 响应写完后连接进入空闲，释放读写过程中扩充的缓冲区
+void RpcServer::requestCompleteCallback(evhttp_request* req, void* /*arg*/) {
+    evhttp_connection* conn = evhttp_request_get_connection(req);
+    bufferevent* bev = conn ? evhttp_connection_get_bufferevent(conn) : nullptr;
+    if (bev) {
+        NativeHttpConnection::releaseIdleBuffers(bev);
+    }
+}
+
+// 格式化对端地址，Unix域套接字等其他地址族记为unknown
+static void fillPeerAddress(const sockaddr* addr, ConnectionState& state) {
+    char ip[INET6_ADDRSTRLEN] = "unknown";
+    if (addr->sa_family == AF_INET) {
+        const sockaddr_in* in4 = reinterpret_cast<const sockaddr_in*>(addr);
+        inet_ntop(AF_INET, &in4->sin_addr, ip, sizeof(ip));
+        state.clientPort = ntohs(in4->sin_port);
+    } else if (addr->sa_family == AF_INET6) {
+        const sockaddr_in6* in6 = reinterpret_cast<const sockaddr_in6*>(addr);
+        inet_ntop(AF_INET6, &in6->sin6_addr, ip, sizeof(ip));
+        state.clientPort = ntohs(in6->sin6_port);
+    }
+    state.clientIP = ip;
+}
+
+// 关闭Nagle：TLS响应常分成多个段写出，后一段要等前一段的ACK，
+// 而客户端的延迟ACK要等到它发出下一个请求，响应因此被拖到下一个请求到达时（首个请求约40ms）
+static void disableNagle(evutil_socket_t fd, const sockaddr* addr) {
+    if (addr->sa_family == AF_INET || addr->sa_family == AF_INET6) {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+}
+
+void RpcServer::nativeAcceptCallback(evconnlistener* /*evListener*/, evutil_socket_t fd,
+                                     sockaddr* addr, int /*socklen*/, void* arg) {
+    Listener* listener = static_cast<Listener*>(arg);
+    RpcServer* server = listener->server;
+    disableNagle(fd, addr);
+
+    bufferevent* bev = listener->kind == LISTENER_TLS || listener->kind == LISTENER_BINARY
+        ? server->newTlsBufferevent(fd)
+        : bufferevent_socket_new(server->base_, fd, BEV_OPT_CLOSE_ON_FREE);
+    if (!bev) {
+        evutil_closesocket(fd);
         return;
     }
 
-    // 验证 SSL 连接状态
-    if (ssl && SSL_get_verify_result(ssl) != X509_V_OK) {
-        sendErrorResponse(req, -32000, "客户端证书验证失败", nullptr);
+    ConnectionState state;
+    state.kind = listener->kind;
+    fillPeerAddress(addr, state);
+
+    NativeHttpConnection::Inspector inspector = [server](bufferevent* connBev, ConnectionState& connState) {
+        if (!server->inspectTransport(connBev, connState)) {
+            return false;
+        }
+        logConnection(connState);
+        return true;
+    };
+    if (isBinaryListener(listener->kind)) {
+        NativeBinaryConnection* conn = new NativeBinaryConnection(bev, state, server->httpOptions_[listener->kind],
+            server->timers_, inspector, server->makeDispatcher(),
+            [server](NativeBinaryConnection* closed) {
+                server->binaryConnections_.erase(closed);
+                delete closed;
+                server->onConnectionClosed();
+            });
+        server->binaryConnections_.insert(conn);
+        conn->start();
+    } else {
+        NativeHttpConnection* conn = new NativeHttpConnection(bev, state, server->httpOptions_[listener->kind],
+            server->timers_, inspector, server->makeDispatcher(),
+            [server](NativeHttpConnection* closed) {
+                server->nativeConnections_.erase(closed);
+                delete closed;
+                server->onConnectionClosed();
+            });
+        server->nativeConnections_.insert(conn);
+        conn->start();
+    }
+    server->onConnectionOpened();
+}
+
+size_t RpcServer::connectionCount() const {
+    size_t count = nativeConnections_.size() + binaryConnections_.size();
+#ifdef RPC_HAVE_NGHTTP2
+    count += h2Sessions_.size() + h2Handshakes_;
+#endif
+    return count;
+}
+
+// 达到连接数上限后暂停accept，新连接留在内核的监听队列中等待
+void RpcServer::onConnectionOpened() {
+    if (options_.maxConnections > 0 && connectionCount() >= options_.maxConnections) {
+        setAcceptEnabled(false);
+    }
+}
+
+// 连接数回落到上限以下时恢复accept
+void RpcServer::onConnectionClosed() {
+    if (acceptPaused_ && connectionCount() < options_.maxConnections) {
+        setAcceptEnabled(true);
+    }
+}
+
+void RpcServer::timerTickCallback(evutil_socket_t /*fd*/, short /*events*/, void* arg) {
+    static_cast<RpcServer*>(arg)->timers_.advance();
+}
+
+void RpcServer::setAcceptEnabled(bool enabled) {
+    for (size_t i = 0; i < listeners_.size(); ++i) {
+        if (!listeners_[i]->native) {
+            continue;
+        }
+        if (enabled) {
+            evconnlistener_enable(listeners_[i]->native);
+        } else {
+            evconnlistener_disable(listeners_[i]->native);
+        }
+    }
+#ifdef RPC_HAVE_NGHTTP2
+    if (h2Listener_) {
+        if (enabled) {
+            evconnlistener_enable(h2Listener_);
+        } else {
+            evconnlistener_disable(h2Listener_);
+        }
+    }
+#endif
+    acceptPaused_ = !enabled;
+}
+
+// 释放监听器、事件循环与SSL上下文
+void RpcServer::freeResources() {
+    delete backend_;
+    backend_ = nullptr;
+    if (admin_) {
+        evhttp_free(admin_);
+        admin_ = nullptr;
+    }
+    if (timerTick_) {
+        event_free(timerTick_);
+        timerTick_ = nullptr;
+    }
+
+#ifdef RPC_HAVE_NGHTTP2
+    if (h2Listener_) {
+        evconnlistener_free(h2Listener_);
+        h2Listener_ = nullptr;
+    }
+    for (std::unordered_set<Http2Session*>::iterator it = h2Sessions_.begin();
+         it != h2Sessions_.end(); ++it) {
+        delete *it;
+    }
+    h2Sessions_.clear();
+#endif
+
+    for (std::unordered_set<NativeHttpConnection*>::iterator it = nativeConnections_.begin();
+         it != nativeConnections_.end(); ++it) {
+        delete *it;
+    }
+    nativeConnections_.clear();
+    for (std::unordered_set<NativeBinaryConnection*>::iterator it = binaryConnections_.begin();
+         it != binaryConnections_.end(); ++it) {
+        delete *it;
+    }
+    binaryConnections_.clear();
+
+    for (size_t i = 0; i < listeners_.size(); ++i) {
+        if (listeners_[i]->http) {
+            evhttp_free(listeners_[i]->http);
+        }
+        if (listeners_[i]->native) {
+            evconnlistener_free(listeners_[i]->native);
+        }
+        delete listeners_[i];
+    }
+    listeners_.clear();
+    http_ = nullptr;
+
+    // evhttp_free关闭连接时会回调connectionClosedCallback，这里只清理残留
+    for (std::unordered_map<evhttp_connection*, ConnectionState*>::iterator it = connections_.begin();
+         it != connections_.end(); ++it) {
+        delete it->second;
+    }
+    connections_.clear();
+    for (std::unordered_map<evhttp_connection*, EvhttpStream*>::iterator it = evhttpStreams_.begin();
+         it != evhttpStreams_.end(); ++it) {
+        delete it->second;
+    }
+    evhttpStreams_.clear();
+
+    for (size_t i = 0; i < unixSockets_.size(); ++i) {
+        unlink(unixSockets_[i].c_str());
+    }
+    if (base_) {
+        event_base_free(base_);
+        base_ = nullptr;
+    }
+    if (sslCtx_) {
+        SSL_CTX_free(sslCtx_);
+        sslCtx_ = nullptr;
+    }
+}
+
+// SSL连接回调
+bufferevent* RpcServer::bevCallback(event_base* /*base*/, void* arg) {
+    return static_cast<RpcServer*>(arg)->newTlsBufferevent(-1);
+}
+
+// 创建服务端TLS bufferevent，fd为-1时由evhttp稍后设置
+bufferevent* RpcServer::newTlsBufferevent(evutil_socket_t fd) {
+    SSL* ssl = SSL_new(sslCtx_);
+
+    // bufferevent_openssl以SSL_do_handshake驱动握手，会拒绝所有早期数据，
+    // 启用0-RTT时改用可调用SSL_read_early_data的TlsStream过滤层
+    if (options_.earlyData) {
+        bufferevent* bev = TlsStream::newBufferevent(base_, ssl);
+        if (bev && fd >= 0) {
+            bufferevent_setfd(bev, fd);
+        }
+        return bev;
+    }
+    return bufferevent_openssl_socket_new(base_, fd, ssl,
+                                        BUFFEREVENT_SSL_ACCEPTING,
+                                        BEV_OPT_CLOSE_ON_FREE);
+}
+
+// 早期数据准入回调：票据须在防重放窗口内且首次使用
+int RpcServer::allowEarlyDataCallback(SSL* ssl, void* arg) {
+    auto* server = static_cast<RpcServer*>(arg);
+    return server->replayWindow_.accept(SSL_get_session(ssl)) ? 1 : 0;
+}
+
+#ifdef RPC_HAVE_NGHTTP2
+// 标记由HTTP/2监听器创建的SSL对象，ALPN回调据此选择协议
+static int g_http2ExIndex = -1;
+
+// HTTP/2连接完成TLS握手前的上下文
+struct PendingHttp2 {
+    RpcServer* server;
+    ConnectionState state;
+};
+
+bool RpcServer::bindHttp2(int port) {
+    if (g_http2ExIndex < 0) {
+        g_http2ExIndex = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    }
+    SSL_CTX_set_alpn_select_cb(sslCtx_, RpcServer::alpnSelectCallback, this);
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    h2Listener_ = evconnlistener_new_bind(base_, RpcServer::http2AcceptCallback, this,
+        LEV_OPT_CLOSE_ON_FREE | LEV_OPT_REUSEABLE, -1,
+        reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    return h2Listener_ != nullptr;
+}
+
+// ALPN：HTTP/2端口只接受h2，HTTPS端口明确选择http/1.1
+int RpcServer::alpnSelectCallback(SSL* ssl, const unsigned char** out, unsigned char* outlen,
+                                  const unsigned char* in, unsigned int inlen, void* /*arg*/) {
+    static const unsigned char kH2[] = "\x02h2";
+    static const unsigned char kHttp11[] = "\x08http/1.1";
+    const bool http2 = SSL_get_ex_data(ssl, g_http2ExIndex) != nullptr;
+    const unsigned char* protos = http2 ? kH2 : kHttp11;
+    const unsigned int protosLen = http2 ? sizeof(kH2) - 1 : sizeof(kHttp11) - 1;
+
+    unsigned char* selected = nullptr;
+    if (SSL_select_next_proto(&selected, outlen, protos, protosLen, in, inlen) != OPENSSL_NPN_NEGOTIATED) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+
+void RpcServer::http2AcceptCallback(evconnlistener* /*listener*/, evutil_socket_t fd,
+                                    sockaddr* addr, int /*socklen*/, void* arg) {
+    RpcServer* server = static_cast<RpcServer*>(arg);
+    disableNagle(fd, addr);
+    SSL* ssl = SSL_new(server->sslCtx_);
+    SSL_set_ex_data(ssl, g_http2ExIndex, server);
+
+    bufferevent* bev = bufferevent_openssl_socket_new(server->base_, fd, ssl,
+        BUFFEREVENT_SSL_ACCEPTING, BEV_OPT_CLOSE_ON_FREE);
+    if (!bev) {
+        SSL_free(ssl);
+        evutil_closesocket(fd);
         return;
     }
 
-   
-    // 获取客户端地址信息
-    std::string clientIP;
-    ev_uint16_t clientPort = 0;
-   
-    if (conn) { 
-        char *peer_addr = nullptr;       
-        evhttp_connection_get_peer(conn, &peer_addr, &clientPort);
-        clientIP = peer_addr ? peer_addr : "unknown";
-    }  
-
-    std::cout << "Connection: " << clientIP << ":" << clientPort << " using protocol: " << SSL_get_version(ssl) 
-        << ", cipher: " << SSL_get_cipher(ssl) << endl;   
+    PendingHttp2* pending = new PendingHttp2;
+    pending->server = server;
+    pending->state.kind = LISTENER_HTTP2;
+    fillPeerAddress(addr, pending->state);
 
+    // 超时未完成握手的连接直接关闭；握手完成后由Http2Session在时间轮上按阶段计时
+    if (server->options_.timeouts.handshakeSec > 0) {
+        timeval timeout = {server->options_.timeouts.handshakeSec, 0};
+        bufferevent_set_timeouts(bev, &timeout, nullptr);
+    }
+    bufferevent_setcb(bev, nullptr, nullptr, RpcServer::http2HandshakeCallback, pending);
+    bufferevent_enable(bev, EV_READ);
+    ++server->h2Handshakes_;
+    server->onConnectionOpened();
+}
+
+// 握手完成后确认ALPN结果为h2，再把连接交给Http2Session
+void RpcServer::http2HandshakeCallback(bufferevent* bev, short events, void* arg) {
+    PendingHttp2* pending = static_cast<PendingHttp2*>(arg);
+    RpcServer* server = pending->server;
+    ConnectionState state = pending->state;
+    delete pending;
+    --server->h2Handshakes_;
+
+    SSL* ssl = bufferevent_openssl_get_ssl(bev);
+    const unsigned char* alpn = nullptr;
+    unsigned int alpnLen = 0;
+    if (events & BEV_EVENT_CONNECTED) {
+        SSL_get0_alpn_selected(ssl, &alpn, &alpnLen);
+    }
+    if (alpnLen != 2 || memcmp(alpn, "h2", 2) != 0) {
+        bufferevent_free(bev);
+        server->onConnectionClosed();
+        return;
+    }
+    bufferevent_set_timeouts(bev, nullptr, nullptr);
+
+    inspectTlsConnection(ssl, state);
+    std::cout << "Connection: " << state.clientIP << ":" << state.clientPort
+        << " using protocol: " << state.protocol << " (h2), cipher: " << state.cipher << endl;
+
+    Http2Session* session = new Http2Session(bev, state, server->makeDispatcher(), server->httpOptions_[LISTENER_HTTP2],
+        server->timers_, [server](Http2Session* closed) {
+            server->h2Sessions_.erase(closed);
+            delete closed;
+            server->onConnectionClosed();
+        });
+    server->h2Sessions_.insert(session);
+    if (!session->start()) {
+        server->h2Sessions_.erase(session);
+        delete session;
+        server->onConnectionClosed();
+    }
+}
+#endif // RPC_HAVE_NGHTTP2
+
+void RpcServer::requestHandler(evhttp_request* req, void* arg) {
+    const Listener* listener = static_cast<const Listener*>(arg);
+    const uint64_t receivedCycles = cycleNow();
+
+    // ========== 连接校验阶段 ==========
+    // 传输层校验结果按连接缓存，keep-alive连接上的后续请求无需重复检查
+    evhttp_connection* conn = evhttp_request_get_connection(req);
+    ConnectionState scratch;
+    ConnectionState* connState = getConnectionState(conn, listener, scratch);
+    if (connState->rejectReason) {
+        sendJsonResponse(req, errorBody(-32000, connState->rejectReason, nullptr));
+        return;
+    }
+    connState->requests++;
+
+    // 达到单连接请求数上限，evhttp发送本响应后关闭连接
+    if (options_.keepAliveRequests > 0 && connState->requests >= options_.keepAliveRequests) {
+        evhttp_add_header(evhttp_request_get_output_headers(req), "Connection", "close");
+    }
+
+    // 响应发送完毕后归还连接缓冲区
+    if (options_.leanIdle) {
+        evhttp_request_set_on_complete_cb(req, RpcServer::requestCompleteCallback, nullptr);
+    }
+
+    // ========== 请求数据读取阶段 ==========
+    // 直接在evhttp的输入缓冲区上解析，不复制请求体
+    evbuffer* input = evhttp_request_get_input_buffer(req);
+    const size_t len = evbuffer_get_length(input);
+    const char* requestData = reinterpret_cast<const char*>(evbuffer_pullup(input, -1));
+
+    RpcCall call(StringRef(requestData, len));
+    const char* uri = evhttp_request_get_uri(req);
+    call.target = StringRef(uri, strlen(uri));
+    call.receivedCycles = receivedCycles;
+    call.trace = options_.debugTrace &&
+        evhttp_find_header(evhttp_request_get_input_headers(req), "X-Rpc-Trace") != nullptr;
+
+    // evhttp没有请求头阶段的回调，路由只能在请求体读完后解析：
+    // 监听器级上限已由evhttp在读取请求体前检查，这里补上404与更严的方法级上限
+    const RequestRoute route = resolveRoute(call.target, options_.limits[listener->kind].maxBodySize);
+    if (!route.found) {
+        evbuffer* output = evhttp_request_get_output_buffer(req);
+        evhttp_add_header(evhttp_request_get_output_headers(req), "Content-Type", kJsonContentType);
+        evbuffer_add(output, kMethodNotFoundBody.data, kMethodNotFoundBody.size);
+        evhttp_send_reply(req, 404, "Not Found", output);
+        return;
+    }
+    if (len > route.bodyLimit) {
+        evbuffer* output = evhttp_request_get_output_buffer(req);
+        const std::string body = payloadTooLargeBody(len, route.bodyLimit);
+        evhttp_add_header(evhttp_request_get_output_headers(req), "Content-Type", kJsonContentType);
+        evhttp_add_header(evhttp_request_get_output_headers(req), "Connection", "close");
+        evbuffer_add(output, body.data(), body.size());
+        evhttp_send_reply(req, 413, "Payload Too Large", output);
+        return;
+    }
+
+    const char* contentEncoding = evhttp_find_header(evhttp_request_get_input_headers(req), "Content-Encoding");
+    if (contentEncoding &&
+        !parseContentCoding(StringRef(contentEncoding, strlen(contentEncoding)), call.encoding)) {
+        evhttp_send_error(req, 415, "Unsupported Media Type");
+        return;
+    }
+    call.streamable = true;
+    std::string response = dispatchRequest(call, *connState);
+    if (!call.timing.empty()) {
+        evhttp_add_header(evhttp_request_get_output_headers(req), "Server-Timing", call.timing.c_str());
+    }
+    if (call.stream) {
+        startEvhttpStream(req, listener, std::move(call.stream));
+        return;
+    }
+
+    // ========== 响应压缩阶段 ==========
+    ContentCoding coding = CODING_IDENTITY;
+    const char* acceptEncoding = options_.compression.enabled ?
+        evhttp_find_header(evhttp_request_get_input_headers(req), "Accept-Encoding") : nullptr;
+    if (acceptEncoding) {
+        coding = compressResponse(options_.compression,
+            negotiateContentCoding(StringRef(acceptEncoding, strlen(acceptEncoding))),
+            call.compressible, response);
+    }
+    sendJsonResponse(req, response, coding);
+}
+
+void RpcServer::startEvhttpStream(evhttp_request* req, const Listener* listener,
+                                  std::unique_ptr<ResponseStream> body) {
+    evhttp_connection* conn = evhttp_request_get_connection(req);
+    EvhttpStream* stream = new EvhttpStream;
+    stream->req = req;
+    stream->conn = conn;
+    stream->body = std::move(body);
+    stream->highWater = httpOptions_[listener->kind].maxPendingOutput;
+    stream->failed = false;
+    stream->pumping = false;
+    evhttpStreams_[conn] = stream;
+    evhttp_connection_set_closecb(conn, RpcServer::connectionClosedCallback, this);
+
+    // evhttp写响应期间只为检测对端关闭而保持EV_READ，流水线发来的后续请求会一直堆在输入缓冲中；
+    // 流式响应可能持续很久，以读高水位限制预读量，响应结束时恢复
+    bufferevent_setwatermark(evhttp_connection_get_bufferevent(conn), EV_READ, 0, stream->highWater);
+
+    evhttp_add_header(evhttp_request_get_output_headers(req), "Content-Type", kJsonContentType);
+    evhttp_add_header(evhttp_request_get_output_headers(req), "Strict-Transport-Security", kHstsHeaderValue);
+    evhttp_send_reply_start(req, HTTP_OK, "OK");
+    pumpEvhttpStream(stream);
+}
+
+// 在输出积压低于上限时拉取并发送响应体；每块都登记发空回调，积压达到上限时由回调继续。
+// 积压连同TLS过滤层底层bufferevent中的密文一起计算。TlsStream在写入输出时即同步触发写回调，
+// 回调若在写入分块的中途重入，嵌套写出的分块会插在当前分块的长度行与数据之间
+void RpcServer::pumpEvhttpStream(EvhttpStream* stream) {
+    bufferevent* bev = evhttp_connection_get_bufferevent(stream->conn);
+    evbuffer* chunk = evhttp_request_get_output_buffer(stream->req);
+    bool more = true;
+    stream->pumping = true;
+    while (more && NativeHttpConnection::pendingOutput(bev) < stream->highWater) {
+        stream->chunk.clear();
+        try {
+            more = stream->body->next(stream->chunk);
+        } catch (...) {
+            // 已发出的部分无法撤回：不发结束块，关闭套接字使evhttp按连接失败清理
+            stream->failed = true;
+            stream->pumping = false;
+            shutdown(bufferevent_getfd(bev), SHUT_RDWR);
+            return;
+        }
+        if (!stream->chunk.empty()) {
+            evbuffer_add(chunk, stream->chunk.data(), stream->chunk.size());
+            evhttp_send_reply_chunk_with_cb(stream->req, chunk, RpcServer::evhttpStreamDrainedCallback, this);
+        }
+    }
+    stream->pumping = false;
+    if (more) {
+        return;
+    }
+    // 结束块同样会同步触发发空回调，先注销流，回调找不到它即不再拉取
+    evhttp_request* req = stream->req;
+    evhttpStreams_.erase(stream->conn);
+    delete stream;
+    bufferevent_setwatermark(bev, EV_READ, 0, 0);
+    evhttp_send_reply_end(req);
+}
+
+void RpcServer::evhttpStreamDrainedCallback(evhttp_connection* conn, void* arg) {
+    RpcServer* server = static_cast<RpcServer*>(arg);
+    std::unordered_map<evhttp_connection*, EvhttpStream*>::iterator it = server->evhttpStreams_.find(conn);
+    if (it != server->evhttpStreams_.end() && !it->second->failed && !it->second->pumping) {
+        server->pumpEvhttpStream(it->second);
+    }
+}
+
+// 供HTTP/2与io_uring等不经evhttp的传输使用：先按连接状态拒绝，再执行调用
+RpcDispatcher RpcServer::makeDispatcher() {
+    return [this](RpcCall& call, ConnectionState& state) {
+        if (state.rejectReason) {
+            call.response = errorBody(-32000, state.rejectReason, nullptr);
+            return;
+        }
+        state.requests++;
+        call.response = dispatchRequest(call, state);
+    };
+}
+
+// 审计日志与指标记录的处理耗时，微秒
+static uint64_t monotonicUs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000 + static_cast<uint64_t>(now.tv_nsec) / 1000;
+}
+
+// 分发结束时（包括各个提前返回的错误）记录一次调用的方法、监听器、响应码、耗时与各阶段耗时；
+// 响应体在析构之前已生成，计入respond阶段。追踪的请求另把各阶段耗时写入call.timing
+struct CallMetricsScope {
+    CallMetricsScope(RpcMetrics* metrics, RpcCall& call, ListenerKind listener, uint64_t startUs, bool trace)
+        : metrics(metrics), call(call), listener(listener), startUs(startUs), method(RpcMetrics::kUnknownMethod),
+          code(0), trace(trace), phases(metrics || trace) {
+        if (phases.enabled && call.receivedCycles != 0 && call.receivedCycles < phases.last) {
+            phases.cycles[PHASE_READ] = phases.last - call.receivedCycles;
+        }
+    }
+    ~CallMetricsScope() {
+        phases.mark(PHASE_RESPOND);
+        if (metrics) {
+            metrics->record(method, listener, code,
+                            static_cast<uint32_t>(std::min<uint64_t>(monotonicUs() - startUs, UINT32_MAX)), phases);
+        }
+        if (trace) {
+            call.timing = serverTiming(phases);
+        }
+    }
+
+    RpcMetrics* metrics;  // 未启用管理端口时为nullptr
+    RpcCall& call;
+    ListenerKind listener;
+    uint64_t startUs;
+    unsigned method;
+    int code;
+    bool trace;
+    PhaseClock phases;    // 既不导出指标也不追踪时不读时钟
+};
+
+// 服务名首字母大写规范，路径与请求体中的服务名都按此处理
+static std::string capitalize(std::string name) {
+    if (!name.empty()) {
+        name[0] = toupper(name[0]);
+    }
+    return name;
+}
+
+// 在读取请求体之前按路径/rpc/<Service>/<method>解析路由
+// 路径未指明方法时沿用监听器的上限，由请求体中的method决定路由；指明了不存在的方法时found为false。
+// 结果按已注册的方法缓存，未注册的服务或方法不入缓存，避免被任意路径撑大
+RequestRoute RpcServer::resolveRoute(StringRef target, size_t listenerLimit) {
+    RequestRoute route;
+    route.bodyLimit = listenerLimit;
+    StringRef serviceRef, methodRef;
+    if (!parseMethodPath(target, serviceRef, methodRef)) {
+        return route;
+    }
+    const std::string serviceName = capitalize(serviceRef.str());
+    const std::string methodName = methodRef.str();
+    const std::string key = serviceName + "/" + methodName;
+
+    std::unordered_map<std::string, size_t>::const_iterator cached = methodBodyLimits_.find(key);
+    if (cached != methodBodyLimits_.end()) {
+        if (cached->second) {
+            route.bodyLimit = cached->second;
+        }
+        return route;
+    }
     try {
-        // ========== 请求数据读取阶段 ==========
-        // 从evhttp请求中获取输入缓冲区并读取原始数据
-        evbuffer* input = evhttp_request_get_input_buffer(req);
-        const size_t len = evbuffer_get_length(input);
-        std::string requestData(len, 0);
-        evbuffer_remove(input, &requestData[0], len);
+        auto service = IocContainer::getInstance().getService(serviceName);
+        if (!service || !service->hasMethod(methodName)) {
+            route.found = false;
+            return route;
+        }
+        const size_t limit = service->maxBodySize(methodName);
+        methodBodyLimits_[key] = limit;
+        if (limit) {
+            route.bodyLimit = limit;
+        }
+    } catch (const std::exception&) {
+        route.found = false; // 服务未注册
+    }
+    return route;
+}
+
+// 执行一次JSON-RPC调用并返回响应体，与传输协议无关，HTTP/1.x与HTTP/2共用
+// 定位到方法后把其响应属性记入call
+std::string RpcServer::dispatchRequest(RpcCall& call, const ConnectionState& connState) {
+    const uint64_t startUs = monotonicUs();
+    const StringRef requestData = call.body;
+    nlohmann::json requestJson;
+    nlohmann::json id = nullptr;
+    CallMetricsScope outcome(options_.adminPort > 0 ? &metrics_ : nullptr, call, connState.kind, startUs,
+                             options_.debugTrace && call.trace);
+    auto fail = [&outcome](int code, const std::string& message, const nlohmann::json& requestId) {
+        outcome.code = code;
+        return errorBody(code, message, requestId);
+    };
 
+    try {
         // ========== JSON解析与验证阶段 ==========
         // 解析JSON请求并验证基础结构
-        requestJson = nlohmann::json::parse(requestData);
+        if (call.encoding == CODING_IDENTITY) {
+            requestJson = nlohmann::json::parse(requestData.data, requestData.data + requestData.size);
+        } else {
+            // 边解压边解析，只占用一个解压窗口
+            RequestDecompressor body(call.encoding, requestData, options_.maxDecompressedSize);
+            requestJson = nlohmann::json::parse(body.begin(), body.end());
+        }
 
         // 校验JSON-RPC协议版本
         if (!requestJson.contains("jsonrpc") || requestJson["jsonrpc"] != "2.0") {
-            sendErrorResponse(req, -32600, "Invalid JSON-RPC version", nullptr);
-            return;
+            return fail(-32600, "Invalid JSON-RPC version", nullptr);
         }
+        outcome.phases.mark(PHASE_PARSE);
 
-        // 验证必须包含method字段
-        if (!requestJson.contains("method")) {
-            sendErrorResponse(req, -32600, "Missing method", nullptr);
-            return;
+        // 路径指明方法时以路径为准，请求体中的method可省略；否则必须包含method字段
+        StringRef pathService, pathMethod;
+        const bool routedByPath = parseMethodPath(call.target, pathService, pathMethod);
+        if (!routedByPath && !requestJson.contains("method")) {
+            return fail(-32600, "Missing method", nullptr);
         }
 
         // ========== 参数提取阶段 ==========
+        // id可为数字或字符串，原样带回；同一连接上连续发出的调用（如WebSocket）靠它对应响应
+        if (requestJson.contains("id")) {
+            id = requestJson["id"];
+        }
         // 解构请求参数并校验格式
-        const std::string method = requestJson["method"];
         if (!requestJson.contains("params")) {
-            sendErrorResponse(req, -32600, "Missing params", id);
-            return;
+            return fail(-32600, "Missing params", id);
         }
         const nlohmann::json params = requestJson["params"];
-        id = requestJson.value("id", nullptr);
+        outcome.phases.mark(PHASE_PARAMS);
 
         // ========== 方法名解析阶段 ==========
-        // 分割service.method格式的方法名
-        const size_t dotPos = method.find('.');
-        if (dotPos == std::string::npos || dotPos == 0 || dotPos == method.length()-1) {
-            sendErrorResponse(req, -32601, "Invalid method format", id);
-            return;
+        std::string serviceName;
+        std::string methodName;
+        if (routedByPath) {
+            serviceName = pathService.str();
+            methodName = pathMethod.str();
+        }
+        std::string method;
+        if (requestJson.contains("method")) {
+            // 分割service.method格式的方法名
+            method = requestJson["method"].get<std::string>();
+            const size_t dotPos = method.find('.');
+            if (dotPos == std::string::npos || dotPos == 0 || dotPos == method.length()-1) {
+                return fail(-32601, "Invalid method format", id);
+            }
+            const std::string bodyService = capitalize(method.substr(0, dotPos));
+            const std::string bodyMethod = method.substr(dotPos+1);
+            if (!routedByPath) {
+                serviceName = bodyService;
+                methodName = bodyMethod;
+            } else if (bodyService != capitalize(serviceName) || bodyMethod != methodName) {
+                // 两处都给出方法时必须一致，请求体上限与早期404都是按路径决定的
+                return fail(-32600, "Method does not match request path", id);
+            }
         }
 
-        // 分割并规范化服务名称
-        std::string serviceName = method.substr(0, dotPos);
-        std::string methodName = method.substr(dotPos+1);
-        if (!serviceName.empty()) {
-            serviceName[0] = toupper(serviceName[0]); // 统一服务名首字母大写规范
+        // 规范化服务名称
+        serviceName = capitalize(serviceName); // 统一服务名首字母大写规范
+        if (method.empty()) {
+            method = serviceName + "." + methodName; // 供审计日志使用
+        }
+        if (outcome.metrics) {
+            outcome.method = metrics_.methodIndex(serviceName, methodName);
         }
+        outcome.phases.mark(PHASE_METHOD);
 
         // ========== 服务定位阶段 ==========
         // 从IoC容器获取服务实例
         auto service = IocContainer::getInstance().getService(serviceName);
         if (!service) {
-            sendErrorResponse(req, -32601, "Service not found: " + serviceName, id);
-            return;
+            return fail(-32601, "Service not found: " + serviceName, id);
+        }
+
+        // 早期数据可能被攻击者重放，只允许调用幂等方法
+        if (connState.earlyData && !service->isReplaySafe(methodName)) {
+            return fail(-32000, "Method is not replay-safe, retry after handshake", id);
         }
+        call.compressible = service->isCompressible(methodName);
+        outcome.phases.mark(PHASE_LOOKUP);
 
         // ========== 方法执行阶段 ==========
         // 反射调用服务方法并处理结果
+        std::string response;
+        bool failed = false;
         try {
-            const nlohmann::json result = service->executeMethod(methodName, params);
-            sendSuccessResponse(req, result, id);
+            if (service->isStreamMethod(methodName)) {
+                // 参数错误在打开结果流时抛出，此时尚未发出任何内容，仍按普通错误响应
+                std::unique_ptr<ResultStream> results = service->openStream(methodName, params);
+                std::unique_ptr<ResponseStream> body(
+                    new JsonResponseStream(std::move(service), std::move(results), method, id));
+                if (call.streamable) {
+                    call.stream = std::move(body);
+                } else if (!collectResponse(*body, httpOptions_[connState.kind].maxPendingOutput, response)) {
+                    response = fail(-32000, "Result exceeds " +
+                                    std::to_string(httpOptions_[connState.kind].maxPendingOutput) +
+                                    " bytes, call over HTTP/1.1 to stream it", id);
+                    failed = true;
+                }
+                outcome.phases.mark(PHASE_EXECUTE);
+            } else {
+                const nlohmann::json result = service->executeMethod(methodName, params);
+                outcome.phases.mark(PHASE_EXECUTE);
+                response = successBody(result, id);
+            }
         } catch (const std::exception& e) {
-            sendErrorResponse(req, -32602, e.what(), id);
+            outcome.phases.mark(PHASE_EXECUTE);
+            response = fail(-32602, e.what(), id);
+            failed = true;
         }
 
-        // 调用新的日志函数
-        std::map<std::string, std::string> auditData = {
-            {"client", clientIP},
-            {"port", std::to_string(clientPort)},
-            {"method", method}
-        };
-        logAudit(auditData);
+        // 审计日志只把定长记录放入缓冲，格式化与写文件在后台线程完成；流式响应的耗时只计到结果流打开为止。
+        // 先按采样率与客户端速率决定是否记录，略去的调用不读时钟、不拷贝记录
+        if (audit_.admit(connState.clientIP, failed)) {
+            const uint64_t elapsedUs = monotonicUs() - startUs;
+            audit_.log(connState.clientIP, connState.clientPort, method,
+                       static_cast<uint32_t>(std::min<uint64_t>(elapsedUs, UINT32_MAX)), failed);
+        }
+        return response;
 
     } // ========== 异常处理阶段 ==========
     catch (const nlohmann::json::parse_error& e) {
-        sendErrorResponse(req, -32700, "Parse error: " + std::string(e.what()), id);
+        outcome.phases.mark(PHASE_PARSE);
+        return fail(-32700, "Parse error: " + std::string(e.what()), id);
     } catch (const nlohmann::json::exception& e) {
-        sendErrorResponse(req, -32600, "Invalid request: " + std::string(e.what()), id);
+        return fail(-32600, "Invalid request: " + std::string(e.what()), id);
+    } catch (const DecompressionError& e) {
+        outcome.phases.mark(PHASE_PARSE);
+        return fail(e.sizeExceeded() ? -32600 : -32700,
+                    (e.sizeExceeded() ? "Request too large: " : "Parse error: ") + std::string(e.what()), id);
     } catch (const std::exception& e) {
-        sendErrorResponse(req, -32603, "Internal error: " + std::string(e.what()), id);
+        return fail(-32603, "Internal error: " + std::string(e.what()), id);
     } catch (...) {
-        sendErrorResponse(req, -32603, "Unknown internal error", id);
+        return fail(-32603, "Unknown internal error", id);
     }
 }
 
 // 启动服务
 void RpcServer::start() {
-    // 注册通用请求处理器
-    evhttp_set_gencb(http_, [](evhttp_request* req, void* arg) {
-        static_cast<RpcServer*>(arg)->requestHandler(req, arg);
-    }, this);
+    // 注册通用请求处理器，各监听器共用同一套分发逻辑
+    for (size_t i = 0; i < listeners_.size(); ++i) {
+        if (!listeners_[i]->http) {
+            continue; // 原生引擎在接受连接时已挂好处理流程
+        }
+        evhttp_set_gencb(listeners_[i]->http, [](evhttp_request* req, void* arg) {
+            static_cast<Listener*>(arg)->server->requestHandler(req, arg);
+        }, listeners_[i]);
+    }
     
     // 进入事件循环
-    event_base_dispatch(base_);
+    backend_->run();
 
     // 清理资源
-    evhttp_free(http_);
-    event_base_free(base_);
-    SSL_CTX_free(sslCtx_);
+    freeResources();
 }
\ No newline at end of file
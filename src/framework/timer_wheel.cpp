@@ -0,0 +1,119 @@
+// src/framework/timer_wheel.cpp
+#include "framework/timer_wheel.h"
+#include <time.h>
+
+WheelTimer::WheelTimer(Callback callback, void* arg)
+    : expires_(0), callback_(callback), arg_(arg) {
+    prev = nullptr;
+    next = nullptr;
+}
+
+void WheelTimer::cancel() {
+    if (prev) {
+        prev->next = next;
+        next->prev = prev;
+        prev = nullptr;
+        next = nullptr;
+    }
+}
+
+TimerWheel::TimerWheel(unsigned tickMs)
+    : current_(0), originMs_(monotonicMs()), tickMs_(tickMs > 0 ? tickMs : 1) {
+    for (unsigned level = 0; level < kLevels; ++level) {
+        for (unsigned slot = 0; slot < kSlots; ++slot) {
+            slots_[level][slot].prev = &slots_[level][slot];
+            slots_[level][slot].next = &slots_[level][slot];
+        }
+    }
+}
+
+uint64_t TimerWheel::monotonicMs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + static_cast<uint64_t>(ts.tv_nsec) / 1000000;
+}
+
+uint64_t TimerWheel::nowTick() const {
+    return (monotonicMs() - originMs_) / tickMs_;
+}
+
+void TimerWheel::link(TimerLink* head, TimerLink* node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+void TimerWheel::schedule(WheelTimer* timer, uint64_t delayMs) {
+    timer->cancel();
+    // 当前tick已过去的部分不计入，多等一个tick保证不提前触发
+    timer->expires_ = nowTick() + 1 + (delayMs + tickMs_ - 1) / tickMs_;
+    place(timer);
+}
+
+// 按距current_的tick数选择级别：第n级的槽以到期tick的第n组6位为下标
+void TimerWheel::place(WheelTimer* timer) {
+    if (timer->expires_ < current_) {
+        timer->expires_ = current_;
+    }
+    const uint64_t maxDelta = (static_cast<uint64_t>(1) << (kLevels * kSlotBits)) - 1;
+    if (timer->expires_ - current_ > maxDelta) {
+        timer->expires_ = current_ + maxDelta;
+    }
+    const uint64_t delta = timer->expires_ - current_;
+    unsigned level = 0;
+    while (level + 1 < kLevels && delta >= (static_cast<uint64_t>(1) << ((level + 1) * kSlotBits))) {
+        ++level;
+    }
+    const unsigned slot = static_cast<unsigned>(timer->expires_ >> (level * kSlotBits)) & (kSlots - 1);
+    link(&slots_[level][slot], timer);
+}
+
+// 把第level级当前槽中的定时器按剩余时间重新分配到更低的级别，返回该槽的下标
+unsigned TimerWheel::cascade(unsigned level) {
+    const unsigned slot = static_cast<unsigned>(current_ >> (level * kSlotBits)) & (kSlots - 1);
+    TimerLink* head = &slots_[level][slot];
+    TimerLink moving = { head->prev, head->next };
+    if (moving.next == head) {
+        return slot;
+    }
+    moving.next->prev = &moving;
+    moving.prev->next = &moving;
+    head->prev = head;
+    head->next = head;
+    while (moving.next != &moving) {
+        WheelTimer* timer = static_cast<WheelTimer*>(moving.next);
+        timer->cancel();
+        place(timer);
+    }
+    return slot;
+}
+
+void TimerWheel::advance() {
+    const uint64_t target = nowTick();
+    while (current_ <= target) {
+        const unsigned index = static_cast<unsigned>(current_) & (kSlots - 1);
+        // 第0级转完一圈：依次从上一级取下一段时间内到期的定时器，上一级也转完一圈时继续向上
+        if (index == 0) {
+            for (unsigned level = 1; level < kLevels && cascade(level) == 0; ++level) {
+            }
+        }
+        ++current_;
+
+        // 先整体移到临时链表再逐个触发：回调可能把定时器重新挂回同一个槽
+        TimerLink* head = &slots_[0][index];
+        if (head->next == head) {
+            continue;
+        }
+        TimerLink expired = { head->prev, head->next };
+        expired.next->prev = &expired;
+        expired.prev->next = &expired;
+        head->prev = head;
+        head->next = head;
+        while (expired.next != &expired) {
+            WheelTimer* timer = static_cast<WheelTimer*>(expired.next);
+            timer->cancel();
+            timer->callback_(timer->arg_);
+        }
+    }
+}
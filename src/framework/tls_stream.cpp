@@ -0,0 +1,225 @@
+// src/framework/tls_stream.cpp
+#include "framework/tls_stream.h"
+#include <algorithm>
+#include <unordered_map>
+
+// 过滤层bufferevent到TlsStream的映射，事件循环单线程访问
+static std::unordered_map<bufferevent*, TlsStream*> g_streams;
+
+// 底层bufferevent中最多缓存的密文，超出后过滤层停止加密，直到底层发空
+static const size_t kCiphertextHighWater = 64 * 1024;
+
+TlsStream::TlsStream(SSL* ssl)
+    : ssl_(ssl), rbio_(BIO_new(BIO_s_mem())), wbio_(BIO_new(BIO_s_mem())),
+      earlyPhase_(true), earlyRead_(false), bev_(nullptr), flushEvent_(nullptr) {
+    // 读BIO为空时返回“重试”而不是EOF
+    BIO_set_mem_eof_return(rbio_, -1);
+    SSL_set_bio(ssl_, rbio_, wbio_);
+    SSL_set_accept_state(ssl_);
+}
+
+TlsStream::~TlsStream() {
+    // 启用早期数据时OpenSSL使用有状态票据，未标记关闭的连接会把会话移出缓存，
+    // 导致客户端无法恢复会话，也就无法再发送早期数据
+    SSL_set_shutdown(ssl_, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+    if (flushEvent_) {
+        event_free(flushEvent_);
+    }
+    SSL_free(ssl_); // 同时释放rbio_和wbio_
+}
+
+bool TlsStream::decrypt(evbuffer* ciphertextIn, evbuffer* plaintext, evbuffer* ciphertextOut) {
+    // 把收到的密文全部搬入读BIO
+    evbuffer_iovec vec;
+    while (evbuffer_peek(ciphertextIn, -1, nullptr, &vec, 1) > 0 && vec.iov_len > 0) {
+        BIO_write(rbio_, vec.iov_base, static_cast<int>(vec.iov_len));
+        evbuffer_drain(ciphertextIn, vec.iov_len);
+    }
+
+    char buf[16384];
+
+    // ========== 0-RTT阶段 ==========
+    // 未发送早期数据的客户端会直接得到FINISH，随后走普通握手流程
+    while (earlyPhase_) {
+        size_t n = 0;
+        int ret = SSL_read_early_data(ssl_, buf, sizeof(buf), &n);
+        if (ret == SSL_READ_EARLY_DATA_ERROR) {
+            if (SSL_get_error(ssl_, 0) == SSL_ERROR_WANT_READ) {
+                flushCiphertext(ciphertextOut);
+                return true;
+            }
+            return false;
+        }
+        if (n > 0) {
+            evbuffer_add(plaintext, buf, n);
+            earlyRead_ = true;
+        }
+        if (ret == SSL_READ_EARLY_DATA_FINISH) {
+            earlyPhase_ = false;
+        }
+    }
+
+    // ========== 握手阶段 ==========
+    if (!SSL_is_init_finished(ssl_)) {
+        int ret = SSL_do_handshake(ssl_);
+        if (ret <= 0) {
+            int err = SSL_get_error(ssl_, ret);
+            flushCiphertext(ciphertextOut);
+            return err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE;
+        }
+    }
+
+    // ========== 应用数据阶段 ==========
+    for (;;) {
+        size_t n = 0;
+        if (SSL_read_ex(ssl_, buf, sizeof(buf), &n) > 0) {
+            evbuffer_add(plaintext, buf, n);
+            continue;
+        }
+        int err = SSL_get_error(ssl_, 0);
+        flushCiphertext(ciphertextOut);
+        // 对端发送close_notify同样视为连接结束
+        return err == SSL_ERROR_WANT_READ;
+    }
+}
+
+bool TlsStream::encrypt(evbuffer* plaintext, evbuffer* ciphertextOut, size_t limit) {
+    evbuffer_iovec vec;
+    while (limit > 0 && evbuffer_peek(plaintext, -1, nullptr, &vec, 1) > 0 && vec.iov_len > 0) {
+        const size_t len = std::min(vec.iov_len, limit);
+        size_t written = 0;
+        int ret;
+        if (SSL_is_init_finished(ssl_)) {
+            ret = SSL_write_ex(ssl_, vec.iov_base, len, &written);
+        } else if (earlyPhase_ && earlyRead_) {
+            // 早期数据的响应以0.5-RTT数据发出，无需等待客户端Finished
+            ret = SSL_write_early_data(ssl_, vec.iov_base, len, &written);
+        } else {
+            break; // 等待握手完成后再发送
+        }
+        if (ret <= 0) {
+            int err = SSL_get_error(ssl_, ret);
+            if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+                return false;
+            }
+            break;
+        }
+        evbuffer_drain(plaintext, written);
+        limit -= written;
+    }
+    flushCiphertext(ciphertextOut);
+    return true;
+}
+
+void TlsStream::releaseBuffers() {
+    if (!SSL_is_init_finished(ssl_) || BIO_ctrl_pending(rbio_) > 0 || BIO_ctrl_pending(wbio_) > 0) {
+        return;
+    }
+    BIO* rbio = BIO_new(BIO_s_mem());
+    BIO* wbio = BIO_new(BIO_s_mem());
+    if (!rbio || !wbio) {
+        BIO_free(rbio);
+        BIO_free(wbio);
+        return;
+    }
+    BIO_set_mem_eof_return(rbio, -1);
+    SSL_set_bio(ssl_, rbio, wbio); // 释放旧的rbio_和wbio_
+    rbio_ = rbio;
+    wbio_ = wbio;
+}
+
+void TlsStream::flushCiphertext(evbuffer* ciphertextOut) {
+    char* data = nullptr;
+    long len = BIO_get_mem_data(wbio_, &data);
+    if (len > 0) {
+        evbuffer_add(ciphertextOut, data, static_cast<size_t>(len));
+        (void)BIO_reset(wbio_);
+    }
+}
+
+bufferevent* TlsStream::newBufferevent(event_base* base, SSL* ssl) {
+    // 底层为普通socket bufferevent，evhttp通过bufferevent_setfd设置的fd会转交给它
+    bufferevent* underlying = bufferevent_socket_new(base, -1, BEV_OPT_CLOSE_ON_FREE);
+    if (!underlying) {
+        SSL_free(ssl);
+        return nullptr;
+    }
+
+    TlsStream* stream = new TlsStream(ssl);
+    bufferevent* bev = bufferevent_filter_new(underlying, TlsStream::inputFilter,
+        TlsStream::outputFilter, BEV_OPT_CLOSE_ON_FREE, TlsStream::freeStream, stream);
+    if (!bev) {
+        delete stream;
+        bufferevent_free(underlying);
+        return nullptr;
+    }
+
+    // 底层积压达到高水位时过滤层不再调用outputFilter，底层发空后由写回调继续；
+    // 低水位保持为0：连接关闭前等底层发空的写回调依赖这一点
+    bufferevent_setwatermark(underlying, EV_WRITE, 0, kCiphertextHighWater);
+
+    // evhttp先写入响应再启用EV_WRITE，过滤层在写入时会因未启用写而跳过处理，
+    // 此时由flushEvent_在下一轮事件循环中补发
+    stream->flushEvent_ = event_new(base, -1, 0, TlsStream::flushCallback, stream);
+    evbuffer_add_cb(bufferevent_get_output(bev), TlsStream::outputAddedCallback, stream);
+
+    stream->bev_ = bev;
+    g_streams[bev] = stream;
+    return bev;
+}
+
+TlsStream* TlsStream::fromBufferevent(bufferevent* bev) {
+    std::unordered_map<bufferevent*, TlsStream*>::const_iterator it = g_streams.find(bev);
+    return it == g_streams.end() ? nullptr : it->second;
+}
+
+// 输入过滤：底层密文 -> 明文
+bufferevent_filter_result TlsStream::inputFilter(evbuffer* src, evbuffer* dst,
+    ev_ssize_t /*limit*/, bufferevent_flush_mode /*mode*/, void* ctx) {
+    TlsStream* stream = static_cast<TlsStream*>(ctx);
+    bufferevent* underlying = bufferevent_get_underlying(stream->bev_);
+    const bool wasHandshaking = !SSL_is_init_finished(stream->ssl_);
+    const size_t before = evbuffer_get_length(dst);
+
+    if (!stream->decrypt(src, dst, bufferevent_get_output(underlying))) {
+        return BEV_ERROR;
+    }
+
+    // 握手刚完成时，把等待中的响应交给输出过滤层发送
+    if (wasHandshaking && SSL_is_init_finished(stream->ssl_) &&
+        evbuffer_get_length(bufferevent_get_output(stream->bev_)) > 0) {
+        event_active(stream->flushEvent_, EV_TIMEOUT, 0);
+    }
+
+    return evbuffer_get_length(dst) > before ? BEV_OK : BEV_NEED_MORE;
+}
+
+// 输出过滤：明文 -> 底层密文，limit为底层距高水位的余量（负数表示不限）
+bufferevent_filter_result TlsStream::outputFilter(evbuffer* src, evbuffer* dst,
+    ev_ssize_t limit, bufferevent_flush_mode /*mode*/, void* ctx) {
+    TlsStream* stream = static_cast<TlsStream*>(ctx);
+    const size_t before = evbuffer_get_length(dst);
+
+    if (!stream->encrypt(src, dst, limit < 0 ? SIZE_MAX : static_cast<size_t>(limit))) {
+        return BEV_ERROR;
+    }
+    return evbuffer_get_length(dst) > before ? BEV_OK : BEV_NEED_MORE;
+}
+
+void TlsStream::outputAddedCallback(evbuffer* /*buffer*/, const evbuffer_cb_info* info, void* ctx) {
+    TlsStream* stream = static_cast<TlsStream*>(ctx);
+    if (info->n_added > 0 && !(bufferevent_get_enabled(stream->bev_) & EV_WRITE)) {
+        event_active(stream->flushEvent_, EV_TIMEOUT, 0);
+    }
+}
+
+void TlsStream::flushCallback(evutil_socket_t /*fd*/, short /*events*/, void* ctx) {
+    TlsStream* stream = static_cast<TlsStream*>(ctx);
+    bufferevent_flush(stream->bev_, EV_WRITE, BEV_NORMAL);
+}
+
+void TlsStream::freeStream(void* ctx) {
+    TlsStream* stream = static_cast<TlsStream*>(ctx);
+    g_streams.erase(stream->bev_);
+    delete stream;
+}
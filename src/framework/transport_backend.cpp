@@ -0,0 +1,6 @@
+// src/framework/transport_backend.cpp
+#include "framework/transport_backend.h"
+
+void LibeventBackend::run() {
+    event_base_dispatch(base_);
+}
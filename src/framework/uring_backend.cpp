@@ -0,0 +1,532 @@
+// src/framework/uring_backend.cpp
+#include "framework/uring_backend.h"
+
+#ifdef RPC_HAVE_LIBURING
+
+#include "framework/tls_stream.h"
+#include "framework/http_connection.h"
+#include <event2/buffer.h>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+using namespace std;
+
+static const unsigned kQueueDepth = 4096;   // 提交队列深度
+static const unsigned kBufferCount = 1024;  // 接收缓冲个数，须为2的幂
+static const unsigned kBufferSize = 16384;  // 单个接收缓冲大小，可容纳一条完整的TLS记录
+static const int kBufferGroup = 0;
+static const size_t kMaxLingerBytes = 1024 * 1024; // 延迟关闭期间最多丢弃的字节数
+
+// 单个连接
+struct UringBackend::Connection {
+    Connection(UringBackend* owner, const HttpOptions& options)
+        : backend(owner), options(options),
+          deadline(owner->timers_, options.timeouts, UringBackend::connectionTimeout, this) {}
+
+    UringBackend* backend;
+    const HttpOptions& options;
+    ConnectionDeadline deadline;
+    int fd = -1;
+    TlsStream* tls = nullptr;       // 明文连接为nullptr
+    evbuffer* cipherIn = nullptr;   // 待解密的密文
+    evbuffer* input = nullptr;      // 明文请求数据
+    evbuffer* output = nullptr;     // 明文响应
+    evbuffer* pending = nullptr;    // 待发送的线上字节（TLS连接为密文）
+    evbuffer* inflight = nullptr;   // 已提交send、尚未完成的字节，完成前不可修改
+    bool recvArmed = false;
+    bool sendInFlight = false;
+    bool closeAfterSend = false;
+    bool readPaused = false;        // 响应积压，暂停分发与接收
+    bool closing = false;
+    bool lingering = false;         // 已关闭写方向，丢弃输入直到对端关闭
+    size_t lingerBytes = 0;
+    bool inspected = false;
+    ConnectionState state;
+    HttpConnection* http = nullptr; // 请求分帧与分发，引用state
+};
+
+UringBackend::UringBackend(SSL_CTX* sslCtx, const RpcDispatcher& dispatcher)
+    : ringReady_(false), bufRing_(nullptr), bufPool_(nullptr),
+      sslCtx_(sslCtx), dispatcher_(dispatcher), timers_(kConnectionTimerTickMs) {
+    memset(&ring_, 0, sizeof(ring_));
+    tick_.tv_sec = 0;
+    tick_.tv_nsec = static_cast<long long>(kConnectionTimerTickMs) * 1000000;
+}
+
+UringBackend::~UringBackend() {
+    for (unordered_set<Connection*>::iterator it = connections_.begin(); it != connections_.end(); ++it) {
+        destroyConnection(*it);
+    }
+    for (size_t i = 0; i < listeners_.size(); ++i) {
+        ::close(listeners_[i].fd);
+    }
+    if (bufRing_) {
+        io_uring_free_buf_ring(&ring_, bufRing_, kBufferCount, kBufferGroup);
+    }
+    free(bufPool_);
+    if (ringReady_) {
+        io_uring_queue_exit(&ring_);
+    }
+}
+
+bool UringBackend::init() {
+    // 仅事件循环线程提交，完成事件推迟到等待时统一处理，减少内核抢占回调
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    int ret = io_uring_queue_init_params(kQueueDepth, &ring_, &params);
+    if (ret == -EINVAL) {
+        // 旧内核不支持上述标志
+        memset(&params, 0, sizeof(params));
+        ret = io_uring_queue_init_params(kQueueDepth, &ring_, &params);
+    }
+    if (ret < 0) {
+        cerr << "io_uring_queue_init failed: " << strerror(-ret) << endl;
+        return false;
+    }
+    ringReady_ = true;
+
+    // 所有连接共享的接收缓冲：内核在数据到达时才挑选缓冲，空闲连接不占用
+    bufRing_ = io_uring_setup_buf_ring(&ring_, kBufferCount, kBufferGroup, 0, &ret);
+    if (!bufRing_) {
+        cerr << "io_uring_setup_buf_ring failed: " << strerror(-ret) << endl;
+        return false;
+    }
+    bufPool_ = static_cast<char*>(malloc(static_cast<size_t>(kBufferCount) * kBufferSize));
+    if (!bufPool_) {
+        return false;
+    }
+    for (unsigned i = 0; i < kBufferCount; ++i) {
+        io_uring_buf_ring_add(bufRing_, bufPool_ + static_cast<size_t>(i) * kBufferSize, kBufferSize,
+                              static_cast<unsigned short>(i), io_uring_buf_ring_mask(kBufferCount), i);
+    }
+    io_uring_buf_ring_advance(bufRing_, kBufferCount);
+    return true;
+}
+
+bool UringBackend::listen(const char* address, int port, bool tls, const HttpOptions& options) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+        return false;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0) {
+        cerr << "Error binding " << address << ":" << port << ": " << strerror(errno) << endl;
+        ::close(fd);
+        return false;
+    }
+
+    ListenSocket listener;
+    listener.fd = fd;
+    listener.tls = tls;
+    listener.options = &options;
+    listeners_.push_back(listener);
+    return true;
+}
+
+void UringBackend::run() {
+    for (size_t i = 0; i < listeners_.size(); ++i) {
+        armAccept(i);
+    }
+    armTick();
+
+    for (;;) {
+        // 上一轮处理中准备的提交项与等待合并为一次系统调用
+        const int ret = io_uring_submit_and_wait(&ring_, 1);
+        if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+            cerr << "io_uring_submit_and_wait failed: " << strerror(-ret) << endl;
+            return;
+        }
+
+        unsigned head;
+        unsigned count = 0;
+        io_uring_cqe* cqe;
+        io_uring_for_each_cqe(&ring_, head, cqe) {
+            ++count;
+            const __u64 data = io_uring_cqe_get_data64(cqe);
+            switch (data & 7) {
+                case OP_ACCEPT:
+                    onAccept(static_cast<size_t>(data >> 3), cqe);
+                    break;
+                case OP_RECV:
+                    onRecv(reinterpret_cast<Connection*>(data & ~static_cast<__u64>(7)), cqe);
+                    break;
+                case OP_SEND:
+                    onSend(reinterpret_cast<Connection*>(data & ~static_cast<__u64>(7)), cqe);
+                    break;
+                case OP_TICK:
+                    timers_.advance();
+                    armTick();
+                    break;
+                case OP_CANCEL:
+                    break; // 被撤销的recv另有完成事件
+            }
+        }
+        io_uring_cq_advance(&ring_, count);
+    }
+}
+
+// 提交队列已满时先把已准备的提交交给内核；未启用SQPOLL时提交会立即清空队列
+io_uring_sqe* UringBackend::getSqe() {
+    io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+    if (!sqe) {
+        io_uring_submit(&ring_);
+        sqe = io_uring_get_sqe(&ring_);
+    }
+    return sqe;
+}
+
+void UringBackend::armAccept(size_t index) {
+    io_uring_sqe* sqe = getSqe();
+    io_uring_prep_multishot_accept(sqe, listeners_[index].fd, nullptr, nullptr, SOCK_CLOEXEC);
+    io_uring_sqe_set_data64(sqe, (static_cast<__u64>(index) << 3) | OP_ACCEPT);
+}
+
+void UringBackend::armRecv(Connection* conn) {
+    io_uring_sqe* sqe = getSqe();
+    io_uring_prep_recv_multishot(sqe, conn->fd, nullptr, 0, 0);
+    io_uring_sqe_set_flags(sqe, IOSQE_BUFFER_SELECT);
+    sqe->buf_group = kBufferGroup;
+    io_uring_sqe_set_data64(sqe, reinterpret_cast<__u64>(conn) | OP_RECV);
+    conn->recvArmed = true;
+}
+
+// 每个连接同一时刻只有一个send在途，期间产生的响应累积在pending中
+void UringBackend::armSend(Connection* conn) {
+    if (conn->sendInFlight || conn->closing) {
+        return;
+    }
+    if (evbuffer_get_length(conn->inflight) == 0) {
+        evbuffer_add_buffer(conn->inflight, conn->pending);
+    }
+    const size_t len = evbuffer_get_length(conn->inflight);
+    if (len == 0) {
+        return;
+    }
+    io_uring_sqe* sqe = getSqe();
+    io_uring_prep_send(sqe, conn->fd, evbuffer_pullup(conn->inflight, -1), len, MSG_NOSIGNAL);
+    io_uring_sqe_set_data64(sqe, reinterpret_cast<__u64>(conn) | OP_SEND);
+    conn->sendInFlight = true;
+}
+
+// 积压达到上限：停止分发流水线请求，并撤销multishot recv使内核不再为该连接填充缓冲，
+// 否则不读取响应的对端可以让输入与积压无限增长；积压发完后由onSend恢复
+void UringBackend::pauseReading(Connection* conn) {
+    if (conn->readPaused) {
+        return;
+    }
+    conn->readPaused = true;
+    if (conn->recvArmed) {
+        io_uring_sqe* sqe = getSqe();
+        io_uring_prep_cancel64(sqe, reinterpret_cast<__u64>(conn) | OP_RECV, 0);
+        io_uring_sqe_set_data64(sqe, OP_CANCEL);
+    }
+}
+
+// 单次超时，每次到期后重新提交
+void UringBackend::armTick() {
+    io_uring_sqe* sqe = getSqe();
+    io_uring_prep_timeout(sqe, &tick_, 0, 0);
+    io_uring_sqe_set_data64(sqe, OP_TICK);
+}
+
+void UringBackend::onAccept(size_t index, const io_uring_cqe* cqe) {
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        armAccept(index); // multishot已终止（如文件描述符耗尽），重新提交
+    }
+    if (cqe->res < 0) {
+        return;
+    }
+
+    Connection* conn = new Connection(this, *listeners_[index].options);
+    conn->fd = cqe->res;
+    conn->input = evbuffer_new();
+    conn->output = evbuffer_new();
+    conn->pending = evbuffer_new();
+    conn->inflight = evbuffer_new();
+    conn->state.kind = listeners_[index].tls ? LISTENER_TLS : LISTENER_PLAIN;
+    if (listeners_[index].tls) {
+        conn->tls = new TlsStream(SSL_new(sslCtx_));
+        conn->cipherIn = evbuffer_new();
+    }
+
+    int on = 1;
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    sockaddr_storage peer;
+    socklen_t peerLen = sizeof(peer);
+    char ip[INET6_ADDRSTRLEN] = "unknown";
+    if (getpeername(conn->fd, reinterpret_cast<sockaddr*>(&peer), &peerLen) == 0) {
+        if (peer.ss_family == AF_INET) {
+            const sockaddr_in* in4 = reinterpret_cast<const sockaddr_in*>(&peer);
+            inet_ntop(AF_INET, &in4->sin_addr, ip, sizeof(ip));
+            conn->state.clientPort = ntohs(in4->sin_port);
+        } else if (peer.ss_family == AF_INET6) {
+            const sockaddr_in6* in6 = reinterpret_cast<const sockaddr_in6*>(&peer);
+            inet_ntop(AF_INET6, &in6->sin6_addr, ip, sizeof(ip));
+            conn->state.clientPort = ntohs(in6->sin6_port);
+        }
+    }
+    conn->state.clientIP = ip;
+    conn->http = new HttpConnection(dispatcher_, conn->state, *listeners_[index].options);
+
+    connections_.insert(conn);
+    armRecv(conn);
+    updateDeadline(conn);
+}
+
+void UringBackend::onRecv(Connection* conn, const io_uring_cqe* cqe) {
+    const bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+    if (!more) {
+        conn->recvArmed = false;
+    }
+
+    if (conn->lingering) {
+        if (cqe->res > 0) {
+            recycleBuffer(static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT));
+            conn->lingerBytes += static_cast<size_t>(cqe->res);
+        }
+        if ((cqe->res > 0 || cqe->res == -ENOBUFS) && conn->lingerBytes <= kMaxLingerBytes) {
+            if (!more) {
+                armRecv(conn);
+            }
+            return;
+        }
+        closeConnection(conn); // 对端已关闭、出错或丢弃量超限
+        return;
+    }
+
+    if (cqe->res > 0) {
+        const unsigned short bufferId = static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        if (conn->closing) {
+            // 已shutdown，丢弃数据；multishot也可能带着数据结束（如完成队列溢出），此时须释放连接
+            recycleBuffer(bufferId);
+            if (!more) {
+                releaseIfIdle(conn);
+            }
+            return;
+        }
+        const bool ok = handleInput(conn, bufPool_ + static_cast<size_t>(bufferId) * kBufferSize, cqe->res);
+        recycleBuffer(bufferId);
+        if (!ok) {
+            closeConnection(conn);
+            return;
+        }
+        if (!more && !conn->readPaused) {
+            armRecv(conn);
+        }
+        updateDeadline(conn);
+        return;
+    }
+
+    // 共享缓冲暂时耗尽，稍后重新提交；因积压撤销的接收在恢复时重新提交
+    if ((cqe->res == -ENOBUFS || cqe->res == -ECANCELED) && !conn->closing) {
+        if (!more && !conn->readPaused) {
+            armRecv(conn);
+        }
+        return;
+    }
+
+    // 对端关闭写方向：发完已产生的响应后再关闭
+    if (cqe->res == 0 && !conn->closing &&
+        (conn->sendInFlight || evbuffer_get_length(conn->pending) > 0)) {
+        conn->closeAfterSend = true;
+        updateDeadline(conn);
+        return;
+    }
+    closeConnection(conn);
+}
+
+void UringBackend::onSend(Connection* conn, const io_uring_cqe* cqe) {
+    conn->sendInFlight = false;
+    if (cqe->res < 0 || conn->closing) {
+        closeConnection(conn);
+        return;
+    }
+
+    evbuffer_drain(conn->inflight, static_cast<size_t>(cqe->res));
+    if (evbuffer_get_length(conn->inflight) > 0 || evbuffer_get_length(conn->pending) > 0) {
+        armSend(conn);
+    } else if (conn->closeAfterSend) {
+        if (conn->http->aborted() && conn->recvArmed) {
+            linger(conn);
+        } else {
+            closeConnection(conn);
+        }
+        return;
+    } else if (conn->readPaused || evbuffer_get_length(conn->input) > 0 || conn->http->streaming()) {
+        // 积压发完，继续发送流式响应或处理因输出积压而暂缓的流水线请求，并恢复接收
+        conn->readPaused = false;
+        if (!flushRequests(conn)) {
+            closeConnection(conn);
+            return;
+        }
+        if (!conn->readPaused && !conn->recvArmed) {
+            armRecv(conn);
+        }
+    }
+    updateDeadline(conn, true);
+}
+
+// 处理收到的字节：解密、按请求分帧分发，并提交产生的响应
+bool UringBackend::handleInput(Connection* conn, const char* data, size_t len) {
+    if (conn->tls) {
+        evbuffer_add(conn->cipherIn, data, len);
+        if (!conn->tls->decrypt(conn->cipherIn, conn->input, conn->pending)) {
+            return false;
+        }
+    } else {
+        evbuffer_add(conn->input, data, len);
+    }
+    return flushRequests(conn);
+}
+
+// 分发已缓冲的请求，并提交产生的响应；积压达到上限时请求留在input中
+bool UringBackend::flushRequests(Connection* conn) {
+    if (outputBlocked(conn)) {
+        pauseReading(conn);
+    }
+    if (!conn->readPaused && !handleRequests(conn)) {
+        return false;
+    }
+
+    if (conn->tls) {
+        if (!conn->tls->encrypt(conn->output, conn->pending)) {
+            return false;
+        }
+    } else {
+        evbuffer_add_buffer(conn->pending, conn->output);
+    }
+    if (outputBlocked(conn)) {
+        pauseReading(conn);
+    }
+    armSend(conn);
+    return true;
+}
+
+// 每次process后output都被移入pending，HttpConnection只看得到本轮的输出，
+// 积压须连同尚未发出的字节一起计算；TLS连接按密文计
+bool UringBackend::outputBlocked(const Connection* conn) {
+    return !conn->http->closing() &&
+        evbuffer_get_length(conn->pending) + evbuffer_get_length(conn->inflight) >= conn->options.maxPendingOutput;
+}
+
+// 依次处理缓冲中所有完整的请求（流水线请求按到达顺序响应）
+bool UringBackend::handleRequests(Connection* conn) {
+    // 握手完成后读取一次连接属性，0-RTT阶段的请求按早期数据处理
+    if (conn->tls) {
+        conn->state.earlyData = conn->tls->inEarlyData();
+        if (!conn->inspected && !conn->state.earlyData) {
+            inspectTlsConnection(conn->tls->ssl(), conn->state);
+            conn->inspected = true;
+            cout << "Connection: " << conn->state.clientIP << ":" << conn->state.clientPort
+                << " using protocol: " << conn->state.protocol
+                << ", cipher: " << conn->state.cipher << endl;
+        }
+    } else if (!conn->inspected) {
+        conn->inspected = true;
+        cout << "Connection: " << conn->state.clientIP << ":" << conn->state.clientPort
+            << " using local transport: plaintext" << endl;
+    }
+
+    conn->http->process(conn->input, conn->output,
+                        evbuffer_get_length(conn->pending) + evbuffer_get_length(conn->inflight));
+    if (conn->http->closing()) {
+        conn->closeAfterSend = true;
+    }
+    return true;
+}
+
+void UringBackend::recycleBuffer(unsigned short bufferId) {
+    io_uring_buf_ring_add(bufRing_, bufPool_ + static_cast<size_t>(bufferId) * kBufferSize, kBufferSize,
+                          bufferId, io_uring_buf_ring_mask(kBufferCount), 0);
+    io_uring_buf_ring_advance(bufRing_, 1);
+}
+
+// 关闭连接：shutdown使在途的multishot recv结束，所有在途操作完成后再释放
+void UringBackend::closeConnection(Connection* conn) {
+    if (!conn->closing) {
+        conn->closing = true;
+        shutdown(conn->fd, SHUT_RDWR);
+    }
+    releaseIfIdle(conn);
+}
+
+// 请求未读完即被拒绝时，对端可能仍在发送请求体，直接关闭会使内核以RST回应，
+// 对端可能因此读不到已发出的响应；先关闭写方向，继续接收并丢弃直到对端关闭
+void UringBackend::linger(Connection* conn) {
+    conn->lingering = true;
+    shutdown(conn->fd, SHUT_WR);
+    evbuffer_drain(conn->input, evbuffer_get_length(conn->input));
+    updateDeadline(conn);
+}
+
+// 每次I/O之后按连接所处的阶段计时，超时与各阶段的含义见connection_deadline.h；
+// 握手进度与写出进展都经由本后端的完成事件，不必像原生引擎那样在到期时再确认。
+// wrote表示刚有send完成，仍有输出待发送时写超时重新计时
+void UringBackend::updateDeadline(Connection* conn, bool wrote) {
+    if (conn->closing) {
+        conn->deadline.cancel(); // 已shutdown，等待在途操作结束后释放
+        return;
+    }
+    TimeoutStage stage;
+    if (conn->lingering) {
+        stage = STAGE_LINGER;
+    } else if (conn->tls && SSL_in_init(conn->tls->ssl())) {
+        stage = STAGE_HANDSHAKE;
+    } else if (conn->sendInFlight || evbuffer_get_length(conn->pending) > 0) {
+        stage = STAGE_WRITE;
+    } else {
+        stage = conn->http->readStage(conn->input);
+    }
+    const TimeoutStage previous = conn->deadline.stage();
+    conn->deadline.enter(stage, conn->http->served());
+    if (wrote && stage == STAGE_WRITE && previous == STAGE_WRITE) {
+        conn->deadline.restart();
+    }
+}
+
+void UringBackend::connectionTimeout(void* arg) {
+    Connection* conn = static_cast<Connection*>(arg);
+    conn->backend->closeConnection(conn);
+}
+
+void UringBackend::releaseIfIdle(Connection* conn) {
+    if (conn->recvArmed || conn->sendInFlight) {
+        return;
+    }
+    connections_.erase(conn);
+    destroyConnection(conn);
+}
+
+void UringBackend::destroyConnection(Connection* conn) {
+    ::close(conn->fd);
+    delete conn->http;
+    delete conn->tls;
+    evbuffer_free(conn->input);
+    evbuffer_free(conn->output);
+    evbuffer_free(conn->pending);
+    evbuffer_free(conn->inflight);
+    if (conn->cipherIn) {
+        evbuffer_free(conn->cipherIn);
+    }
+    delete conn;
+}
+
+#endif // RPC_HAVE_LIBURING
@@ -0,0 +1,394 @@
+// src/framework/websocket.cpp
+#include "framework/websocket.h"
+#include <cstdlib>
+#include <cstring>
+#include <openssl/evp.h>
+
+static const char kWebSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// 帧头第一字节
+static const unsigned char kFin = 0x80;
+static const unsigned char kRsv1 = 0x40; // permessage-deflate：本消息经过压缩
+static const unsigned char kRsvMask = 0x70;
+
+enum WebSocketOpcode {
+    WS_CONTINUATION = 0x0,
+    WS_TEXT = 0x1,
+    WS_BINARY = 0x2,
+    WS_CLOSE = 0x8,
+    WS_PING = 0x9,
+    WS_PONG = 0xA
+};
+
+static std::string trim(const std::string& s) {
+    const size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    return s.substr(begin, s.find_last_not_of(" \t") - begin + 1);
+}
+
+// 解析一项permessage-deflate提议（已按逗号切分），可接受时返回true并给出服务端压缩窗口
+// 参数值可带引号；未知参数、server_max_window_bits=8（zlib的原始deflate不支持8）或重复参数时拒绝此项提议
+static bool parseDeflateOffer(const std::string& offer, int& serverWindowBits) {
+    size_t pos = offer.find(';');
+    if (trim(offer.substr(0, pos)) != "permessage-deflate") {
+        return false;
+    }
+    serverWindowBits = 15;
+    bool seenServerBits = false;
+    bool seenClientBits = false;
+    while (pos != std::string::npos) {
+        const size_t next = offer.find(';', pos + 1);
+        const std::string param = offer.substr(pos + 1, next == std::string::npos ? std::string::npos : next - pos - 1);
+        pos = next;
+
+        const size_t eq = param.find('=');
+        const std::string name = trim(param.substr(0, eq));
+        std::string value = eq == std::string::npos ? std::string() : trim(param.substr(eq + 1));
+        if (value.size() >= 2 && value[0] == '"' && value[value.size() - 1] == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+
+        if (name == "server_no_context_takeover" || name == "client_no_context_takeover") {
+            continue; // 服务端总是逐条消息重置压缩与解压上下文
+        }
+        if (name == "server_max_window_bits") {
+            const int bits = atoi(value.c_str());
+            if (seenServerBits || bits < 9 || bits > 15) {
+                return false;
+            }
+            serverWindowBits = bits;
+            seenServerBits = true;
+        } else if (name == "client_max_window_bits") {
+            // 解压始终使用最大窗口，可接受客户端选用的任意窗口
+            if (seenClientBits || (!value.empty() && (atoi(value.c_str()) < 8 || atoi(value.c_str()) > 15))) {
+                return false;
+            }
+            seenClientBits = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+WebSocketHandshake acceptWebSocket(const HttpRequest& request, const WebSocketPolicy& policy,
+                                   evbuffer* output, WebSocketSettings& settings) {
+    if (!request.method.equals("GET") || request.contentLength != 0 || request.minorVersion < 1) {
+        return WS_HANDSHAKE_BAD_REQUEST;
+    }
+    const StringRef* version = request.header("Sec-WebSocket-Version");
+    if (!version) {
+        return WS_HANDSHAKE_BAD_REQUEST;
+    }
+    if (!version->equals("13")) {
+        return WS_HANDSHAKE_BAD_VERSION;
+    }
+    // 密钥为16字节随机数的base64编码
+    const StringRef* key = request.header("Sec-WebSocket-Key");
+    if (!key || key->size != 24) {
+        return WS_HANDSHAKE_BAD_REQUEST;
+    }
+
+    // Sec-WebSocket-Accept = base64(SHA1(key + GUID))
+    std::string source = key->str();
+    source += kWebSocketGuid;
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLen = 0;
+    if (!EVP_Digest(source.data(), source.size(), digest, &digestLen, EVP_sha1(), nullptr)) {
+        return WS_HANDSHAKE_BAD_REQUEST;
+    }
+    unsigned char accept[4 * ((EVP_MAX_MD_SIZE + 2) / 3) + 1];
+    EVP_EncodeBlock(accept, digest, static_cast<int>(digestLen));
+
+    // 按客户端给出的顺序选第一项可接受的permessage-deflate提议
+    settings = WebSocketSettings();
+    const StringRef* extensions = request.header("Sec-WebSocket-Extensions");
+    if (policy.deflate && extensions) {
+        const std::string offers = extensions->str();
+        size_t begin = 0;
+        while (!settings.deflate && begin <= offers.size()) {
+            size_t end = offers.find(',', begin);
+            if (end == std::string::npos) {
+                end = offers.size();
+            }
+            settings.deflate = parseDeflateOffer(offers.substr(begin, end - begin), settings.serverWindowBits);
+            begin = end + 1;
+        }
+    }
+
+    evbuffer_add_printf(output,
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: %s\r\n", accept);
+    if (settings.deflate) {
+        // 要求客户端同样不保留上下文，服务端的解压上下文才能按线程共用
+        evbuffer_add_printf(output,
+            "Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover; client_no_context_takeover");
+        if (settings.serverWindowBits != 15) {
+            evbuffer_add_printf(output, "; server_max_window_bits=%d", settings.serverWindowBits);
+        }
+        evbuffer_add(output, "\r\n", 2);
+    }
+    evbuffer_add(output, "\r\n", 2);
+    return WS_HANDSHAKE_OK;
+}
+
+// 按4字节掩码原地解除掩码，按8字节一组处理
+static void unmask(unsigned char* data, size_t length, const unsigned char mask[4]) {
+    uint64_t wide;
+    unsigned char pattern[8];
+    for (int i = 0; i < 8; ++i) {
+        pattern[i] = mask[i & 3];
+    }
+    memcpy(&wide, pattern, sizeof(wide));
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t chunk;
+        memcpy(&chunk, data + i, sizeof(chunk));
+        chunk ^= wide;
+        memcpy(data + i, &chunk, sizeof(chunk));
+    }
+    for (; i < length; ++i) {
+        data[i] ^= mask[i & 3];
+    }
+}
+
+// 关闭帧中允许对端发送的状态码（RFC 6455 7.4）
+static bool validCloseCode(unsigned code) {
+    return (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1011) || (code >= 3000 && code <= 4999);
+}
+
+WebSocketConnection::WebSocketConnection(const RpcDispatcher& dispatcher, ConnectionState& state,
+                                         const HttpOptions& options, const WebSocketSettings& settings)
+    : dispatcher_(dispatcher), state_(state), options_(options), settings_(settings), closing_(false),
+      messageOpcode_(0), messageCompressed_(false), frames_(dispatcher, state, options),
+      framesIn_(evbuffer_new()), framesOut_(evbuffer_new()) {}
+
+WebSocketConnection::~WebSocketConnection() {
+    evbuffer_free(framesIn_);
+    evbuffer_free(framesOut_);
+}
+
+void WebSocketConnection::process(evbuffer* input, evbuffer* output) {
+    while (!closing_ && evbuffer_get_length(output) < options_.maxPendingOutput && readFrame(input, output)) {
+    }
+}
+
+// 读取并处理一个完整的帧；返回false表示需要等待更多数据或连接已转入关闭
+bool WebSocketConnection::readFrame(evbuffer* input, evbuffer* output) {
+    unsigned char header[14];
+    const ev_ssize_t copied = evbuffer_copyout(input, header, sizeof(header));
+    if (copied < 2) {
+        return false;
+    }
+    const size_t available = static_cast<size_t>(copied);
+    const bool fin = (header[0] & kFin) != 0;
+    const unsigned rsv = header[0] & kRsvMask;
+    const unsigned opcode = header[0] & 0x0f;
+    if (!(header[1] & 0x80)) {
+        close(output, WS_CLOSE_PROTOCOL_ERROR); // 客户端发出的帧必须带掩码
+        return false;
+    }
+
+    uint64_t length = header[1] & 0x7f;
+    size_t headerLength = 2;
+    if (length == 126) {
+        headerLength = 4;
+    } else if (length == 127) {
+        headerLength = 10;
+    }
+    headerLength += 4; // 掩码
+    if (available < headerLength) {
+        return false;
+    }
+    if (length == 126) {
+        length = (static_cast<uint64_t>(header[2]) << 8) | header[3];
+    } else if (length == 127) {
+        length = 0;
+        for (int i = 2; i < 10; ++i) {
+            length = (length << 8) | header[i];
+        }
+    }
+
+    if (opcode & 0x08) {
+        // 控制帧不可分片，长度不超过125
+        if (!fin || rsv != 0 || length > 125 || (opcode != WS_CLOSE && opcode != WS_PING && opcode != WS_PONG)) {
+            close(output, WS_CLOSE_PROTOCOL_ERROR);
+            return false;
+        }
+    } else {
+        const bool validOpcode = opcode == WS_CONTINUATION ? messageOpcode_ != 0 :
+            (opcode == WS_TEXT || opcode == WS_BINARY) && messageOpcode_ == 0;
+        // RSV1只出现在压缩消息的第一帧
+        const unsigned allowedRsv = (opcode != WS_CONTINUATION && settings_.deflate) ? kRsv1 : 0;
+        if (!validOpcode || (rsv & ~allowedRsv) != 0) {
+            close(output, WS_CLOSE_PROTOCOL_ERROR);
+            return false;
+        }
+        // 按帧头给出的长度在缓冲负载之前拒绝超限的消息
+        const uint64_t messageLength = length + (opcode == WS_CONTINUATION ? message_.size() : 0);
+        if (length > options_.limits.maxBodySize || messageLength > options_.limits.maxBodySize) {
+            close(output, WS_CLOSE_TOO_BIG);
+            return false;
+        }
+    }
+
+    const size_t frameLength = headerLength + static_cast<size_t>(length);
+    if (evbuffer_get_length(input) < frameLength) {
+        return false;
+    }
+    unsigned char* frame = evbuffer_pullup(input, static_cast<ev_ssize_t>(frameLength));
+    unsigned char* payload = frame + headerLength;
+    unmask(payload, static_cast<size_t>(length), frame + headerLength - 4);
+    const char* data = reinterpret_cast<const char*>(payload);
+
+    if (opcode & 0x08) {
+        handleControl(opcode, data, static_cast<size_t>(length), output);
+    } else if (opcode != WS_CONTINUATION && fin) {
+        // 单帧消息：直接在读缓冲上分发
+        handleMessage(opcode, (rsv & kRsv1) != 0, StringRef(data, static_cast<size_t>(length)), output);
+    } else {
+        if (opcode != WS_CONTINUATION) {
+            messageOpcode_ = opcode;
+            messageCompressed_ = (rsv & kRsv1) != 0;
+            message_.clear();
+        }
+        message_.append(data, static_cast<size_t>(length));
+        if (fin) {
+            const unsigned messageOpcode = messageOpcode_;
+            messageOpcode_ = 0;
+            handleMessage(messageOpcode, messageCompressed_, StringRef(message_), output);
+            message_.clear();
+        }
+    }
+    evbuffer_drain(input, frameLength);
+    return !closing_;
+}
+
+void WebSocketConnection::handleControl(unsigned opcode, const char* payload, size_t length, evbuffer* output) {
+    if (opcode == WS_PING) {
+        writeFrame(output, kFin | WS_PONG, StringRef(payload, length));
+        return;
+    }
+    if (opcode == WS_PONG) {
+        return;
+    }
+    // 对端发起关闭：回送其状态码后关闭连接
+    if (length == 0) {
+        close(output, WS_CLOSE_NORMAL);
+        return;
+    }
+    const unsigned code = length < 2 ? 0 :
+        (static_cast<unsigned char>(payload[0]) << 8) | static_cast<unsigned char>(payload[1]);
+    close(output, validCloseCode(code) ? static_cast<WebSocketCloseCode>(code) : WS_CLOSE_PROTOCOL_ERROR);
+}
+
+void WebSocketConnection::handleMessage(unsigned opcode, bool compressed, StringRef data, evbuffer* output) {
+    if (compressed) {
+        try {
+            inflateMessage(data, options_.webSocket.maxInflatedSize, inflated_);
+        } catch (const DecompressionError& e) {
+            close(output, e.sizeExceeded() ? WS_CLOSE_TOO_BIG : WS_CLOSE_INVALID_DATA);
+            return;
+        }
+        data = StringRef(inflated_);
+    }
+
+    if (opcode == WS_TEXT) {
+        RpcCall call(data);
+        dispatcher_(call, state_);
+        sendMessage(output, WS_TEXT, StringRef(call.response), call.compressible);
+    } else {
+        handleBinary(data, output);
+    }
+}
+
+// 二进制消息中的请求帧交给BinaryConnection，响应帧合为一条二进制消息；
+// 消息必须恰好包含完整的帧，帧跨消息或帧头损坏时关闭会话
+void WebSocketConnection::handleBinary(StringRef data, evbuffer* output) {
+    evbuffer_add_reference(framesIn_, data.data, data.size, nullptr, nullptr);
+    for (;;) {
+        frames_.process(framesIn_, framesOut_);
+        if (frames_.closing() || evbuffer_get_length(framesIn_) == 0 || !frames_.outputBlocked(evbuffer_get_length(framesOut_))) {
+            break;
+        }
+        // 一条消息中的请求过多，响应超过积压上限时先作为一条消息发出
+        const size_t pending = evbuffer_get_length(framesOut_);
+        sendMessage(output, WS_BINARY, StringRef(reinterpret_cast<const char*>(evbuffer_pullup(framesOut_, -1)),
+                                                 pending), true);
+        evbuffer_drain(framesOut_, pending);
+    }
+
+    const size_t pending = evbuffer_get_length(framesOut_);
+    if (pending > 0) {
+        sendMessage(output, WS_BINARY, StringRef(reinterpret_cast<const char*>(evbuffer_pullup(framesOut_, -1)),
+                                                 pending), true);
+        evbuffer_drain(framesOut_, pending);
+    }
+    const bool truncated = evbuffer_get_length(framesIn_) > 0 || !frames_.idle();
+    evbuffer_drain(framesIn_, evbuffer_get_length(framesIn_)); // 不再引用data
+    if (frames_.closing()) {
+        close(output, WS_CLOSE_PROTOCOL_ERROR);
+    } else if (truncated) {
+        close(output, WS_CLOSE_INVALID_DATA);
+    }
+}
+
+// 发送一条未分片的消息；协商了permessage-deflate时按压缩策略的阈值压缩
+void WebSocketConnection::sendMessage(evbuffer* output, unsigned opcode, StringRef body, bool compressible) {
+    unsigned char first = static_cast<unsigned char>(kFin | opcode);
+    if (settings_.deflate && compressible && body.size >= options_.compression.minSize &&
+        ResponseCompressor::forThread().deflateMessage(options_.compression.gzipLevel, settings_.serverWindowBits,
+                                                       body, deflated_) &&
+        deflated_.size() < body.size) {
+        first |= kRsv1;
+        body = StringRef(deflated_);
+    }
+    writeFrame(output, first, body);
+}
+
+// 服务端发出的帧不带掩码，帧头与负载写入同一段连续空间
+void WebSocketConnection::writeFrame(evbuffer* output, unsigned char first, StringRef payload) {
+    size_t headerLength = 2;
+    if (payload.size > 0xffff) {
+        headerLength = 10;
+    } else if (payload.size >= 126) {
+        headerLength = 4;
+    }
+    const size_t total = headerLength + payload.size;
+    evbuffer_iovec vec;
+    if (evbuffer_reserve_space(output, static_cast<ev_ssize_t>(total), &vec, 1) != 1) {
+        return;
+    }
+    unsigned char* p = static_cast<unsigned char*>(vec.iov_base);
+    p[0] = first;
+    if (headerLength == 2) {
+        p[1] = static_cast<unsigned char>(payload.size);
+    } else if (headerLength == 4) {
+        p[1] = 126;
+        p[2] = static_cast<unsigned char>(payload.size >> 8);
+        p[3] = static_cast<unsigned char>(payload.size);
+    } else {
+        p[1] = 127;
+        const uint64_t length = payload.size;
+        for (int i = 0; i < 8; ++i) {
+            p[2 + i] = static_cast<unsigned char>(length >> (56 - 8 * i));
+        }
+    }
+    if (payload.size > 0) {
+        memcpy(p + headerLength, payload.data, payload.size);
+    }
+    vec.iov_len = total;
+    evbuffer_commit_space(output, &vec, 1);
+}
+
+// 发出关闭帧；之后不再读取，输出发送完毕后由引擎关闭连接
+void WebSocketConnection::close(evbuffer* output, WebSocketCloseCode code) {
+    const char payload[2] = {static_cast<char>(code >> 8), static_cast<char>(code & 0xff)};
+    writeFrame(output, kFin | WS_CLOSE, StringRef(payload, sizeof(payload)));
+    closing_ = true;
+}
@@ -1,8 +1,12 @@
 // main.cpp
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
+#include <csignal>
 #include <unistd.h>
+#include <getopt.h>
 #include <sys/stat.h>
+#include <sys/resource.h>
 #include <fcntl.h>
 #include <openssl/evp.h> // 添加 OpenSSL EVP 头文件包含
 #include <openssl/x509.h> // 添加 OpenSSL X509 头文件包含
@@ -19,13 +23,122 @@ struct Arguments {
     std::string serverKeyPath = "cert/server.key";
     std::string logFilePath = "rpc_server.log"; // 默认日志文件路径
     bool verbose = false;
+    ServerOptions serverOptions;
 };
 
+// 仅提供长格式的选项
+enum LongOption {
+    OPT_EARLY_DATA = 256,
+    OPT_REPLAY_WINDOW,
+    OPT_UNIX_SOCKET,
+    OPT_TRUSTED_UID,
+    OPT_PLAIN_PORT,
+    OPT_LEAN_IDLE,
+    OPT_HTTP2_PORT,
+    OPT_BACKEND,
+    OPT_HTTP_ENGINE,
+    OPT_KEEPALIVE_REQUESTS,
+    OPT_KEEPALIVE_TIMEOUT,
+    OPT_MAX_CONNECTIONS,
+    OPT_COMPRESS,
+    OPT_COMPRESS_MIN_SIZE,
+    OPT_MAX_DECOMPRESSED_SIZE,
+    OPT_MAX_HEADER_SIZE,
+    OPT_MAX_BODY_SIZE,
+    OPT_BINARY_PORT,
+    OPT_BINARY_SOCKET,
+    OPT_WEBSOCKET,
+    OPT_WS_DEFLATE,
+    OPT_HANDSHAKE_TIMEOUT,
+    OPT_HEADER_TIMEOUT,
+    OPT_BODY_TIMEOUT,
+    OPT_WRITE_TIMEOUT,
+    OPT_AUDIT_FORMAT,
+    OPT_AUDIT_SEGMENT_SIZE,
+    OPT_AUDIT_SAMPLE,
+    OPT_AUDIT_CLIENT_RATE,
+    OPT_AUDIT_ROTATE_SIZE,
+    OPT_AUDIT_ROTATE_INTERVAL,
+    OPT_AUDIT_COMPRESS,
+    OPT_ADMIN_PORT,
+    OPT_DEBUG_TRACE
+};
+
+static const struct option kLongOptions[] = {
+    {"early-data",    no_argument,       nullptr, OPT_EARLY_DATA},
+    {"replay-window", required_argument, nullptr, OPT_REPLAY_WINDOW},
+    {"unix-socket",   required_argument, nullptr, OPT_UNIX_SOCKET},
+    {"trusted-uid",   required_argument, nullptr, OPT_TRUSTED_UID},
+    {"plain-port",    required_argument, nullptr, OPT_PLAIN_PORT},
+    {"lean-idle",     no_argument,       nullptr, OPT_LEAN_IDLE},
+    {"h2-port",       required_argument, nullptr, OPT_HTTP2_PORT},
+    {"backend",       required_argument, nullptr, OPT_BACKEND},
+    {"http-engine",   required_argument, nullptr, OPT_HTTP_ENGINE},
+    {"keepalive-requests", required_argument, nullptr, OPT_KEEPALIVE_REQUESTS},
+    {"keepalive-timeout",  required_argument, nullptr, OPT_KEEPALIVE_TIMEOUT},
+    {"max-connections",    required_argument, nullptr, OPT_MAX_CONNECTIONS},
+    {"compress",           no_argument,       nullptr, OPT_COMPRESS},
+    {"compress-min-size",  required_argument, nullptr, OPT_COMPRESS_MIN_SIZE},
+    {"max-decompressed-size", required_argument, nullptr, OPT_MAX_DECOMPRESSED_SIZE},
+    {"max-header-size",    required_argument, nullptr, OPT_MAX_HEADER_SIZE},
+    {"max-body-size",      required_argument, nullptr, OPT_MAX_BODY_SIZE},
+    {"binary-port",        required_argument, nullptr, OPT_BINARY_PORT},
+    {"binary-socket",      required_argument, nullptr, OPT_BINARY_SOCKET},
+    {"websocket",          no_argument,       nullptr, OPT_WEBSOCKET},
+    {"ws-deflate",         no_argument,       nullptr, OPT_WS_DEFLATE},
+    {"handshake-timeout",  required_argument, nullptr, OPT_HANDSHAKE_TIMEOUT},
+    {"header-timeout",     required_argument, nullptr, OPT_HEADER_TIMEOUT},
+    {"body-timeout",       required_argument, nullptr, OPT_BODY_TIMEOUT},
+    {"write-timeout",      required_argument, nullptr, OPT_WRITE_TIMEOUT},
+    {"audit-format",       required_argument, nullptr, OPT_AUDIT_FORMAT},
+    {"audit-segment-size", required_argument, nullptr, OPT_AUDIT_SEGMENT_SIZE},
+    {"audit-sample",       required_argument, nullptr, OPT_AUDIT_SAMPLE},
+    {"audit-client-rate",  required_argument, nullptr, OPT_AUDIT_CLIENT_RATE},
+    {"audit-rotate-size",  required_argument, nullptr, OPT_AUDIT_ROTATE_SIZE},
+    {"audit-rotate-interval", required_argument, nullptr, OPT_AUDIT_ROTATE_INTERVAL},
+    {"audit-compress",     required_argument, nullptr, OPT_AUDIT_COMPRESS},
+    {"admin-port",         required_argument, nullptr, OPT_ADMIN_PORT},
+    {"debug-trace",        no_argument,       nullptr, OPT_DEBUG_TRACE},
+    {nullptr,         0,                 nullptr, 0}
+};
+
+// 解析超时秒数，0表示不限
+static void parseTimeout(const char* arg, int ConnectionTimeouts::* field, ServerOptions& options) {
+    const int seconds = atoi(arg);
+    if (seconds < 0) {
+        std::cerr << "无效的超时: " << arg << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    options.timeouts.*field = seconds;
+}
+
+// 解析"[监听器=]字节数"形式的请求上限，监听器为tls、unix、plain、h2、bin或bin-unix，省略时作用于全部监听器
+static void parseListenerLimit(const char* arg, size_t RequestLimits::* field, ServerOptions& options) {
+    const char* eq = strchr(arg, '=');
+    const char* value = eq ? eq + 1 : arg;
+    if (atol(value) <= 0) {
+        std::cerr << "无效的请求长度上限: " << arg << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    for (int kind = 0; kind < kListenerKindCount; ++kind) {
+        const char* name = listenerKindName(static_cast<ListenerKind>(kind));
+        if (!eq || (strlen(name) == static_cast<size_t>(eq - arg) && strncmp(arg, name, eq - arg) == 0)) {
+            options.limits[kind].*field = static_cast<size_t>(atol(value));
+            if (eq) {
+                return;
+            }
+        }
+    }
+    if (eq) {
+        std::cerr << "未知的监听器: " << std::string(arg, eq - arg) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
 
 // 提取参数解析逻辑到单独的函数
 void parseArguments(int argc, char* argv[], Arguments& args) {
     int opt;
-    while ((opt = getopt(argc, argv, "p:dl:m:n:v")) != -1) {
+    while ((opt = getopt_long(argc, argv, "p:dl:m:n:v", kLongOptions, nullptr)) != -1) {
         switch (opt) {
             case 'p':
                 args.port = atoi(optarg);
@@ -52,24 +165,244 @@ void parseArguments(int argc, char* argv[], Arguments& args) {
                 }
                 break;
             case 'l':
-                // 处理日志文件路径
+                // 处理审计日志文件路径，不存在时由服务器创建
                 args.logFilePath = optarg ? optarg : args.logFilePath;
-                if (access(args.logFilePath.c_str(), F_OK) != 0) {
-                    std::cerr << "日志文件(" << args.logFilePath << ")不存在" << std::endl;
-                }
                 break;
             case 'v':
                 // 启用详细日志输出
                 args.verbose = true;
                 break;
+            case OPT_EARLY_DATA:
+                // 启用TLS 1.3 0-RTT早期数据
+                args.serverOptions.earlyData = true;
+                break;
+            case OPT_REPLAY_WINDOW:
+                args.serverOptions.replayWindowSec = atoi(optarg);
+                if (args.serverOptions.replayWindowSec <= 0) {
+                    std::cerr << "无效的防重放窗口: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_UNIX_SOCKET:
+                // 同机sidecar使用的Unix域套接字
+                args.serverOptions.unixSocketPath = optarg;
+                break;
+            case OPT_TRUSTED_UID:
+                // 可重复指定，追加允许接入Unix域套接字的uid
+                args.serverOptions.trustedUids.push_back(static_cast<uid_t>(atoi(optarg)));
+                break;
+            case OPT_PLAIN_PORT:
+                args.serverOptions.plainPort = atoi(optarg);
+                if (args.serverOptions.plainPort < 1 || args.serverOptions.plainPort > 65535) {
+                    std::cerr << "无效端口号: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_ADMIN_PORT:
+                // 127.0.0.1上的管理端口，GET /metrics导出调用计数与延迟直方图
+                args.serverOptions.adminPort = atoi(optarg);
+                if (args.serverOptions.adminPort < 1 || args.serverOptions.adminPort > 65535) {
+                    std::cerr << "无效端口号: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_DEBUG_TRACE:
+                // 带X-Rpc-Trace头的请求以Server-Timing返回各阶段耗时
+                args.serverOptions.debugTrace = true;
+                break;
+            case OPT_LEAN_IDLE:
+                // 空闲连接释放TLS与HTTP缓冲区
+                args.serverOptions.leanIdle = true;
+                break;
+            case OPT_HTTP2_PORT:
+                args.serverOptions.http2Port = atoi(optarg);
+                if (args.serverOptions.http2Port < 1 || args.serverOptions.http2Port > 65535) {
+                    std::cerr << "无效端口号: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_BACKEND:
+                // 传输后端：libevent（默认）或io_uring
+                args.serverOptions.backend = optarg;
+                break;
+            case OPT_HTTP_ENGINE:
+                // HTTP/1.1引擎：native（默认）或evhttp（兼容模式）
+                args.serverOptions.httpEngine = optarg;
+                break;
+            case OPT_KEEPALIVE_REQUESTS:
+                // 单个keep-alive连接最多处理的请求数，0表示不限
+                if (atoi(optarg) < 0) {
+                    std::cerr << "无效的单连接请求数上限: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                args.serverOptions.keepAliveRequests = static_cast<unsigned>(atoi(optarg));
+                break;
+            case OPT_KEEPALIVE_TIMEOUT:
+                parseTimeout(optarg, &ConnectionTimeouts::idleSec, args.serverOptions);
+                break;
+            case OPT_HANDSHAKE_TIMEOUT:
+                parseTimeout(optarg, &ConnectionTimeouts::handshakeSec, args.serverOptions);
+                break;
+            case OPT_HEADER_TIMEOUT:
+                parseTimeout(optarg, &ConnectionTimeouts::headerSec, args.serverOptions);
+                break;
+            case OPT_BODY_TIMEOUT:
+                parseTimeout(optarg, &ConnectionTimeouts::bodySec, args.serverOptions);
+                break;
+            case OPT_WRITE_TIMEOUT:
+                parseTimeout(optarg, &ConnectionTimeouts::writeSec, args.serverOptions);
+                break;
+            case OPT_MAX_CONNECTIONS:
+                if (atoi(optarg) < 0) {
+                    std::cerr << "无效的连接数上限: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                args.serverOptions.maxConnections = static_cast<unsigned>(atoi(optarg));
+                break;
+            case OPT_COMPRESS:
+                // 按Accept-Encoding压缩响应体
+                args.serverOptions.compression.enabled = true;
+                break;
+            case OPT_COMPRESS_MIN_SIZE:
+                if (atoi(optarg) < 0) {
+                    std::cerr << "无效的压缩阈值: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                args.serverOptions.compression.minSize = static_cast<size_t>(atoi(optarg));
+                break;
+            case OPT_MAX_DECOMPRESSED_SIZE:
+                // 压缩请求体解压后的长度上限
+                if (atol(optarg) <= 0) {
+                    std::cerr << "无效的解压长度上限: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                args.serverOptions.maxDecompressedSize = static_cast<size_t>(atol(optarg));
+                break;
+            case OPT_MAX_HEADER_SIZE:
+                parseListenerLimit(optarg, &RequestLimits::maxHeaderSize, args.serverOptions);
+                break;
+            case OPT_MAX_BODY_SIZE:
+                parseListenerLimit(optarg, &RequestLimits::maxBodySize, args.serverOptions);
+                break;
+            case OPT_BINARY_PORT:
+                args.serverOptions.binaryPort = atoi(optarg);
+                if (args.serverOptions.binaryPort < 1 || args.serverOptions.binaryPort > 65535) {
+                    std::cerr << "无效端口号: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_BINARY_SOCKET:
+                // 二进制帧协议的Unix域套接字，与--unix-socket共用--trusted-uid
+                args.serverOptions.binarySocketPath = optarg;
+                break;
+            case OPT_WEBSOCKET:
+                args.serverOptions.webSocket = true;
+                break;
+            case OPT_WS_DEFLATE:
+                args.serverOptions.webSocket = true;
+                args.serverOptions.webSocketDeflate = true;
+                break;
+            case OPT_AUDIT_FORMAT:
+                // 审计日志格式：json（默认）或binary（内存映射的段文件，用tools/audit_decode.py解码）
+                if (strcmp(optarg, "json") == 0) {
+                    args.serverOptions.audit.format = AUDIT_FORMAT_JSON;
+                } else if (strcmp(optarg, "binary") == 0) {
+                    args.serverOptions.audit.format = AUDIT_FORMAT_BINARY;
+                } else {
+                    std::cerr << "未知的审计日志格式: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_AUDIT_SEGMENT_SIZE:
+                if (atol(optarg) <= 0) {
+                    std::cerr << "无效的审计日志段大小: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                args.serverOptions.audit.segmentSize = static_cast<size_t>(atol(optarg));
+                break;
+            case OPT_AUDIT_SAMPLE:
+                // 成功的调用每N次记录一次，出错的调用总是记录
+                if (atoi(optarg) < 1) {
+                    std::cerr << "无效的审计采样率: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                args.serverOptions.audit.sampleRate = static_cast<unsigned>(atoi(optarg));
+                break;
+            case OPT_AUDIT_CLIENT_RATE:
+                if (atoi(optarg) < 0) {
+                    std::cerr << "无效的审计客户端速率: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                args.serverOptions.audit.maxPerClientPerSec = static_cast<unsigned>(atoi(optarg));
+                break;
+            case OPT_AUDIT_ROTATE_SIZE:
+                if (atol(optarg) < 0) {
+                    std::cerr << "无效的审计日志轮转大小: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                args.serverOptions.audit.rotateBytes = static_cast<size_t>(atol(optarg));
+                break;
+            case OPT_AUDIT_ROTATE_INTERVAL:
+                if (atoi(optarg) < 0) {
+                    std::cerr << "无效的审计日志轮转间隔: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                args.serverOptions.audit.rotateIntervalSec = static_cast<unsigned>(atoi(optarg));
+                break;
+            case OPT_AUDIT_COMPRESS:
+                // 轮转出的文件：gzip（默认，后台线程压缩为.gz）或none（保持原样）
+                if (strcmp(optarg, "gzip") == 0) {
+                    args.serverOptions.audit.compress = true;
+                } else if (strcmp(optarg, "none") == 0) {
+                    args.serverOptions.audit.compress = false;
+                } else {
+                    std::cerr << "未知的审计日志压缩方式: " << optarg << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                break;
             default:
                 std::cerr << "用法: " << argv[0] << std::endl;
                 std::cerr << "  -p <port>        指定服务器监听端口 (默认: 8443)" << std::endl;
                 std::cerr << "  -d               以守护进程模式运行" << std::endl;
                 std::cerr << "  -m <servercert>  指定服务器证书文件路径" << std::endl;
                 std::cerr << "  -n <serverkey>   指定服务器密钥文件路径" << std::endl;
-                std::cerr << "  -l <logfile>     指定日志文件路径" << std::endl;
+                std::cerr << "  -l <logfile>     审计日志文件路径，不存在时创建，追加写入 (默认: rpc_server.log)" << std::endl;
                 std::cerr << "  -v               启用详细日志输出" << std::endl;
+                std::cerr << "  --early-data     启用TLS 1.3 0-RTT早期数据（仅限可重放方法）" << std::endl;
+                std::cerr << "  --replay-window <sec>  会话票据可用于早期数据的时间窗口 (默认: 600)" << std::endl;
+                std::cerr << "  --unix-socket <path>   额外监听Unix域套接字（明文，按对端uid鉴权）" << std::endl;
+                std::cerr << "  --trusted-uid <uid>    允许接入Unix域套接字的uid，可重复指定" << std::endl;
+                std::cerr << "  --plain-port <port>    额外监听127.0.0.1上的明文HTTP端口" << std::endl;
+                std::cerr << "  --admin-port <port>    127.0.0.1上的管理端口，GET /metrics导出各方法的调用计数、延迟直方图与各阶段耗时" << std::endl;
+                std::cerr << "  --debug-trace    带X-Rpc-Trace请求头的HTTP请求以Server-Timing响应头返回各阶段耗时" << std::endl;
+                std::cerr << "  --lean-idle      空闲连接释放TLS与HTTP缓冲区，适合大量长连接" << std::endl;
+                std::cerr << "  --h2-port <port>       额外监听HTTP/2端口（TLS+ALPN，单连接多路复用）" << std::endl;
+                std::cerr << "  --backend <name>       传输后端: libevent (默认) 或 io_uring" << std::endl;
+                std::cerr << "  --http-engine <name>   HTTP/1.1引擎: native (默认) 或 evhttp (兼容模式)" << std::endl;
+                std::cerr << "  --keepalive-requests <n>  单个keep-alive连接最多处理的请求数 (默认: 1000，0为不限)" << std::endl;
+                std::cerr << "  --keepalive-timeout <sec> 空闲连接超时 (默认: 60，0为不超时)" << std::endl;
+                std::cerr << "  --handshake-timeout <sec> 接受连接后TLS握手须在此时间内完成 (默认: 10)" << std::endl;
+                std::cerr << "  --header-timeout <sec>    请求首字节到请求头收齐的期限，不因陆续到达的字节延后 (默认: 10)" << std::endl;
+                std::cerr << "  --body-timeout <sec>      请求头收齐到请求体收齐的期限 (默认: 30)" << std::endl;
+                std::cerr << "  --write-timeout <sec>     有响应待发送而对端持续不读取时关闭连接 (默认: 30)" << std::endl;
+                std::cerr << "  --max-connections <n>  原生引擎与HTTP/2同时保持的连接数上限，达到后暂停accept (默认: 0，不限)" << std::endl;
+                std::cerr << "  --compress             按Accept-Encoding以gzip/zstd压缩响应体" << std::endl;
+                std::cerr << "  --compress-min-size <bytes>  小于此长度的响应不压缩 (默认: 1024)" << std::endl;
+                std::cerr << "  --max-decompressed-size <bytes>  gzip/zstd请求体解压后的长度上限 (默认: 8388608)" << std::endl;
+                std::cerr << "  --max-header-size [listener=]<bytes>  请求头长度上限，listener为tls|unix|plain|h2|bin|bin-unix (默认: 8192)" << std::endl;
+                std::cerr << "  --max-body-size [listener=]<bytes>    请求体长度上限，可重复指定 (默认: 4194304)" << std::endl;
+                std::cerr << "  --binary-port <port>   额外监听二进制帧协议端口（TLS，供内部调用方）" << std::endl;
+                std::cerr << "  --binary-socket <path> 额外在Unix域套接字上监听二进制帧协议" << std::endl;
+                std::cerr << "  --websocket            HTTP/1.1监听接受WebSocket升级，长连接上可连续发出多个调用而不必等待响应" << std::endl;
+                std::cerr << "  --ws-deflate           同--websocket，并协商permessage-deflate消息压缩" << std::endl;
+                std::cerr << "  --audit-format <fmt>   审计日志格式: json (默认) 或 binary（<logfile>.<序号>段文件）" << std::endl;
+                std::cerr << "  --audit-segment-size <bytes>  二进制审计日志每段预分配的大小 (默认: 67108864)" << std::endl;
+                std::cerr << "  --audit-sample <N>     成功的调用每N次记录一次审计日志，出错的调用总是记录 (默认: 1)" << std::endl;
+                std::cerr << "  --audit-client-rate <n>  每个客户端地址每秒最多记录n条审计日志，0为不限 (默认: 0)" << std::endl;
+                std::cerr << "  --audit-rotate-size <bytes>  JSON审计日志超过此大小时轮转为<logfile>.<序号>，0为不轮转 (默认: 0)" << std::endl;
+                std::cerr << "  --audit-rotate-interval <sec>  审计日志文件或段写入超过此时长时轮转，0为不轮转 (默认: 0)" << std::endl;
+                std::cerr << "  --audit-compress <method>  轮转出的审计日志: gzip (默认，后台压缩) 或 none" << std::endl;
+                std::cerr << "  收到SIGHUP时重新打开审计日志（JSON格式重新打开原路径，二进制格式换段）" << std::endl;
                 exit(EXIT_FAILURE);
         }
     }
@@ -144,6 +477,10 @@ bool verifyCertificateAndKeyMatch(const char* serverCertPath, const char* server
     return match;
 }
 
+static void onHangup(int) {
+    AuditLogger::requestReopen();
+}
+
 int main(int argc, char* argv[]) {
     Arguments args;
 
@@ -159,6 +496,26 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // 对端在流水线响应发完之前断开时，写入已关闭的套接字会触发SIGPIPE而终止进程；
+    // 忽略后写入以EPIPE失败，由各连接按错误关闭
+    signal(SIGPIPE, SIG_IGN);
+
+    // SIGHUP：外部轮转（如logrotate）改名后通知重新打开审计日志，由审计日志的后台线程处理
+    struct sigaction hangup;
+    memset(&hangup, 0, sizeof(hangup));
+    hangup.sa_handler = onHangup;
+    hangup.sa_flags = SA_RESTART;
+    sigaction(SIGHUP, &hangup, nullptr);
+
+    // 省内存模式面向大量长连接，把文件描述符软限制提升到硬限制
+    if (args.serverOptions.leanIdle) {
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
     // 验证服务器证书和私钥匹配性
     if (!verifyCertificateAndKeyMatch(args.serverCertPath.c_str(), args.serverKeyPath.c_str())) {
         return EXIT_FAILURE;
@@ -170,7 +527,9 @@ int main(int argc, char* argv[]) {
         container.registerService<MathService>("MathService");
 
         // 启动RPC服务器
-        RpcServer server(args.port, args.serverCertPath.c_str(), args.serverKeyPath.c_str());
+        args.serverOptions.audit.path = args.logFilePath;
+        RpcServer server(args.port, args.serverCertPath.c_str(), args.serverKeyPath.c_str(),
+                         args.serverOptions);
         std::cout << "服务已启动，监听端口: " << args.port
                   << (args.daemon ? " (守护进程模式)" : "") << std::endl;
 
@@ -1,7 +1,51 @@
 // src/services/math_service.cpp
 #include "services/math_service.h"
+#include <stdexcept>
+
+namespace {
+
+// range方法单次最多产生的元素数，分块发送时约10MB；不能分块发送的传输另受积压上限约束
+const long long kMaxRangeCount = 1000000;
+
+// 等差数列start, start+step, ...共count项，逐项产生而不在内存中展开
+class RangeStream : public ResultStream {
+public:
+    explicit RangeStream(const nlohmann::json& params) : index_(0) {
+        if (!params.contains("start") || !params.contains("count")) {
+            throw std::invalid_argument("Missing parameters");
+        }
+        start_ = params["start"].get<double>();
+        step_ = params.contains("step") ? params["step"].get<double>() : 1.0;
+        count_ = params["count"].get<long long>();
+        if (count_ < 0 || count_ > kMaxRangeCount) {
+            throw std::invalid_argument("count out of range");
+        }
+    }
+
+    bool next(nlohmann::json& element) {
+        if (index_ == count_) {
+            return false;
+        }
+        element = start_ + step_ * index_++;
+        return true;
+    }
+
+private:
+    double start_;
+    double step_;
+    long long count_;
+    long long index_;
+};
+
+} // namespace
 
 MathService::MathService() {
+    // 纯计算方法没有副作用，可以安全地在0-RTT早期数据中执行
+    MethodOptions replaySafe;
+    replaySafe.replaySafe = true;
+    // 两个操作数的请求不会超过几百字节，经/rpc/MathService/<method>调用时按4KB拒绝超大请求
+    replaySafe.maxBodySize = 4096;
+
 #if CPP11_SUPPORTED
     // 使用 lambda 表达式
     registerMethod("add", [this](const nlohmann::json& params) {
@@ -9,18 +53,24 @@ MathService::MathService() {
             return nlohmann::json{{"error", "Missing parameters"}};
         }
         return nlohmann::json{{"result", add(params["a"], params["b"])}};
-    });
+    }, replaySafe);
 
     registerMethod("subtract", [this](const nlohmann::json& params) {
         if (!params.contains("a") || !params.contains("b")) {
             return nlohmann::json{{"error", "Missing parameters"}};
         }
         return nlohmann::json{{"result", subtract(params["a"], params["b"])}};
-    });
+    }, replaySafe);
+
+    // 结果可达百万项，以流式方法注册：HTTP/1.1下边生成边以分块编码发送
+    registerStreamMethod("range", [](const nlohmann::json& params) {
+        return std::unique_ptr<ResultStream>(new RangeStream(params));
+    }, replaySafe);
 #else
     // 使用静态成员函数
-    registerMethod("add", &MathService::addHandler, this);
-    registerMethod("subtract", &MathService::subtractHandler, this);
+    registerMethod("add", &MathService::addHandler, this, replaySafe);
+    registerMethod("subtract", &MathService::subtractHandler, this, replaySafe);
+    registerStreamMethod("range", &MathService::rangeHandler, this, replaySafe);
 #endif
 }
 
@@ -51,4 +101,10 @@ nlohmann::json MathService::subtractHandler(void* context, const nlohmann::json&
     }
     return nlohmann::json{{"result", self->subtract(params["a"], params["b"])}};
 }
-#endif
\ No newline at end of file
+
+// 处理 range 方法的静态函数
+ResultStream* MathService::rangeHandler(void* context, const nlohmann::json& params) {
+    (void)context;
+    return new RangeStream(params);
+}
+#endif
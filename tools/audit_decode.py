@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+# audit_decode.py
+# 把二进制审计日志（--audit-format binary）的段文件离线解码为JSON行，
+# 输出与--audit-format json写出的日志逐行相同，段格式见include/framework/audit_segment.h
+#
+# 用法:
+#   ./tools/audit_decode.py rpc_server.log.000001 > audit.jsonl
+#   ./tools/audit_decode.py rpc_server.log.*          # 按段序号排序后依次解码，正在写入的段解码到已提交的位置
+#   ./tools/audit_decode.py rpc_server.log.000003.gz  # 轮转后压缩过的段直接解码
+#   ./tools/audit_decode.py --ms rpc_server.log.*     # timestamp保留毫秒
+import argparse
+import gzip
+import socket
+import struct
+import sys
+
+HEADER = struct.Struct("<8sHHIQQQ24x")   # magic, version, headerSize, reserved, sequence, createdMs, usedBytes
+METHOD = struct.Struct("<BBH")           # type, nameLength, methodId，随后是方法名，补齐到8字节
+CALL = struct.Struct("<BBHHHQII16s")     # type, family, port, methodId, flags, timestampMs, latencyUs, reserved, address
+COUNT = struct.Struct("<B7xQQ")          # type, count, timestampMs
+MAGIC, VERSION = b"RPCAUDIT", 1
+ENTRY_METHOD, ENTRY_CALL, ENTRY_DROPPED, ENTRY_RATE_LIMITED = 1, 2, 3, 4
+CALL_ERROR = 1
+COUNT_NAMES = {ENTRY_DROPPED: "dropped", ENTRY_RATE_LIMITED: "rateLimited"}
+
+
+def json_string(raw):
+    # 与服务端相同的转义：引号与反斜杠加反斜杠，控制字符与非ASCII字节写作\u00XX
+    out = []
+    for b in raw:
+        c = chr(b)
+        if c in '"\\':
+            out.append("\\" + c)
+        elif b < 0x20 or b >= 0x7f:
+            out.append("\\u%04x" % b)
+        else:
+            out.append(c)
+    return '"' + "".join(out) + '"'
+
+
+def client_address(family, address):
+    if family == 4:
+        return socket.inet_ntop(socket.AF_INET, address[:4])
+    if family == 6:
+        return socket.inet_ntop(socket.AF_INET6, address)
+    return "unknown"
+
+
+def read_segment(path):
+    with (gzip.open if path.endswith(".gz") else open)(path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        raise ValueError("%s: too short for a segment header" % path)
+    magic, version, header_size, _, sequence, _, used = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("%s: not an audit segment (magic %r, version %d)" % (path, magic, version))
+    return sequence, data[header_size:min(used, len(data))]
+
+
+def decode(path, body, out, millis):
+    methods = {}
+    offset = 0
+    while offset < len(body):
+        kind = body[offset]
+        if kind == ENTRY_METHOD and offset + METHOD.size <= len(body):
+            _, length, method_id = METHOD.unpack_from(body, offset)
+            start = offset + METHOD.size
+            methods[method_id] = body[start:start + length]
+            offset += (METHOD.size + length + 7) & ~7
+        elif kind == ENTRY_CALL and offset + CALL.size <= len(body):
+            _, family, port, method_id, flags, ts, latency, _, address = CALL.unpack_from(body, offset)
+            timestamp = ts / 1000.0 if millis else ts // 1000
+            out.write('{"client":"%s"%s,"latencyUs":%d,"method":%s,"port":%d,"timestamp":%s}\n' % (
+                client_address(family, address), ',"error":true' if flags & CALL_ERROR else "", latency,
+                json_string(methods.get(method_id, b"")), port, timestamp))
+            offset += CALL.size
+        elif kind in COUNT_NAMES and offset + COUNT.size <= len(body):
+            _, count, ts = COUNT.unpack_from(body, offset)
+            out.write('{"%s":%d,"timestamp":%s}\n' % (
+                COUNT_NAMES[kind], count, ts / 1000.0 if millis else ts // 1000))
+            offset += COUNT.size
+        else:
+            sys.stderr.write("%s: bad entry type %d at offset %d, rest of segment skipped\n" % (path, kind, offset))
+            return
+
+
+def main():
+    parser = argparse.ArgumentParser(description="decode binary audit log segments into JSON lines")
+    parser.add_argument("segments", nargs="+", help="段文件，可为多个")
+    parser.add_argument("--ms", action="store_true", help="timestamp以带小数的秒输出，保留毫秒")
+    args = parser.parse_args()
+
+    segments = {}
+    for path in args.segments:
+        if path.endswith(".tmp"):
+            continue  # 正在压缩的中间文件，原文件仍在
+        try:
+            sequence, body = read_segment(path)
+        except (OSError, ValueError) as e:
+            sys.stderr.write("%s\n" % e)
+            return 1
+        # 压缩完成到删除原文件之间同一个段有两份，只解码一次
+        segments.setdefault(sequence, (path, body))
+    for sequence in sorted(segments):
+        path, body = segments[sequence]
+        decode(path, body, sys.stdout, args.ms)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+# backend_bench.py
+# 对比libevent与io_uring两种传输后端（及libevent下的两种HTTP引擎）在大量并发连接下的表现
+# 依次以各后端启动rpc_server，建立N个keep-alive连接循环发送请求，
+# 统计吞吐以及服务进程每请求消耗的CPU时间（用户态+内核态，来自/proc/<pid>/stat），
+# 后者不受压测客户端自身性能的影响
+#
+# 用法（需以 make LIBURING=1 构建）:
+#   ./tools/backend_bench.py -c 1000 -d 10
+#   ./tools/backend_bench.py -c 2000 --plain        # 走明文回环端口，排除TLS开销
+#   ./tools/backend_bench.py --backends libevent --http-engines native,evhttp
+import argparse
+import asyncio
+import os
+import resource
+import ssl
+import subprocess
+import time
+
+REQUEST_BODY = b'{"jsonrpc":"2.0","method":"MathService.add","params":{"a":1,"b":2}}'
+REQUEST = (b"POST /api HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\n"
+           b"Content-Length: " + str(len(REQUEST_BODY)).encode() + b"\r\n\r\n" + REQUEST_BODY)
+
+
+def cpu_seconds(pid):
+    # /proc/<pid>/stat 第14、15列为utime、stime（时钟滴答）
+    with open("/proc/%d/stat" % pid) as f:
+        fields = f.read().rsplit(")", 1)[1].split()
+    return (int(fields[11]) + int(fields[12])) / os.sysconf("SC_CLK_TCK")
+
+
+async def read_response(reader):
+    head = await reader.readuntil(b"\r\n\r\n")
+    length = 0
+    for line in head.split(b"\r\n"):
+        if line.lower().startswith(b"content-length:"):
+            length = int(line.split(b":", 1)[1])
+    await reader.readexactly(length)
+
+
+async def client(args, context, ready, start, stop, counter):
+    reader, writer = await asyncio.open_connection(args.host, args.port, ssl=context)
+    writer.write(REQUEST)
+    await read_response(reader)  # 预热：完成握手与首个请求
+    ready.append(1)
+    await start.wait()
+    while not stop.is_set():
+        writer.write(REQUEST)
+        await read_response(reader)
+        counter[0] += 1
+    writer.close()
+
+
+async def run_load(args, pid):
+    context = None
+    if not args.plain:
+        context = ssl.create_default_context()
+        context.check_hostname = False
+        context.verify_mode = ssl.CERT_NONE
+
+    ready, counter = [], [0]
+    start, stop = asyncio.Event(), asyncio.Event()
+    tasks = [asyncio.ensure_future(client(args, context, ready, start, stop, counter))
+             for _ in range(args.connections)]
+    while len(ready) < args.connections:
+        await asyncio.sleep(0.05)
+        if any(t.done() and t.exception() for t in tasks):
+            raise next(t.exception() for t in tasks if t.done() and t.exception())
+
+    cpu0, t0 = cpu_seconds(pid), time.time()
+    start.set()
+    await asyncio.sleep(args.duration)
+    stop.set()
+    requests, elapsed, cpu = counter[0], time.time() - t0, cpu_seconds(pid) - cpu0
+    await asyncio.gather(*tasks, return_exceptions=True)
+    return requests, elapsed, cpu
+
+
+def bench(args, backend, engine):
+    port_args = ["-p", str(args.tls_port), "--plain-port", str(args.plain_port)]
+    label = backend
+    if engine:
+        port_args += ["--http-engine", engine]
+        label = "%s/%s" % (backend, engine)
+    server = subprocess.Popen([args.binary, "--backend", backend, "-m", args.cert, "-n", args.key] + port_args,
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    try:
+        time.sleep(0.5)
+        if server.poll() is not None:
+            print("%-16s  server failed to start (not compiled in?)" % label)
+            return
+        requests, elapsed, cpu = asyncio.run(run_load(args, server.pid))
+        print("%-16s  %6d conns  %9.0f req/s  %7.2f us CPU/req" %
+              (label, args.connections, requests / elapsed, cpu / max(requests, 1) * 1e6))
+    finally:
+        server.terminate()
+        server.wait()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="compare rpc_server transport backends")
+    parser.add_argument("--binary", default="./rpc_server")
+    parser.add_argument("--cert", default="cert/server.crt")
+    parser.add_argument("--key", default="cert/server.key")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--tls-port", type=int, default=18443)
+    parser.add_argument("--plain-port", type=int, default=18080)
+    parser.add_argument("-c", "--connections", type=int, default=1000)
+    parser.add_argument("-d", "--duration", type=float, default=10.0)
+    parser.add_argument("--plain", action="store_true", help="压测明文回环端口")
+    parser.add_argument("--backends", default="libevent,io_uring")
+    parser.add_argument("--http-engines", default="native",
+                        help="libevent后端依次使用的HTTP引擎，如native,evhttp")
+    args = parser.parse_args()
+    args.port = args.plain_port if args.plain else args.tls_port
+
+    soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    if soft < args.connections + 64:
+        resource.setrlimit(resource.RLIMIT_NOFILE, (min(args.connections + 64, hard), hard))
+
+    for backend in args.backends.split(","):
+        if backend != "libevent":
+            bench(args, backend, None)
+            continue
+        for engine in args.http_engines.split(","):
+            bench(args, backend, engine)
+
+
+if __name__ == "__main__":
+    main()
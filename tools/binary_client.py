@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+# binary_client.py
+# 二进制帧协议（--binary-port / --binary-socket）的参考客户端与压测工具，帧格式见include/framework/binary_connection.h
+#
+# 用法:
+#   ./tools/binary_client.py call MathService.add '{"a":1,"b":2}'
+#   ./tools/binary_client.py call MathService.add '{"a":1,"b":2}' --unix /tmp/rpc.bin.sock
+#   ./tools/binary_client.py bench --pid $(pgrep -x rpc_server) -c 8 --depth 32
+#   ./tools/binary_client.py bench --protocol http --port 18080 --plain --pid ...   # 同一客户端压测HTTP端口作对照
+import argparse
+import asyncio
+import json
+import os
+import ssl
+import struct
+import sys
+import time
+
+REQUEST_HEADER = struct.Struct("!BBBBIII")   # magic, version, encoding, accept, requestId, methodId, bodyLength
+RESPONSE_HEADER = struct.Struct("!BBBBII")   # magic, version, encoding, status, requestId, bodyLength
+MAGIC, VERSION = ord("R"), 1
+STATUS_NAMES = {0: "OK", 1: "METHOD_NOT_FOUND", 2: "TOO_LARGE", 3: "UNSUPPORTED_ENCODING", 4: "PROTOCOL_ERROR"}
+
+
+def method_id(name):
+    # 32位FNV-1a，与binaryMethodId()一致
+    h = 2166136261
+    for b in name.encode():
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def encode_request(request_id, method, params, route_by_id=True):
+    body = {"jsonrpc": "2.0", "params": params}
+    if not route_by_id:
+        body["method"] = method
+    payload = json.dumps(body, separators=(",", ":")).encode()
+    mid = method_id(method) if route_by_id else 0
+    return REQUEST_HEADER.pack(MAGIC, VERSION, 0, 0, request_id, mid, len(payload)) + payload
+
+
+async def read_response(reader):
+    magic, version, encoding, status, request_id, length = RESPONSE_HEADER.unpack(
+        await reader.readexactly(RESPONSE_HEADER.size))
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("bad response header")
+    return request_id, status, encoding, await reader.readexactly(length)
+
+
+async def open_connection(args):
+    if args.unix:
+        return await asyncio.open_unix_connection(args.unix)
+    context = None
+    if not args.plain:
+        context = ssl.create_default_context()
+        context.check_hostname = False
+        context.verify_mode = ssl.CERT_NONE
+    return await asyncio.open_connection(args.host, args.port, ssl=context)
+
+
+async def call(args):
+    reader, writer = await open_connection(args)
+    writer.write(encode_request(1, args.method, json.loads(args.params), not args.route_by_body))
+    request_id, status, encoding, body = await read_response(reader)
+    print("request %d: %s (encoding %d) %s" % (request_id, STATUS_NAMES.get(status, status), encoding,
+                                               body.decode(errors="replace")))
+    writer.close()
+
+
+def cpu_seconds(pid):
+    with open("/proc/%d/stat" % pid) as f:
+        fields = f.read().rsplit(")", 1)[1].split()
+    return (int(fields[11]) + int(fields[12])) / os.sysconf("SC_CLK_TCK")
+
+
+HTTP_BODY = b'{"jsonrpc":"2.0","method":"MathService.add","params":{"a":1,"b":2}}'
+HTTP_REQUEST = (b"POST /api HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\n"
+                b"Content-Length: " + str(len(HTTP_BODY)).encode() + b"\r\n\r\n" + HTTP_BODY)
+
+
+async def read_http_response(reader):
+    head = await reader.readuntil(b"\r\n\r\n")
+    length = 0
+    for line in head.split(b"\r\n"):
+        if line.lower().startswith(b"content-length:"):
+            length = int(line.split(b":", 1)[1])
+    await reader.readexactly(length)
+
+
+async def bench_client(args, stop, counter):
+    # 每个连接保持depth个未完成的请求：收到一个响应即补发一个
+    reader, writer = await open_connection(args)
+    binary = args.protocol == "binary"
+    frames = [encode_request(i, "MathService.add", {"a": 1, "b": 2}) for i in range(args.depth)]
+    writer.write(b"".join(frames) if binary else HTTP_REQUEST * args.depth)
+    while not stop.is_set():
+        if binary:
+            request_id, _, _, _ = await read_response(reader)
+            writer.write(frames[request_id])
+        else:
+            await read_http_response(reader)
+            writer.write(HTTP_REQUEST)
+        counter[0] += 1
+    writer.close()
+
+
+async def bench(args):
+    stop, counter = asyncio.Event(), [0]
+    tasks = [asyncio.ensure_future(bench_client(args, stop, counter)) for _ in range(args.connections)]
+    await asyncio.sleep(0.5)  # 预热：握手与首批请求
+    cpu0 = cpu_seconds(args.pid) if args.pid else 0
+    requests0, t0 = counter[0], time.time()
+    await asyncio.sleep(args.duration)
+    requests, elapsed = counter[0] - requests0, time.time() - t0
+    cpu = cpu_seconds(args.pid) - cpu0 if args.pid else 0
+    stop.set()
+    await asyncio.gather(*tasks, return_exceptions=True)
+    line = "%-7s %4d conns x %3d deep  %9.0f req/s" % (args.protocol, args.connections, args.depth,
+                                                       requests / elapsed)
+    if args.pid:
+        line += "  %7.2f us server CPU/req" % (cpu / max(requests, 1) * 1e6)
+    print(line)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="binary frame protocol client for rpc_server")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=18445)
+    parser.add_argument("--unix", help="连接Unix域套接字而非TCP")
+    parser.add_argument("--plain", action="store_true", help="不使用TLS（仅用于压测HTTP明文端口）")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("call", help="发送单个请求")
+    p.add_argument("method", help="Service.method")
+    p.add_argument("params", help="JSON参数")
+    p.add_argument("--route-by-body", action="store_true", help="methodId置0，由请求体中的method路由")
+
+    p = sub.add_parser("bench", help="流水线压测，--pid给出服务进程时统计其每请求CPU时间")
+    p.add_argument("--protocol", choices=["binary", "http"], default="binary")
+    p.add_argument("--pid", type=int)
+    p.add_argument("-c", "--connections", type=int, default=8)
+    p.add_argument("--depth", type=int, default=32, help="每连接未完成的请求数")
+    p.add_argument("-d", "--duration", type=float, default=5.0)
+
+    args = parser.parse_args()
+    asyncio.run(call(args) if args.command == "call" else bench(args))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# idle_conn_mem.py
+# 测量rpc_server每个空闲keep-alive连接占用的内存
+# 建立N个TLS连接，每个连接完成一次请求后保持空闲，对比服务进程RSS的增量
+#
+# 用法:
+#   ./tools/idle_conn_mem.py --pid $(pidof rpc_server) -n 2000
+#   先以默认参数启动服务测一次，再加 --lean-idle 启动测一次，对比两次的 bytes/conn
+import argparse
+import resource
+import socket
+import ssl
+import time
+
+REQUEST_BODY = b'{"jsonrpc":"2.0","method":"MathService.add","params":{"a":1,"b":2}}'
+
+
+def read_rss(pid):
+    # 返回进程的常驻内存（字节）
+    with open("/proc/%d/status" % pid) as f:
+        for line in f:
+            if line.startswith("VmRSS:"):
+                return int(line.split()[1]) * 1024
+    raise RuntimeError("VmRSS not found")
+
+
+def raise_fd_limit(need):
+    soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    if soft < need:
+        resource.setrlimit(resource.RLIMIT_NOFILE, (min(need, hard), hard))
+
+
+def open_idle_connection(args, context):
+    raw = socket.create_connection((args.host, args.port))
+    if args.plain:
+        conn = raw
+    else:
+        conn = context.wrap_socket(raw, server_hostname=args.host)
+    request = (b"POST /api HTTP/1.1\r\nHost: " + args.host.encode() +
+               b"\r\nContent-Type: application/json\r\nContent-Length: " +
+               str(len(REQUEST_BODY)).encode() + b"\r\n\r\n" + REQUEST_BODY)
+    conn.sendall(request)
+    # 读到完整响应后连接进入空闲状态
+    data = b""
+    while b"}}" not in data:
+        chunk = conn.recv(4096)
+        if not chunk:
+            raise RuntimeError("connection closed by server")
+        data += chunk
+    return conn
+
+
+def main():
+    parser = argparse.ArgumentParser(description="measure rpc_server memory per idle connection")
+    parser.add_argument("--pid", type=int, required=True, help="rpc_server进程号")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("-n", "--connections", type=int, default=1000)
+    parser.add_argument("--plain", action="store_true", help="连接明文端口(--plain-port)")
+    parser.add_argument("--settle", type=float, default=1.0, help="测量前等待的秒数")
+    args = parser.parse_args()
+
+    raise_fd_limit(args.connections + 64)
+    context = ssl.create_default_context()
+    context.check_hostname = False
+    context.verify_mode = ssl.CERT_NONE
+
+    # 先建立一个连接预热，排除首个连接带来的一次性分配
+    warmup = open_idle_connection(args, context)
+    time.sleep(args.settle)
+    before = read_rss(args.pid)
+
+    conns = []
+    for _ in range(args.connections):
+        conns.append(open_idle_connection(args, context))
+    time.sleep(args.settle)
+    after = read_rss(args.pid)
+
+    delta = after - before
+    print("idle connections : %d" % args.connections)
+    print("server RSS before: %d bytes" % before)
+    print("server RSS after : %d bytes" % after)
+    print("bytes per conn   : %d" % (delta // args.connections))
+    print("100k conns (est.): %.1f MiB" % (delta / args.connections * 100000 / 1048576.0))
+
+    for conn in conns:
+        conn.close()
+    warmup.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+# slow_reader.py
+# 检查rpc_server对不读取响应的客户端的积压上限：持续流水线发送请求而从不读取，
+# 每秒采样服务进程RSS。积压受限时RSS保持平稳，对端停止发送后连接由写超时关闭
+#
+# 用法（服务以 --keepalive-requests 0 启动，否则HTTP连接在第1000个请求后即被关闭）:
+#   ./tools/slow_reader.py --pid $(pidof rpc_server) --port 8443
+#   ./tools/slow_reader.py --pid $(pidof rpc_server) --port 9443 --protocol binary
+#   ./tools/slow_reader.py --pid $(pidof rpc_server) --port 8443 --range 1000000 --batch 1   # 流式响应
+#   分别以默认参数与 --early-data（TlsStream过滤层）启动服务各测一次，两者的RSS增量都应很小
+import argparse
+import socket
+import ssl
+import struct
+import sys
+import time
+
+REQUEST_BODY = b'{"jsonrpc":"2.0","method":"MathService.add","params":{"a":1,"b":2}}'
+BINARY_HEADER = struct.Struct("!BBBBIII")  # 帧格式见include/framework/binary_connection.h
+
+
+def read_rss(pid):
+    # 返回进程的常驻内存（字节）
+    with open("/proc/%d/status" % pid) as f:
+        for line in f:
+            if line.startswith("VmRSS:"):
+                return int(line.split()[1]) * 1024
+    raise RuntimeError("VmRSS not found")
+
+
+def method_id(name):
+    # 32位FNV-1a，与binaryMethodId()一致
+    h = 2166136261
+    for b in name.encode():
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def request_batch(args):
+    if args.protocol == "binary":
+        body = b'{"jsonrpc":"2.0","params":{"a":1,"b":2}}'
+        return b"".join(BINARY_HEADER.pack(ord("R"), 1, 0, 0, i, method_id("MathService.add"), len(body)) + body
+                        for i in range(args.batch))
+    body = REQUEST_BODY
+    if args.range:
+        body = ('{"jsonrpc":"2.0","method":"MathService.range","params":{"start":0,"count":%d}}' % args.range).encode()
+    request = (b"POST /api HTTP/1.1\r\nHost: " + args.host.encode() +
+               b"\r\nContent-Type: application/json\r\nContent-Length: " +
+               str(len(body)).encode() + b"\r\n\r\n" + body)
+    return request * args.batch
+
+
+def main():
+    parser = argparse.ArgumentParser(description="check rpc_server memory against a client that never reads")
+    parser.add_argument("--pid", type=int, required=True, help="rpc_server进程号")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--protocol", choices=["http", "binary"], default="http")
+    parser.add_argument("--plain", action="store_true", help="连接明文端口(--plain-port)")
+    parser.add_argument("--batch", type=int, default=64, help="每次写出的请求数")
+    parser.add_argument("--range", type=int, default=0, help="改为调用流式方法MathService.range，count为此值（仅http）")
+    parser.add_argument("-d", "--duration", type=float, default=10.0, help="发送时长（秒）")
+    parser.add_argument("--max-growth", type=float, default=8.0, help="允许的RSS增量（MiB），超出时返回1")
+    args = parser.parse_args()
+
+    raw = socket.create_connection((args.host, args.port))
+    # 接收窗口较小，响应很快积压到服务端；过小（低于回环接口的MSS）时两端会陷入零窗口探测而停滞
+    raw.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 65536)
+    if args.plain:
+        conn = raw
+    else:
+        context = ssl.create_default_context()
+        context.check_hostname = False
+        context.verify_mode = ssl.CERT_NONE
+        conn = context.wrap_socket(raw, server_hostname=args.host)
+    conn.settimeout(0.2)
+
+    batch = request_batch(args)
+    before = read_rss(args.pid)
+    peak = before
+    sent = 0
+    closed = None
+    start = time.time()
+    next_sample = start + 1.0
+    while time.time() - start < args.duration:
+        try:
+            conn.sendall(batch)
+            sent += args.batch
+        except socket.timeout:
+            pass  # 服务端已暂停读取
+        except (ConnectionError, ssl.SSLError, OSError):
+            closed = time.time() - start
+            break
+        if time.time() >= next_sample:
+            rss = read_rss(args.pid)
+            peak = max(peak, rss)
+            print("%4.0fs  RSS %7.1f MiB  requests sent %d" % (time.time() - start, rss / 1048576.0, sent))
+            sys.stdout.flush()
+            next_sample += 1.0
+    conn.close()
+
+    growth = (peak - before) / 1048576.0
+    print("requests sent    : %d" % sent)
+    print("server RSS before: %.1f MiB" % (before / 1048576.0))
+    print("server RSS peak  : %.1f MiB (+%.1f)" % (peak / 1048576.0, growth))
+    print("connection       : %s" % ("closed by server after %.1fs" % closed if closed is not None else "still open"))
+    if closed is not None and closed < 1.0:
+        print("connection closed before the first sample, nothing measured")
+        return 2
+    return 1 if growth > args.max_growth else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+# ws_client.py
+# WebSocket会话（--websocket / --ws-deflate）的参考客户端，消息格式见include/framework/websocket.h
+#
+# 用法:
+#   ./tools/ws_client.py call MathService.add '{"a":1,"b":2}'
+#   ./tools/ws_client.py call MathService.add '{"a":1,"b":2}' -n 100 --deflate   # 同一连接上连续发出100个调用，再统一收取响应
+#   ./tools/ws_client.py call MathService.add '{"a":1,"b":2}' --binary           # 以二进制帧协议承载
+import argparse
+import base64
+import json
+import os
+import socket
+import ssl
+import struct
+import sys
+import zlib
+
+from binary_client import RESPONSE_HEADER, STATUS_NAMES, encode_request
+
+TEXT, BINARY, CLOSE, PING, PONG = 0x1, 0x2, 0x8, 0x9, 0xA
+
+
+class WebSocket:
+    def __init__(self, sock, deflate):
+        self.sock = sock
+        self.deflate = deflate
+        self.buffer = b""
+
+    def send(self, opcode, payload, compress=True):
+        first = 0x80 | opcode
+        if self.deflate and compress and opcode in (TEXT, BINARY):
+            # 不保留上下文：每条消息独立压缩，去掉同步刷新末尾的00 00 ff ff
+            c = zlib.compressobj(6, zlib.DEFLATED, -15)
+            payload = (c.compress(payload) + c.flush(zlib.Z_SYNC_FLUSH))[:-4]
+            first |= 0x40
+        mask = os.urandom(4)
+        n = len(payload)
+        if n < 126:
+            header = struct.pack("!BB", first, 0x80 | n)
+        elif n <= 0xFFFF:
+            header = struct.pack("!BBH", first, 0x80 | 126, n)
+        else:
+            header = struct.pack("!BBQ", first, 0x80 | 127, n)
+        masked = bytes(b ^ mask[i & 3] for i, b in enumerate(payload))
+        self.sock.sendall(header + mask + masked)
+
+    def _read(self, n):
+        while len(self.buffer) < n:
+            chunk = self.sock.recv(65536)
+            if not chunk:
+                raise EOFError("connection closed")
+            self.buffer += chunk
+        data, self.buffer = self.buffer[:n], self.buffer[n:]
+        return data
+
+    def recv(self):
+        """返回(opcode, payload)，压缩消息已解压"""
+        first, second = self._read(2)
+        n = second & 0x7F
+        if n == 126:
+            n = struct.unpack("!H", self._read(2))[0]
+        elif n == 127:
+            n = struct.unpack("!Q", self._read(8))[0]
+        payload = self._read(n)
+        if first & 0x40:
+            payload = zlib.decompressobj(-15).decompress(payload + b"\x00\x00\xff\xff")
+        return first & 0x0F, payload
+
+
+def connect(args):
+    sock = socket.create_connection((args.host, args.port))
+    if not args.plain:
+        context = ssl.create_default_context()
+        context.check_hostname = False
+        context.verify_mode = ssl.CERT_NONE
+        sock = context.wrap_socket(sock)
+    key = base64.b64encode(os.urandom(16)).decode()
+    request = ("GET %s HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+               "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n" % (args.path, args.host, key))
+    if args.deflate:
+        request += "Sec-WebSocket-Extensions: permessage-deflate; client_no_context_takeover\r\n"
+    sock.sendall((request + "\r\n").encode())
+
+    ws = WebSocket(sock, False)
+    head = b""
+    while b"\r\n\r\n" not in head:
+        chunk = sock.recv(4096)
+        if not chunk:
+            raise EOFError("connection closed during handshake")
+        head += chunk
+    head, ws.buffer = head.split(b"\r\n\r\n", 1)
+    lines = head.decode().split("\r\n")
+    if not lines[0].startswith("HTTP/1.1 101"):
+        raise RuntimeError("handshake rejected: " + lines[0])
+    ws.deflate = any(l.lower().startswith("sec-websocket-extensions:") and "permessage-deflate" in l
+                     for l in lines)
+    return ws
+
+
+def call(args):
+    ws = connect(args)
+    params = json.loads(args.params)
+    # 先连续发出全部调用，再按id/requestId收集响应
+    for i in range(1, args.count + 1):
+        if args.binary:
+            ws.send(BINARY, encode_request(i, args.method, params))
+        else:
+            ws.send(TEXT, json.dumps({"jsonrpc": "2.0", "method": args.method, "params": params,
+                                      "id": i}).encode())
+    results = {}
+    while len(results) < args.count:
+        opcode, payload = ws.recv()
+        if opcode == CLOSE:
+            raise RuntimeError("closed by server: %d" % struct.unpack("!H", payload[:2])[0])
+        if opcode == BINARY:
+            while payload:
+                _, _, encoding, status, request_id, n = RESPONSE_HEADER.unpack(payload[:RESPONSE_HEADER.size])
+                body = payload[RESPONSE_HEADER.size:RESPONSE_HEADER.size + n]
+                payload = payload[RESPONSE_HEADER.size + n:]
+                results[request_id] = "%s %s" % (STATUS_NAMES.get(status, status), body.decode(errors="replace"))
+        else:
+            response = json.loads(payload)
+            results[response["id"]] = json.dumps(response.get("result", response.get("error")))
+    for request_id in sorted(results):
+        print("%d: %s" % (request_id, results[request_id]))
+    ws.send(CLOSE, struct.pack("!H", 1000), compress=False)
+    ws.recv()
+    ws.sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="WebSocket client for rpc_server")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--path", default="/rpc")
+    parser.add_argument("--plain", action="store_true", help="不使用TLS（--plain-port）")
+    parser.add_argument("--deflate", action="store_true", help="提议permessage-deflate")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("call", help="在一个会话上发送调用")
+    p.add_argument("method", help="Service.method")
+    p.add_argument("params", help="JSON参数")
+    p.add_argument("-n", "--count", type=int, default=1, help="不等待响应连续发送的调用数")
+    p.add_argument("--binary", action="store_true", help="以二进制帧协议的请求帧作为二进制消息发送")
+
+    args = parser.parse_args()
+    call(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())